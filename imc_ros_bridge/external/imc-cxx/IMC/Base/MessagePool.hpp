@@ -0,0 +1,147 @@
+//***************************************************************************
+// Licensed under the Apache License, Version 2.0 (the "License");          *
+// you may not use this file except in compliance with the License.         *
+// You may obtain a copy of the License at                                  *
+//                                                                          *
+// http://www.apache.org/licenses/LICENSE-2.0                               *
+//                                                                          *
+// Unless required by applicable law or agreed to in writing, software      *
+// distributed under the License is distributed on an "AS IS" BASIS,        *
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+// See the License for the specific language governing permissions and      *
+// limitations under the License.                                           *
+//***************************************************************************
+
+#ifndef IMC_MESSAGE_POOL_HPP_INCLUDED_
+#define IMC_MESSAGE_POOL_HPP_INCLUDED_
+
+// ISO C++ 11 headers.
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// IMC Base headers.
+#include "Config.hpp"
+#include "Factory.hpp"
+#include "Message.hpp"
+
+namespace IMC
+{
+  //! Recycles message objects per message type.
+  //!
+  //! Released messages are cleared and kept for the next acquire() of the
+  //! same identifier, so their std::string and std::vector members keep
+  //! their capacity across uses. Messages may be released from any thread.
+  class MessagePool
+  {
+  public:
+    //! Returns a message to the pool it was acquired from.
+    class Releaser
+    {
+    public:
+      explicit Releaser(MessagePool* pool = 0):
+        m_pool(pool)
+      { }
+
+      void
+      operator()(Message* msg) const
+      {
+        if (m_pool)
+          m_pool->release(msg);
+        else
+          delete msg;
+      }
+
+    private:
+      MessagePool* m_pool;
+    };
+
+    //! Owning handle that gives the message back to the pool when destroyed.
+    typedef std::unique_ptr<Message, Releaser> Handle;
+
+    //! Constructor.
+    //! @param max_per_type maximum number of idle messages kept per type.
+    explicit MessagePool(size_t max_per_type = 8):
+      m_max_per_type(max_per_type)
+    { }
+
+    ~MessagePool(void)
+    {
+      for (size_t i = 0; i < m_free.size(); ++i)
+      {
+        for (size_t j = 0; j < m_free[i].size(); ++j)
+          delete m_free[i][j];
+      }
+    }
+
+    //! Get a message of a given type, reusing an idle one if available.
+    //! @param id message identification number.
+    //! @return message object or 0 if the identifier is unknown.
+    Message*
+    acquire(uint16_t id)
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (id < m_free.size() && !m_free[id].empty())
+        {
+          Message* msg = m_free[id].back();
+          m_free[id].pop_back();
+          return msg;
+        }
+      }
+
+      return Factory::produce(id);
+    }
+
+    //! Give a message back to the pool. The message is cleared; if the pool
+    //! already holds enough idle messages of this type it is deleted.
+    //! @param msg message object, may be 0.
+    void
+    release(Message* msg)
+    {
+      if (msg == 0)
+        return;
+
+      uint16_t id = msg->getId();
+      msg->clear();
+
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (id >= m_free.size())
+          m_free.resize(id + 1);
+
+        if (m_free[id].size() < m_max_per_type)
+        {
+          m_free[id].push_back(msg);
+          return;
+        }
+      }
+
+      delete msg;
+    }
+
+    //! Wrap a message acquired from this pool in an owning handle.
+    //! @param msg message object.
+    //! @return handle releasing the message to this pool.
+    Handle
+    wrap(Message* msg)
+    {
+      return Handle(msg, Releaser(this));
+    }
+
+  private:
+    //! Idle messages indexed by message identification number.
+    std::vector<std::vector<Message*> > m_free;
+    //! Maximum number of idle messages kept per type.
+    size_t m_max_per_type;
+    //! Protects m_free.
+    std::mutex m_mutex;
+
+    // Non-copyable.
+    MessagePool(const MessagePool&);
+    MessagePool& operator=(const MessagePool&);
+  };
+}
+
+#endif
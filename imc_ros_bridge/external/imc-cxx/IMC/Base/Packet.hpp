@@ -227,7 +227,8 @@ namespace IMC
         throw InvalidCrc();
 
       // Produce a message of the given type.
-      if (msg == NULL)
+      bool produced = (msg == NULL);
+      if (produced)
       {
         msg = Factory::produce(hdr.mgid);
         if (msg == 0)
@@ -249,7 +250,9 @@ namespace IMC
       }
       catch (...)
       {
-        delete msg;
+        // Messages supplied by the caller remain owned by the caller.
+        if (produced)
+          delete msg;
         throw;
       }
 
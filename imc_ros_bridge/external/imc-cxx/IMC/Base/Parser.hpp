@@ -28,6 +28,7 @@
 
 // IMC headers.
 #include "Message.hpp"
+#include "MessagePool.hpp"
 #include "Packet.hpp"
 
 namespace IMC
@@ -36,7 +37,12 @@ namespace IMC
   class Parser
   {
   public:
-    Parser()
+    //! Constructor.
+    //! @param pool pool to take message objects from, or 0 to allocate
+    //! every message from the heap. Messages returned by a parser with a
+    //! pool should be given back with MessagePool::release().
+    explicit Parser(MessagePool* pool = 0):
+      m_pool(pool)
     {
       reset();
     }
@@ -55,8 +61,114 @@ namespace IMC
     Message*
     parse(uint8_t byte)
     {
-      Message* m = 0;
       m_buf.push_back(byte);
+      return next();
+    }
+
+    //! Parse a block of data holding one or more packets, such as a
+    //! datagram. Packets that lie entirely inside the block are
+    //! deserialized in place; only a trailing partial packet is copied
+    //! to the internal buffer to be completed by subsequent calls.
+    //! @param data data block.
+    //! @param len data block length.
+    //! @param handler callable invoked with each parsed message. The
+    //! handler takes ownership of the message.
+    //! @return number of parsed messages.
+    template <typename Handler>
+    size_t
+    parse(const uint8_t* data, size_t len, Handler handler)
+    {
+      size_t count = 0;
+
+      // Finish a packet left over from a previous call first.
+      if (!m_buf.empty())
+      {
+        m_buf.insert(m_buf.end(), data, data + len);
+        while (Message* m = next())
+        {
+          handler(m);
+          ++count;
+        }
+        return count;
+      }
+
+      size_t pos = 0;
+      Header hdr;
+
+      while (len - pos >= 2)
+      {
+        uint16_t sync = (data[pos] << 8) | data[pos + 1];
+        if (sync != IMC_CONST_SYNC && sync != IMC_CONST_SYNC_REV)
+        {
+          ++pos;
+          continue;
+        }
+
+        size_t n = len - pos;
+        if (n < IMC_CONST_HEADER_SIZE)
+          break;
+
+        Packet::deserializeHeader(hdr, data + pos, n);
+        size_t total = hdr.size + IMC_CONST_HEADER_SIZE + IMC_CONST_FOOTER_SIZE;
+        if (n < total)
+          break;
+
+        Message* m = 0;
+        try
+        {
+          m = deserialize(hdr, data + pos, total);
+        }
+        catch (...)
+        {
+          ++pos; // try to find sync again from next position
+          continue;
+        }
+
+        pos += total;
+        handler(m);
+        ++count;
+      }
+
+      // Keep the incomplete tail for the stream parser.
+      if (pos < len)
+      {
+        m_buf.assign(data + pos, data + len);
+        m_pos = 0;
+        m_stage = PS_SYNC;
+      }
+
+      return count;
+    }
+
+  private:
+    //! Deserialize a complete packet, using the pool if there is one.
+    Message*
+    deserialize(const Header& hdr, const uint8_t* bfr, size_t bfr_len)
+    {
+      if (m_pool == 0)
+        return Packet::deserializePayload(hdr, bfr, bfr_len, 0);
+
+      Message* msg = m_pool->acquire(hdr.mgid);
+      if (msg == 0)
+        throw InvalidMessageId(hdr.mgid);
+
+      try
+      {
+        return Packet::deserializePayload(hdr, bfr, bfr_len, msg);
+      }
+      catch (...)
+      {
+        m_pool->release(msg);
+        throw;
+      }
+    }
+
+    //! Run the parser state machine over the internal buffer.
+    //! @return defined message or 0 if more data is needed.
+    Message*
+    next()
+    {
+      Message* m = 0;
 
       while (true)
       {
@@ -95,7 +207,8 @@ namespace IMC
         }
 
         // on to c_payload stage
-        if (n < (size_t)(m_header.size + IMC_CONST_HEADER_SIZE + IMC_CONST_FOOTER_SIZE))
+        size_t total = m_header.size + IMC_CONST_HEADER_SIZE + IMC_CONST_FOOTER_SIZE;
+        if (n < total)
           break;  // need more data
 
         // all payload data available
@@ -103,7 +216,7 @@ namespace IMC
 
         try
         {
-          m = Packet::deserializePayload(m_header, &m_buf[m_pos], n, 0);
+          m = deserialize(m_header, &m_buf[m_pos], n);
         }
         catch (...)
         {
@@ -111,7 +224,8 @@ namespace IMC
           continue;
         }
 
-        m_pos += n;
+        // Only consume this packet, the buffer may hold more.
+        m_pos += total;
 
         if (m_pos == m_buf.size())
           reset();  // discard unneeded data
@@ -122,7 +236,6 @@ namespace IMC
       return m;
     }
 
-  private:
     //! Parser stage constants.
     enum ParserStage
     {
@@ -139,6 +252,8 @@ namespace IMC
     unsigned int m_pos;
     //! Holds parsed header (c_payload stage).
     Header m_header;
+    //! Message pool, if any.
+    MessagePool* m_pool;
   };
 }
 
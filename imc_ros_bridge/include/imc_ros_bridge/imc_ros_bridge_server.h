@@ -34,24 +34,91 @@ private:
     ros::Subscriber ros_sub;
     //ros_imc_broker::TcpLink& tcp_client_;
     IMCHandle& imc_handle;
+    OutboundCounters& counters;
+
+    // Latest-value-wins coalescing, enabled by a ~coalesce/<topic> rate in
+    // Hz. Samples arriving faster than that replace the pending one and
+    // are converted only when actually sent.
+    ros::Duration period;
+    ros::Time last_send;
+    bool has_pending;
+    ROS_MSG pending;
+    ros::Timer flush_timer;
+
+    bool send(const ROS_MSG& ros_msg)
+    {
+        IMC_MSG imc_msg;
+        bool success = convert(ros_msg, imc_msg);
+        if (!success) {
+            ROS_WARN("There was an error trying to convert imc type %s", imc_msg.getName());
+            return true;
+        }
+        //tcp_client_.write(&imc_msg);
+        if (!imc_handle.write(imc_msg)) {
+            return false;
+        }
+        ++counters.sent;
+        return true;
+    }
+
+    void flush()
+    {
+        if (!has_pending) {
+            return;
+        }
+        last_send = ros::Time::now();
+        if (send(pending)) {
+            has_pending = false;
+        }
+        else {
+            // over budget, keep it and retry one period later
+            arm_flush_timer(period);
+        }
+    }
+
+    void arm_flush_timer(const ros::Duration& delay)
+    {
+        flush_timer.stop();
+        flush_timer.setPeriod(delay);
+        flush_timer.start();
+    }
 
 public:
 
-    BridgeServer(ros::NodeHandle& ros_node, IMCHandle& imc_handle, const std::string& ros_topic) : imc_handle(imc_handle)
+    BridgeServer(ros::NodeHandle& ros_node, IMCHandle& imc_handle, const std::string& ros_topic)
+        : imc_handle(imc_handle), counters(imc_handle.counters(ros_topic)), has_pending(false)
     {
+        double max_rate;
+        ros::param::param<double>("~coalesce/" + ros_topic, max_rate, 0.);
+        if (max_rate > 0.) {
+            period = ros::Duration(1. / max_rate);
+            flush_timer = ros_node.createTimer(period, [this](const ros::TimerEvent&) { flush(); },
+                                               true, false);
+        }
         ros_sub = ros_node.subscribe(ros_topic, 10, &BridgeServer::conversion_callback, this);
     }
 
     void conversion_callback(const ROS_MSG& ros_msg)
     {
-        IMC_MSG imc_msg;
-        bool success = convert(ros_msg, imc_msg);
-        if (success) {
-            //tcp_client_.write(&imc_msg);
-            imc_handle.write(imc_msg);
+        if (period.isZero()) {
+            if (!send(ros_msg)) {
+                ++counters.dropped;
+            }
+            return;
         }
-        else {
-            ROS_WARN("There was an error trying to convert imc type %s", imc_msg.getName());
+
+        if (has_pending) {
+            ++counters.coalesced;
+        }
+        pending = ros_msg;
+        has_pending = true;
+
+        ros::Duration since_last = ros::Time::now() - last_send;
+        if (since_last >= period) {
+            flush();
+        }
+        else if (!flush_timer.hasPending()) {
+            arm_flush_timer(period - since_last);
         }
     }
 
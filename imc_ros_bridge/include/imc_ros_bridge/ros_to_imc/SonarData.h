@@ -23,6 +23,34 @@ namespace ros_to_imc {
 template <>
 bool convert(const imc_ros_bridge::SonarData& ros_msg, IMC::SonarData& imc_msg);
 
+// Writes pings into the outbound packet without an intermediate
+// IMC::SonarData copy of the data. Optionally shrinks them first, set by
+// ~sonar/downsample (average this many points), ~sonar/bits_per_point
+// (quantize to at most this many bits), ~sonar/max_data_size (downsample
+// further until the data fits, 0 = no limit) and ~sonar/max_packet_size
+// (fragment larger packets, 0 = no limit).
+class SonarDataWriter {
+
+private:
+
+    int downsample;
+    int bits_per_point;
+    size_t max_data_size;
+    size_t max_packet_size;
+
+public:
+
+    SonarDataWriter();
+
+    // returns false if the bandwidth budget did not allow sending
+    bool write(IMCHandle& imc_handle, const imc_ros_bridge::SonarData& ros_msg) const;
+
+};
+
+// sonar pings skip convert() and go through SonarDataWriter
+template <>
+bool BridgeServer<imc_ros_bridge::SonarData, IMC::SonarData>::send(const imc_ros_bridge::SonarData& ros_msg);
+
 } // namespace ros_to_imc
 
 #endif // ROS_TO_IMC_SONARDATA_H
@@ -16,6 +16,23 @@
 
 //#include <imc_tcp_link/TcpLink.hpp>
 #include <imc_udp_link/udp_link.h>
+#include <imc_tcp_link/token_bucket.h>
+#include <imc_tcp_link/unhandled_message_logger.h>
+#include <IMC/Spec/Heartbeat.hpp>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+
+// what happened to the messages of one outbound topic
+struct OutboundCounters {
+    std::atomic<uint64_t> sent{0};
+    // superseded by a newer sample before they were sent
+    std::atomic<uint64_t> coalesced{0};
+    // refused by the bandwidth budget
+    std::atomic<uint64_t> dropped{0};
+};
 
 class IMCHandle {
 
@@ -28,20 +45,34 @@ private:
     std::string bridge_tcp_port;
     std::string neptus_addr;
 
+    typedef std::function<void(const IMC::Message*)> Callback;
+    // subscribers indexed directly by message id. The table is copied and
+    // swapped on subscribe so the receive thread reads it without locking.
+    typedef std::vector<std::vector<Callback> > DispatchTable;
+    std::shared_ptr<const DispatchTable> callbacks;
+    std::mutex subscribe_mutex;
+
+    UnhandledMessageLogger unhandled_logger;
+
+    // shared by every message sent through write()
+    TokenBucket bandwidth;
+    std::mutex counters_mutex;
+    std::map<std::string, OutboundCounters> outbound_counters;
+
+    // declared after the dispatch state, its receive thread uses it
     //ros_imc_broker::TcpLink* tcp_client_;
     //boost::thread* tcp_client_thread_;
     UDPLink udp_link;
 
-    // we might need multiple for every message in the future, let's start here
-    std::map<uint16_t, std::function<void(const IMC::Message*)> > callbacks;
-
     double lat;
 
 public:
 
     IMCHandle(const std::string& bridge_tcp_addr, const std::string& bridge_tcp_port,
               const std::string& neptus_addr,
-              const std::string& sys_name, int imc_id, int imc_src);
+              const std::string& sys_name, int imc_id, int imc_src,
+              size_t udp_batch_size = 0, double udp_flush_interval = 0.002,
+              size_t worker_threads = 0);
 
     ~IMCHandle();
 
@@ -49,16 +80,54 @@ public:
 
     void publish_heartbeat();
 
+    // log the inbound queueing delay per message type since the last report
+    void report_queue_latency();
+
     void tcp_subscribe(uint16_t uid, std::function<void(const IMC::Message*)> callback);
 
     void tcp_callback(const IMC::Message* msg);
 
+    // limit what write() may send, in bytes per second (0 = unlimited)
+    void set_bandwidth_limit(double bytes_per_second, double burst_bytes);
+
+    // counters of a bridged topic, created on first use
+    OutboundCounters& counters(const std::string& topic);
+
+    // log sent/coalesced/dropped counts of all topics
+    void report_outbound_stats();
+
+    // log the IMC traffic received by the bridge to an LSF file
+    bool record_to(const std::string& path) { return udp_link.record_to(path); }
+
+    // log the IMC traffic sent by the bridge to another LSF file
+    bool record_sent_to(const std::string& path) { return udp_link.record_sent_to(path); }
+
+    // heartbeats keep the link alive and are never refused by the budget
+    static bool is_budgeted(uint16_t id) { return id != IMC::Heartbeat::getIdStatic(); }
+
+    // returns false if the bandwidth budget did not allow sending
     template <typename IMC_MSG>
-    void write(IMC_MSG& imc_msg)
+    bool write(IMC_MSG& imc_msg)
     {
+        if (is_budgeted(imc_msg.getId()) && !bandwidth.consume(imc_msg.getSerializationSize())) {
+            return false;
+        }
         //tcp_client_.write(imc_msg);
         //tcp_client_->write(&imc_msg);
         udp_link.publish(imc_msg, neptus_addr);
+        return true;
+    }
+
+    // write() for a message whose trailing rawdata field is written in
+    // place by fill, see UDPLink::publish_tail
+    template <typename Fill>
+    bool write_tail(IMC::Message& imc_msg, size_t tail_size, Fill fill, size_t max_packet = 0)
+    {
+        if (!bandwidth.consume(imc_msg.getSerializationSize() + tail_size)) {
+            return false;
+        }
+        udp_link.publish_tail(imc_msg, tail_size, fill, neptus_addr, max_packet);
+        return true;
     }
 
 };
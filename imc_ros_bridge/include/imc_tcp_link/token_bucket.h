@@ -0,0 +1,65 @@
+/* Copyright 2019 The SMaRC project (https://smarc.se/)
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TOKEN_BUCKET_H
+#define TOKEN_BUCKET_H
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+
+// Byte budget shared by all outbound topics. The bucket refills at rate
+// bytes per second up to burst bytes. A message larger than the burst is
+// let through when the bucket is full and leaves it in debt, so large
+// messages are slowed down rather than blocked forever.
+class TokenBucket {
+
+public:
+
+    // a rate of 0 disables the limit
+    void configure(double rate, double burst)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rate_ = rate;
+        burst_ = std::max(burst, 0.);
+        tokens_ = burst_;
+        last_ = std::chrono::steady_clock::now();
+    }
+
+    bool consume(size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (rate_ <= 0.) {
+            return true;
+        }
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        tokens_ = std::min(burst_, tokens_ + rate_ * std::chrono::duration<double>(now - last_).count());
+        last_ = now;
+        if (tokens_ < bytes && tokens_ < burst_) {
+            return false;
+        }
+        tokens_ -= bytes;
+        return true;
+    }
+
+private:
+
+    std::mutex mutex_;
+    double rate_ = 0.;
+    double burst_ = 0.;
+    double tokens_ = 0.;
+    std::chrono::steady_clock::time_point last_;
+
+};
+
+#endif // TOKEN_BUCKET_H
@@ -0,0 +1,62 @@
+/* Copyright 2019 The SMaRC project (https://smarc.se/)
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef UNHANDLED_MESSAGE_LOGGER_H
+#define UNHANDLED_MESSAGE_LOGGER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <IMC/Base/Message.hpp>
+
+// Prints messages that have no subscriber from a background thread. Per
+// message id at most one message per interval is printed and the others
+// are only counted, so a flood of unknown messages cannot stall the
+// receive thread.
+class UnhandledMessageLogger {
+
+public:
+
+    UnhandledMessageLogger(double interval = 1.0, size_t max_queue = 16);
+
+    ~UnhandledMessageLogger();
+
+    // cheap unless the message is selected for printing, then it is cloned
+    void log(const IMC::Message* msg);
+
+private:
+
+    void run();
+
+    double interval_;
+    size_t max_queue_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    // indexed by message id
+    std::vector<double> last_logged_;
+    std::vector<uint32_t> suppressed_;
+    // cloned message and the number suppressed before it
+    std::deque<std::pair<std::unique_ptr<IMC::Message>, uint32_t> > queue_;
+    bool stop_;
+    std::thread thread_;
+
+};
+
+#endif // UNHANDLED_MESSAGE_LOGGER_H
@@ -0,0 +1,49 @@
+/* Copyright 2019 The SMaRC project (https://smarc.se/)
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef LSF_INDEX_H
+#define LSF_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// Where each packet of an LSF log is, see LsfRecorder
+struct LsfIndexEntry {
+    double time;
+    size_t offset;
+    uint32_t size;
+    uint16_t id;
+    uint16_t src;
+};
+
+struct LsfIndex {
+    // in file order
+    std::vector<LsfIndexEntry> entries;
+    // positions in entries per message id
+    std::map<uint16_t, std::vector<size_t> > by_type;
+    // bytes that were not part of a valid packet
+    size_t skipped = 0;
+};
+
+// Scans the whole log once. Corrupt bytes are skipped one at a time until
+// a packet with a valid header and CRC starts.
+LsfIndex build_lsf_index(const uint8_t* data, size_t size);
+
+// positions in index.entries of the packets with one of the ids (all if
+// empty) and the IMC source src (any if negative), sorted by time
+std::vector<size_t> select_packets(const LsfIndex& index, const std::vector<uint16_t>& ids, int src);
+
+#endif // LSF_INDEX_H
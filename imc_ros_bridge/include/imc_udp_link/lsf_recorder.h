@@ -0,0 +1,69 @@
+/* Copyright 2019 The SMaRC project (https://smarc.se/)
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LSF_RECORDER_H
+#define LSF_RECORDER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Appends IMC packets to an LSF log, i.e. serialized packets back to back
+// as DUNE and Neptus write them. record() only copies into a memory buffer
+// and a background thread writes it out in large chunks, so the send and
+// receive paths never wait for the disk.
+class LsfRecorder {
+
+public:
+
+    // chunk_size: bytes collected before a write. If more than max_buffered
+    // bytes are waiting the disk cannot keep up and packets are dropped.
+    LsfRecorder(const std::string& path, size_t chunk_size = 1 << 20,
+                size_t max_buffered = 64 << 20, double flush_interval = 1.0);
+
+    // writes everything recorded so far
+    ~LsfRecorder();
+
+    bool is_open() const { return file_.is_open(); }
+
+    void record(const uint8_t* data, size_t size);
+
+    // packets lost because the buffer was full
+    uint64_t dropped() const { return dropped_; }
+
+private:
+
+    void run();
+
+    std::ofstream file_;
+    size_t chunk_size_;
+    size_t max_buffered_;
+    // a partly filled chunk still goes out after this many seconds
+    double flush_interval_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    // appended to by record(), swapped with the writer's buffer
+    std::vector<uint8_t> filling_;
+    std::atomic<uint64_t> dropped_{0};
+    bool stop_;
+    std::thread thread_;
+
+};
+
+#endif // LSF_RECORDER_H
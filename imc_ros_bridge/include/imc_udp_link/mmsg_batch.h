@@ -0,0 +1,133 @@
+/* Copyright 2019 The SMaRC project (https://smarc.se/)
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MMSG_BATCH_H
+#define MMSG_BATCH_H
+
+// Thin wrappers around the Linux recvmmsg/sendmmsg calls, used by UDPLink
+// to move several datagrams per system call.
+#if defined(__linux__)
+#define IMC_UDP_HAVE_MMSG 1
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <cerrno>
+#include <cstdint>
+#include <vector>
+
+#include <boost/asio/ip/udp.hpp>
+
+// Receives up to batch_size datagrams with one recvmmsg call.
+class RecvBatch {
+
+public:
+
+    RecvBatch(size_t batch_size, size_t datagram_size = 65536)
+        : datagram_size_(datagram_size),
+          storage_(batch_size * datagram_size),
+          iov_(batch_size), msgs_(batch_size)
+    {
+        for (size_t i = 0; i < batch_size; ++i) {
+            iov_[i].iov_base = &storage_[i * datagram_size];
+            iov_[i].iov_len = datagram_size;
+        }
+    }
+
+    // non-blocking: returns the number of datagrams read, 0 if none were
+    // pending and -1 on error with errno set
+    int receive(int fd)
+    {
+        for (size_t i = 0; i < msgs_.size(); ++i) {
+            msgs_[i].msg_hdr = msghdr();
+            msgs_[i].msg_hdr.msg_iov = &iov_[i];
+            msgs_[i].msg_hdr.msg_iovlen = 1;
+            msgs_[i].msg_len = 0;
+        }
+        int n = recvmmsg(fd, msgs_.data(), msgs_.size(), MSG_DONTWAIT, nullptr);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return 0;
+        }
+        return n;
+    }
+
+    size_t capacity() const { return msgs_.size(); }
+
+    const uint8_t* data(int i) const { return &storage_[i * datagram_size_]; }
+
+    size_t size(int i) const { return msgs_[i].msg_len; }
+
+private:
+
+    size_t datagram_size_;
+    std::vector<uint8_t> storage_;
+    std::vector<iovec> iov_;
+    std::vector<mmsghdr> msgs_;
+
+};
+
+// Collects datagrams and sends them with as few sendmmsg calls as possible.
+// The payloads are not copied and must stay valid until flush() returns.
+class SendBatch {
+
+public:
+
+    void add(const void* data, size_t size, const boost::asio::ip::udp::endpoint& destination)
+    {
+        iovec iov;
+        iov.iov_base = const_cast<void*>(data);
+        iov.iov_len = size;
+        iov_.push_back(iov);
+        destinations_.push_back(destination);
+    }
+
+    size_t size() const { return iov_.size(); }
+
+    // returns the number of datagrams handed to the kernel, which is less
+    // than size() if a call failed (errno is then set); the batch is
+    // cleared in any case
+    size_t flush(int fd)
+    {
+        msgs_.resize(iov_.size());
+        for (size_t i = 0; i < iov_.size(); ++i) {
+            msgs_[i].msg_hdr = msghdr();
+            msgs_[i].msg_hdr.msg_name = destinations_[i].data();
+            msgs_[i].msg_hdr.msg_namelen = destinations_[i].size();
+            msgs_[i].msg_hdr.msg_iov = &iov_[i];
+            msgs_[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        size_t sent = 0;
+        while (sent < msgs_.size()) {
+            int n = sendmmsg(fd, &msgs_[sent], msgs_.size() - sent, 0);
+            if (n <= 0) {
+                break;
+            }
+            sent += n;
+        }
+
+        iov_.clear();
+        destinations_.clear();
+        return sent;
+    }
+
+private:
+
+    std::vector<iovec> iov_;
+    std::vector<boost::asio::ip::udp::endpoint> destinations_;
+    std::vector<mmsghdr> msgs_;
+
+};
+
+#endif // __linux__
+
+#endif // MMSG_BATCH_H
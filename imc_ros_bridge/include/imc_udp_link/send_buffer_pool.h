@@ -0,0 +1,165 @@
+/* Copyright 2019 The SMaRC project (https://smarc.se/)
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SEND_BUFFER_POOL_H
+#define SEND_BUFFER_POOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <IMC/Base/Message.hpp>
+#include <IMC/Base/Packet.hpp>
+
+// Recycled buffers for asynchronous sends. A buffer is taken when a message
+// is serialized and given back from the completion handler of the last
+// send that uses it, so it outlives the call that started the send.
+// Idle buffers keep their capacity, so steady-state sends of ordinary
+// messages do not allocate. The idle list is bounded and large buffers are
+// not kept, a burst of sends or a large message does not pin memory.
+class SendBufferPool {
+
+public:
+
+    // at most this many buffers are kept for reuse
+    static const size_t max_idle = 64;
+    // buffers grown beyond this are freed instead of kept
+    static const size_t max_idle_capacity = 16384;
+
+    struct Buffer {
+        std::vector<uint8_t> data;
+        // number of outstanding sends of this buffer
+        std::atomic<int> pending{0};
+        // index in buffers_
+        size_t slot;
+    };
+
+    // take a buffer and serialize msg into it, data.size() is the packet size
+    Buffer* serialize(const IMC::Message& msg, int sends = 1)
+    {
+        Buffer* buffer = acquire();
+        try {
+            buffer->data.resize(msg.getSerializationSize());
+            IMC::Packet::serialize(&msg, buffer->data.data(), buffer->data.size());
+        }
+        catch (...) {
+            release(buffer);
+            throw;
+        }
+        buffer->pending = sends;
+        return buffer;
+    }
+
+    // Like serialize(), for a message whose last field is a rawdata field
+    // left empty in msg: fill(ptr) writes tail_size bytes of that field
+    // directly into the packet, large payloads are not staged in a vector.
+    template <typename Fill>
+    Buffer* serialize_tail(const IMC::Message& msg, size_t tail_size, Fill fill, int sends = 1)
+    {
+        Buffer* buffer = acquire();
+        try {
+            buffer->data.resize(msg.getSerializationSize() + tail_size);
+            write_tail(msg, tail_size, fill, buffer->data.data());
+        }
+        catch (...) {
+            release(buffer);
+            throw;
+        }
+        buffer->pending = sends;
+        return buffer;
+    }
+
+    // the packet of serialize_tail(), bfr must hold
+    // msg.getSerializationSize() + tail_size bytes
+    template <typename Fill>
+    static size_t write_tail(const IMC::Message& msg, size_t tail_size, Fill fill, uint8_t* bfr)
+    {
+        size_t total = msg.getSerializationSize() + tail_size;
+        if (total > IMC::Message::maxSerializedSize()) {
+            throw IMC::InvalidMessageSize(total);
+        }
+
+        uint8_t* ptr = bfr + IMC::Packet::serializeHeader(&msg, bfr, total);
+        // payload size follows the sync number and the message id
+        IMC::serialize((uint16_t)(msg.getPayloadSerializationSize() + tail_size), bfr + 4);
+        ptr = msg.serializeFields(ptr);
+        // the length prefix of the empty field is the last thing written
+        IMC::serialize((uint16_t)tail_size, ptr - 2);
+        fill(ptr);
+
+        uint16_t crc = IMC::CRC16::compute(bfr, total - IMC_CONST_FOOTER_SIZE);
+        IMC::serialize(crc, bfr + total - IMC_CONST_FOOTER_SIZE);
+        return total;
+    }
+
+    // call once per finished send
+    void complete(Buffer* buffer)
+    {
+        if (--buffer->pending == 0) {
+            release(buffer);
+        }
+    }
+
+    // number of allocated buffers, idle or in flight
+    size_t size()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return buffers_.size();
+    }
+
+    // number of buffers kept for reuse
+    size_t idle()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return idle_.size();
+    }
+
+private:
+
+    Buffer* acquire()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (idle_.empty()) {
+            buffers_.emplace_back(new Buffer);
+            buffers_.back()->slot = buffers_.size() - 1;
+            return buffers_.back().get();
+        }
+        Buffer* buffer = idle_.back();
+        idle_.pop_back();
+        return buffer;
+    }
+
+    void release(Buffer* buffer)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (idle_.size() < max_idle && buffer->data.capacity() <= max_idle_capacity) {
+            idle_.push_back(buffer);
+            return;
+        }
+        // free it, the last buffer takes its slot
+        size_t slot = buffer->slot;
+        buffers_[slot].swap(buffers_.back());
+        buffers_[slot]->slot = slot;
+        buffers_.pop_back();
+    }
+
+    std::mutex mutex_;
+    // owns every buffer, including those in flight
+    std::vector<std::unique_ptr<Buffer> > buffers_;
+    std::vector<Buffer*> idle_;
+
+};
+
+#endif // SEND_BUFFER_POOL_H
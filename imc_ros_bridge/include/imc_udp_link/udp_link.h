@@ -18,12 +18,22 @@
 #include <boost/array.hpp>
 #include <boost/bind.hpp>
 #include <boost/thread.hpp>
+#include <atomic>
 #include <thread>
 #include <iostream>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 // IMC headers.
+#include <IMC/Base/MessagePool.hpp>
 #include <IMC/Base/Parser.hpp>
 
+#include <imc_udp_link/lsf_recorder.h>
+#include <imc_udp_link/mmsg_batch.h>
+#include <imc_udp_link/send_buffer_pool.h>
+
 //#define IPADDRESS "127.0.0.1" // "192.168.1.64"
 //#define UDP_PORT 30101 //6001
 
@@ -37,6 +47,9 @@ private:
     std::string bridge_addr;
     std::string bridge_port;
 
+    // declared before io_service so it outlives pending send handlers
+    SendBufferPool send_buffers_;
+
     boost::asio::io_service io_service;
     udp::socket socket{io_service};
     udp::socket multicast_socket{io_service};
@@ -44,7 +57,9 @@ private:
     boost::array<char, 262144> recv_buffer;
     udp::endpoint remote_endpoint;
     std::function<void (IMC::Message*)> recv_handler_;
-    IMC::Parser parser_;
+    // recycles inbound messages, only used on the io_service thread
+    IMC::MessagePool message_pool_;
+    IMC::Parser parser_{&message_pool_};
     boost::thread run_thread;
 
     std::vector<int> announce_ports{30100, 30101, 30102, 30103, 30104};
@@ -55,11 +70,109 @@ private:
     int imc_src_ent = 32;
 	int imc_id;
 
+    // batching mode: up to batch_size_ datagrams per recvmmsg/sendmmsg
+    // call, outbound datagrams wait at most flush_interval_ seconds.
+    // 0 keeps one system call per datagram.
+    size_t batch_size_;
+    double flush_interval_;
+
+    struct QueuedSend {
+        udp::socket* socket;
+        SendBufferPool::Buffer* buffer;
+        udp::endpoint destination;
+    };
+    std::mutex send_mutex_;
+    std::vector<QueuedSend> send_queue_;
+    boost::asio::deadline_timer flush_timer_{io_service};
+    bool flush_armed_ = false;
+#ifdef IMC_UDP_HAVE_MMSG
+    std::unique_ptr<RecvBatch> recv_batch_;
+    SendBatch send_batch_;
+#endif
+
+    // inbound dispatch: with 0 worker threads recv_handler_ runs on the
+    // receive thread. Otherwise messages go to a worker pool with one strand
+    // per peer (IMC source address), so a peer's messages stay ordered while
+    // peers proceed in parallel, and safety-critical ids get a thread of
+    // their own so they never queue behind e.g. a large PlanDB.
+    size_t worker_threads_;
+    boost::asio::io_service work_service_;
+    boost::asio::io_service priority_service_;
+    std::unique_ptr<boost::asio::io_service::work> work_guard_;
+    std::unique_ptr<boost::asio::io_service::work> priority_guard_;
+    boost::thread_group workers_;
+    // only touched by the receive thread
+    std::unordered_map<uint16_t, std::unique_ptr<boost::asio::io_service::strand> > peer_strands_;
+
+    // queueing delay per message id, indexed by id
+    struct LatencyAccumulator {
+        uint64_t count = 0;
+        double sum = 0.0;
+        double max = 0.0;
+    };
+    std::mutex latency_mutex_;
+    std::vector<LatencyAccumulator> latency_;
+
+    void dispatch(IMC::Message* m);
+
+    void record_latency(uint16_t id, std::chrono::steady_clock::time_point queued);
+
+    void send(udp::socket& sock, SendBufferPool::Buffer* buffer, const udp::endpoint& destination);
+
+    void send_queue_locked();
+
+    void parse_datagram(const uint8_t* data, size_t size);
+
+    // source, entity and time of an outbound message
+    void stamp(IMC::Message& msg);
+
+    // split a serialized packet into MessagePart messages of at most
+    // max_packet bytes each
+    void publish_fragments(const uint8_t* packet, size_t size, const std::string& address, size_t max_packet);
+
+    // identifies the fragments of one packet to the receiver
+    std::atomic<uint8_t> fragment_uid_{0};
+
+    // received and sent traffic go to separate logs, so that a log of
+    // received datagrams can be replayed into the bridge as is. Set once
+    // by record_to() and record_sent_to(), read by the send and receive
+    // threads.
+    std::unique_ptr<LsfRecorder> rx_recorder_owner_;
+    std::atomic<LsfRecorder*> rx_recorder_{nullptr};
+    std::unique_ptr<LsfRecorder> tx_recorder_owner_;
+    std::atomic<LsfRecorder*> tx_recorder_{nullptr};
+
+    static bool open_recorder(const std::string& path, std::unique_ptr<LsfRecorder>& owner,
+                              std::atomic<LsfRecorder*>& recorder);
+
+    static void record(const std::atomic<LsfRecorder*>& recorder, const uint8_t* data, size_t size)
+    {
+        if (LsfRecorder* r = recorder.load()) {
+            r->record(data, size);
+        }
+    }
+
 public:
 
     UDPLink(std::function<void (IMC::Message*)> recv_handler,
             const std::string& bridge_addr, const std::string& bridge_port,
-            int imc_id, int imc_src);
+            int imc_id, int imc_src,
+            size_t batch_size = 0, double flush_interval = 0.002,
+            size_t worker_threads = 0);
+
+    // Abort and PlanControl take the priority lane
+    static bool is_priority(uint16_t id) { return id == 550 || id == 559; }
+
+    struct QueueLatency {
+        uint16_t id;
+        uint64_t count;
+        double mean; // seconds
+        double max;  // seconds
+    };
+
+    // queueing delay between parse and handler per message id since the
+    // previous call, empty unless worker threads are used
+    std::vector<QueueLatency> take_queue_latency();
 
     ~UDPLink();
 
@@ -69,8 +182,48 @@ public:
 
     void publish_multicast(IMC::Message& msg, const std::string& multicast_addr);
 
+    // Publish msg, whose last field is a rawdata field left empty, with
+    // fill(ptr) writing tail_size bytes of that field straight into the
+    // send buffer. Packets larger than max_packet bytes (0 = no limit) are
+    // sent as MessagePart fragments.
+    template <typename Fill>
+    void publish_tail(IMC::Message& msg, size_t tail_size, Fill fill,
+                      const std::string& addr, size_t max_packet = 0)
+    {
+        stamp(msg);
+
+        size_t total = msg.getSerializationSize() + tail_size;
+        if (max_packet == 0 || total <= max_packet) {
+            SendBufferPool::Buffer* buffer = send_buffers_.serialize_tail(msg, tail_size, fill);
+            record(tx_recorder_, buffer->data.data(), buffer->data.size());
+            send(socket, buffer, udp::endpoint(address::from_string(addr), 6001));
+            return;
+        }
+
+        // the whole packet is needed to cut it, kept per thread so its
+        // capacity is reused
+        static thread_local std::vector<uint8_t> packet;
+        packet.resize(total);
+        SendBufferPool::write_tail(msg, tail_size, fill, packet.data());
+        publish_fragments(packet.data(), total, addr, max_packet);
+    }
+
     void handle_receive(const boost::system::error_code& error, size_t bytes_transferred);
 
+    void handle_receive_batch(const boost::system::error_code& error);
+
+    // send queued datagrams now (batching mode only)
+    void flush();
+
+    // log every received datagram to an LSF file, in the form imc_replay
+    // sends it back to the bridge. Returns false if the file cannot be
+    // opened, only the first call has an effect.
+    bool record_to(const std::string& path);
+
+    // same for every sent datagram, announces and MessagePart fragments
+    // included, to a separate file
+    bool record_sent_to(const std::string& path);
+
 };
 
 #endif // UDP_LINK_H
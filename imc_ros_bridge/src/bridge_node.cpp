@@ -12,6 +12,7 @@
  */
 
 #include <ros/ros.h>
+#include <algorithm>
 #include <iostream>
 
 #include <imc_ros_bridge/imc_ros_bridge_server.h>
@@ -61,8 +62,42 @@ int main(int argc, char** argv)
 	// tldr: imc_id is the vehicle TYPE and imc_src is the SPECIFIC VEHICLE
     ros::param::param<int>("~imc_id", imc_src, 30);
 	ros::param::param<int>("~imc_src", imc_id, 5);
+    // >1 moves up to this many datagrams per recvmmsg/sendmmsg call (Linux)
+    int udp_batch_size;
+    double udp_flush_interval;
+    ros::param::param<int>("~udp_batch_size", udp_batch_size, 0);
+    ros::param::param<double>("~udp_flush_interval", udp_flush_interval, 0.002);
+    // >0 converts inbound IMC messages on a worker pool, one strand per peer
+    int worker_threads;
+    double latency_report_interval;
+    ros::param::param<int>("~worker_threads", worker_threads, 0);
+    ros::param::param<double>("~latency_report_interval", latency_report_interval, 0.);
 
-    IMCHandle imc_handle(bridge_tcp_addr, bridge_tcp_port, neptus_addr, sys_name, imc_id, imc_src);
+    IMCHandle imc_handle(bridge_tcp_addr, bridge_tcp_port, neptus_addr, sys_name, imc_id, imc_src,
+                         std::max(udp_batch_size, 0), udp_flush_interval,
+                         std::max(worker_threads, 0));
+
+    // byte budget for all bridged ROS -> IMC topics, 0 = unlimited
+    double bandwidth_limit;
+    double bandwidth_burst;
+    double outbound_report_interval;
+    ros::param::param<double>("~bandwidth_limit", bandwidth_limit, 0.);
+    ros::param::param<double>("~bandwidth_burst", bandwidth_burst, 4096.);
+    ros::param::param<double>("~outbound_report_interval", outbound_report_interval, 0.);
+    imc_handle.set_bandwidth_limit(bandwidth_limit, bandwidth_burst);
+    // non-empty logs the received IMC traffic to this LSF file, which
+    // imc_replay can send back to the bridge, and the sent traffic to
+    // lsf_tx_path
+    std::string lsf_path;
+    std::string lsf_tx_path;
+    ros::param::param<std::string>("~lsf_path", lsf_path, "");
+    ros::param::param<std::string>("~lsf_tx_path", lsf_tx_path, "");
+    if (!lsf_path.empty() && imc_handle.record_to(lsf_path)) {
+        ROS_INFO("Logging received IMC traffic to %s", lsf_path.c_str());
+    }
+    if (!lsf_tx_path.empty() && imc_handle.record_sent_to(lsf_tx_path)) {
+        ROS_INFO("Logging sent IMC traffic to %s", lsf_tx_path.c_str());
+    }
 
     ros_to_imc::BridgeServer<std_msgs::Empty, IMC::Heartbeat> heartbeat_server(ros_node, imc_handle, "heartbeat");
     ros_to_imc::BridgeServer<sensor_msgs::NavSatFix, IMC::GpsFix> gpsfix_server(ros_node, imc_handle, "gps_fix");
@@ -97,6 +132,18 @@ int main(int argc, char** argv)
     ros::Timer announce_timer = ros_node.createTimer(ros::Duration(10.), announce_callback);
     ros::Timer heartbeat_timer = ros_node.createTimer(ros::Duration(1.), heartbeat_callback);
 
+    ros::Timer latency_timer;
+    if (latency_report_interval > 0.) {
+        auto latency_callback = [&](const ros::TimerEvent&) { imc_handle.report_queue_latency(); };
+        latency_timer = ros_node.createTimer(ros::Duration(latency_report_interval), latency_callback);
+    }
+
+    ros::Timer outbound_timer;
+    if (outbound_report_interval > 0.) {
+        auto outbound_callback = [&](const ros::TimerEvent&) { imc_handle.report_outbound_stats(); };
+        outbound_timer = ros_node.createTimer(ros::Duration(outbound_report_interval), outbound_callback);
+    }
+
     ros::spin();
 
     return 0;
@@ -0,0 +1,434 @@
+/* Copyright 2019 The SMaRC project (https://smarc.se/)
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Offline micro-benchmarks for the IMC transport path of the bridge.
+// Run as: imc_benchmark [section...], without arguments all sections run.
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+
+#include <IMC/Base/CRC16.hpp>
+#include <IMC/Base/Parser.hpp>
+#include <IMC/Base/MessagePool.hpp>
+#include <IMC/Spec/EstimatedState.hpp>
+#include <IMC/Spec/SonarData.hpp>
+
+#include <imc_udp_link/mmsg_batch.h>
+#include <imc_udp_link/send_buffer_pool.h>
+
+namespace {
+
+typedef std::chrono::steady_clock bench_clock;
+
+double seconds_since(const bench_clock::time_point& start)
+{
+    return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+// A datagram holding `per_datagram` serialized EstimatedState packets.
+std::vector<uint8_t> estimated_state_datagram(size_t per_datagram)
+{
+    IMC::EstimatedState msg;
+    msg.lat = 1.0459;
+    msg.lon = 0.3140;
+    msg.x = 12.5f;
+    msg.depth = 3.2f;
+    msg.setTimeStamp(1.5e9);
+
+    std::vector<uint8_t> datagram;
+    std::vector<uint8_t> packet(msg.getSerializationSize());
+    for (size_t i = 0; i < per_datagram; ++i) {
+        msg.setSource(i);
+        size_t n = IMC::Packet::serialize(&msg, &packet[0], packet.size());
+        datagram.insert(datagram.end(), packet.begin(), packet.begin() + n);
+    }
+    return datagram;
+}
+
+void bench_parser()
+{
+    const size_t iterations = 200000;
+    const size_t per_datagram_cases[] = {1, 8};
+
+    for (size_t per_datagram : per_datagram_cases) {
+        std::vector<uint8_t> datagram = estimated_state_datagram(per_datagram);
+        IMC::Parser parser;
+        size_t parsed = 0;
+
+        bench_clock::time_point start = bench_clock::now();
+        for (size_t it = 0; it < iterations; ++it) {
+            for (size_t i = 0; i < datagram.size(); ++i) {
+                IMC::Message* m = parser.parse(datagram[i]);
+                if (m) {
+                    ++parsed;
+                    delete m;
+                }
+            }
+        }
+        double bytewise = parsed / seconds_since(start);
+
+        parsed = 0;
+        start = bench_clock::now();
+        for (size_t it = 0; it < iterations; ++it) {
+            parsed += parser.parse(&datagram[0], datagram.size(),
+                                   [](IMC::Message* m) { delete m; });
+        }
+        double bulk = parsed / seconds_since(start);
+
+        std::cout << "parser: EstimatedState x" << per_datagram << "/datagram"
+                  << "  byte-wise " << bytewise << " msg/s"
+                  << "  bulk " << bulk << " msg/s"
+                  << "  (x" << bulk / bytewise << ")" << std::endl;
+    }
+}
+
+// Messages/s for parsing `datagram` repeatedly, with or without a pool.
+double parse_rate(const std::vector<uint8_t>& datagram, size_t iterations,
+                  IMC::MessagePool* pool)
+{
+    IMC::Parser parser(pool);
+    size_t parsed = 0;
+    bench_clock::time_point start = bench_clock::now();
+    for (size_t it = 0; it < iterations; ++it) {
+        parsed += parser.parse(&datagram[0], datagram.size(),
+                               [pool](IMC::Message* m) {
+            IMC::MessagePool::Releaser release(pool);
+            release(m);
+        });
+    }
+    return parsed / seconds_since(start);
+}
+
+void bench_pool()
+{
+    IMC::SonarData sonar;
+    sonar.type = IMC::SonarData::ST_SIDESCAN;
+    sonar.bits_per_point = 8;
+    sonar.data.assign(2000, 42);
+    std::vector<uint8_t> sonar_datagram(sonar.getSerializationSize());
+    IMC::Packet::serialize(&sonar, &sonar_datagram[0], sonar_datagram.size());
+
+    struct {
+        const char* name;
+        std::vector<uint8_t> datagram;
+    } cases[] = {
+        {"EstimatedState", estimated_state_datagram(1)},
+        {"SonarData(2000B)", sonar_datagram},
+    };
+
+    for (auto& c : cases) {
+        IMC::MessagePool pool;
+        double heap = parse_rate(c.datagram, 500000, 0);
+        double pooled = parse_rate(c.datagram, 500000, &pool);
+        std::cout << "pool: " << c.name
+                  << "  heap " << heap << " msg/s"
+                  << "  pooled " << pooled << " msg/s"
+                  << "  (x" << pooled / heap << ")" << std::endl;
+    }
+}
+
+// Sends `count` copies of msg to a loopback port while an io_service thread
+// completes them, as UDPLink does. Returns messages/s.
+template <typename Send>
+double send_rate(const IMC::Message& msg, size_t count, Send send)
+{
+    using boost::asio::ip::udp;
+    boost::asio::io_service io_service;
+    boost::asio::io_service::work work(io_service);
+    boost::thread run_thread(boost::bind(&boost::asio::io_service::run, &io_service));
+
+    udp::socket socket(io_service, udp::endpoint(udp::v4(), 0));
+    udp::endpoint destination(boost::asio::ip::address_v4::loopback(), 9);
+    std::atomic<size_t> completed{0};
+
+    bench_clock::time_point start = bench_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        send(socket, destination, msg, completed);
+    }
+    while (completed < count) {
+        boost::this_thread::yield();
+    }
+    double rate = count / seconds_since(start);
+
+    io_service.stop();
+    run_thread.join();
+    return rate;
+}
+
+void bench_send()
+{
+    using boost::asio::ip::udp;
+
+    IMC::EstimatedState state;
+    IMC::SonarData sonar;
+    sonar.data.assign(8000, 42); // would not fit the old 4096-byte buffer
+
+    struct {
+        const char* name;
+        const IMC::Message* msg;
+    } cases[] = {
+        {"EstimatedState", &state},
+        {"SonarData(8000B)", &sonar},
+    };
+
+    for (auto& c : cases) {
+        const size_t count = 200000;
+
+        // a correct send without pooling: serialize into a fresh heap buffer
+        double heap = send_rate(*c.msg, count,
+            [](udp::socket& socket, const udp::endpoint& destination,
+               const IMC::Message& msg, std::atomic<size_t>& completed) {
+            std::shared_ptr<std::vector<uint8_t> > buffer(
+                new std::vector<uint8_t>(msg.getSerializationSize()));
+            IMC::Packet::serialize(&msg, buffer->data(), buffer->size());
+            socket.async_send_to(boost::asio::buffer(*buffer), destination,
+                                 [buffer, &completed](const boost::system::error_code&, size_t) {
+                ++completed;
+            });
+        });
+
+        SendBufferPool pool;
+        double pooled = send_rate(*c.msg, count,
+            [&pool](udp::socket& socket, const udp::endpoint& destination,
+                    const IMC::Message& msg, std::atomic<size_t>& completed) {
+            SendBufferPool::Buffer* buffer = pool.serialize(msg);
+            socket.async_send_to(boost::asio::buffer(buffer->data), destination,
+                                 [&pool, buffer, &completed](const boost::system::error_code&, size_t) {
+                pool.complete(buffer);
+                ++completed;
+            });
+        });
+
+        std::cout << "send: " << c.name
+                  << "  heap buffers " << heap << " msg/s"
+                  << "  pooled " << pooled << " msg/s"
+                  << "  (" << pool.size() << " buffers kept)" << std::endl;
+
+        // the buffer handling alone, without the socket
+        const size_t rounds = 2000000;
+        size_t bytes = 0;
+        bench_clock::time_point start = bench_clock::now();
+        for (size_t i = 0; i < rounds; ++i) {
+            std::shared_ptr<std::vector<uint8_t> > buffer(
+                new std::vector<uint8_t>(c.msg->getSerializationSize()));
+            bytes += IMC::Packet::serialize(c.msg, buffer->data(), buffer->size());
+        }
+        double heap_serialize = rounds / seconds_since(start);
+
+        start = bench_clock::now();
+        for (size_t i = 0; i < rounds; ++i) {
+            SendBufferPool::Buffer* buffer = pool.serialize(*c.msg);
+            bytes += buffer->data.size();
+            pool.complete(buffer);
+        }
+        double pooled_serialize = rounds / seconds_since(start);
+
+        std::cout << "serialize: " << c.name
+                  << "  heap buffers " << heap_serialize << " msg/s"
+                  << "  pooled " << pooled_serialize << " msg/s"
+                  << "  (" << bytes << " bytes)" << std::endl;
+    }
+}
+
+// Converting a sonar ping the old way (copy into IMC::SonarData element by
+// element, then serialize) against writing it straight into the send buffer.
+void bench_sonar()
+{
+    const size_t sizes[] = {2000, 16000, 60000};
+    for (size_t size : sizes) {
+        // stands in for the uint8[] of the ROS message
+        std::vector<uint8_t> ping(size, 42);
+        SendBufferPool pool;
+        const size_t count = 20000;
+
+        bench_clock::time_point start = bench_clock::now();
+        for (size_t i = 0; i < count; ++i) {
+            IMC::SonarData msg;
+            for (size_t j = 0; j < ping.size(); ++j) {
+                msg.data.push_back(ping[j]);
+            }
+            pool.complete(pool.serialize(msg));
+        }
+        double copied = count / seconds_since(start);
+
+        start = bench_clock::now();
+        for (size_t i = 0; i < count; ++i) {
+            IMC::SonarData msg;
+            const uint8_t* data = ping.data();
+            pool.complete(pool.serialize_tail(msg, size, [data, size](uint8_t* ptr) {
+                std::memcpy(ptr, data, size);
+            }));
+        }
+        double direct = count / seconds_since(start);
+
+        std::cout << "sonar: " << size << "B"
+                  << "  convert+serialize " << copied << " pings/s"
+                  << "  direct " << direct << " pings/s"
+                  << "  (x" << direct / copied << ")" << std::endl;
+    }
+}
+
+#ifdef IMC_UDP_HAVE_MMSG
+// Loopback round of `total` EstimatedState datagrams, sent and drained in
+// groups of `batch` so the receive buffer never overflows. Returns msg/s.
+double loopback_rate(size_t total, size_t batch, bool mmsg)
+{
+    using boost::asio::ip::udp;
+    boost::asio::io_service io_service;
+    udp::socket receiver(io_service, udp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+    udp::socket sender(io_service, udp::endpoint(udp::v4(), 0));
+    udp::endpoint destination = receiver.local_endpoint();
+
+    std::vector<uint8_t> datagram = estimated_state_datagram(1);
+    std::vector<uint8_t> recv_buffer(65536);
+    udp::endpoint from;
+    RecvBatch recv_batch(batch);
+    SendBatch send_batch;
+    size_t received = 0;
+
+    bench_clock::time_point start = bench_clock::now();
+    for (size_t done = 0; done < total; done += batch) {
+        if (mmsg) {
+            for (size_t i = 0; i < batch; ++i) {
+                send_batch.add(&datagram[0], datagram.size(), destination);
+            }
+            send_batch.flush(sender.native_handle());
+            size_t got = 0;
+            while (got < batch) {
+                int n = recv_batch.receive(receiver.native_handle());
+                got += n > 0 ? n : 0;
+            }
+            received += got;
+        }
+        else {
+            for (size_t i = 0; i < batch; ++i) {
+                sender.send_to(boost::asio::buffer(datagram), destination);
+            }
+            for (size_t i = 0; i < batch; ++i) {
+                received += receiver.receive_from(boost::asio::buffer(recv_buffer), from) > 0;
+            }
+        }
+    }
+    return received / seconds_since(start);
+}
+
+void bench_batch()
+{
+    const size_t total = 200000;
+    const size_t batches[] = {8, 32};
+    for (size_t batch : batches) {
+        double single = loopback_rate(total, batch, false);
+        double batched = loopback_rate(total, batch, true);
+        std::cout << "batch: EstimatedState loopback, " << batch << " per call"
+                  << "  sendto/recvfrom " << single << " msg/s"
+                  << "  sendmmsg/recvmmsg " << batched << " msg/s"
+                  << "  (x" << batched / single << ")" << std::endl;
+    }
+}
+#endif
+
+// Keeps benchmarked results alive so the work cannot be elided.
+volatile uint16_t crc_sink;
+
+// Runs `crc` over `buffer` until about `total_bytes` were processed and
+// returns MB/s.
+template <typename Crc>
+double crc_throughput(const std::vector<uint8_t>& buffer, size_t total_bytes,
+                      Crc crc)
+{
+    size_t iterations = total_bytes / buffer.size() + 1;
+    uint16_t checksum = 0;
+    bench_clock::time_point start = bench_clock::now();
+    for (size_t it = 0; it < iterations; ++it) {
+        checksum ^= crc(&buffer[0], buffer.size());
+    }
+    crc_sink = checksum;
+    return iterations * buffer.size() / seconds_since(start) / 1e6;
+}
+
+void bench_crc()
+{
+    // Heartbeat-sized, EstimatedState-sized, one MTU and a large SonarData.
+    const size_t sizes[] = {22, 110, 1500, 65535};
+    const size_t total_bytes = 256 << 20;
+
+    for (size_t size : sizes) {
+        std::vector<uint8_t> buffer(size);
+        for (size_t i = 0; i < size; ++i) {
+            buffer[i] = (uint8_t)(i * 2654435761u >> 13);
+        }
+
+        uint16_t reference = IMC::CRC16::computeBytewise(&buffer[0], size);
+        double bytewise = crc_throughput(buffer, total_bytes,
+            [](const uint8_t* b, size_t n) { return IMC::CRC16::computeBytewise(b, n); });
+        double slicing = crc_throughput(buffer, total_bytes,
+            [](const uint8_t* b, size_t n) { return IMC::CRC16::computeSlicing(b, n); });
+        double dispatch = crc_throughput(buffer, total_bytes,
+            [](const uint8_t* b, size_t n) { return IMC::CRC16::compute(b, n); });
+        bool identical = IMC::CRC16::computeSlicing(&buffer[0], size) == reference
+            && IMC::CRC16::compute(&buffer[0], size) == reference;
+
+        std::cout << "crc: " << size << " bytes"
+                  << "  byte-wise " << bytewise << " MB/s"
+                  << "  slicing-by-8 " << slicing << " MB/s";
+#if defined(IMC_CRC16_CLMUL)
+        if (IMC::CRC16::hasClmul()) {
+            double clmul = crc_throughput(buffer, total_bytes,
+                [](const uint8_t* b, size_t n) { return IMC::CRC16::computeClmul(b, n); });
+            identical &= IMC::CRC16::computeClmul(&buffer[0], size) == reference;
+            std::cout << "  clmul " << clmul << " MB/s";
+        }
+#endif
+        std::cout << "  dispatched " << dispatch << " MB/s"
+                  << (identical ? "" : "  MISMATCH") << std::endl;
+    }
+}
+
+struct Section {
+    const char* name;
+    void (*run)();
+};
+
+const Section sections[] = {
+    {"parser", bench_parser},
+    {"crc", bench_crc},
+    {"pool", bench_pool},
+    {"send", bench_send},
+    {"sonar", bench_sonar},
+#ifdef IMC_UDP_HAVE_MMSG
+    {"batch", bench_batch},
+#endif
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    for (const Section& section : sections) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i) {
+            selected |= std::string(argv[i]) == section.name;
+        }
+        if (selected) {
+            section.run();
+        }
+    }
+    return 0;
+}
@@ -15,6 +15,7 @@
 #include <IMC/Spec/Announce.hpp>
 #include <IMC/Spec/Heartbeat.hpp>
 #include <IMC/Spec/EntityInfo.hpp>
+#include <IMC/Base/Factory.hpp>
 
 #include <functional>
 #include <ros/ros.h>
@@ -30,9 +31,14 @@ IMCHandle::IMCHandle(const std::string& bridge_tcp_addr,
                      const std::string& neptus_addr,
                      const std::string& sys_name, 
 					 int imc_id, 
-					 int imc_src)
-    : udp_link(std::bind(&IMCHandle::tcp_callback, this, std::placeholders::_1),
-               bridge_tcp_addr, bridge_tcp_port, imc_id, imc_src),
+					 int imc_src,
+					 size_t udp_batch_size,
+					 double udp_flush_interval,
+					 size_t worker_threads)
+    : callbacks(std::make_shared<DispatchTable>()),
+      udp_link(std::bind(&IMCHandle::tcp_callback, this, std::placeholders::_1),
+               bridge_tcp_addr, bridge_tcp_port, imc_id, imc_src,
+               udp_batch_size, udp_flush_interval, worker_threads),
       neptus_addr(neptus_addr),
       bridge_tcp_addr(bridge_tcp_addr), bridge_tcp_port(bridge_tcp_port),
       sys_name(sys_name), imc_id(imc_id), imc_src(imc_src)
@@ -48,31 +54,35 @@ IMCHandle::~IMCHandle()
 
 void IMCHandle::tcp_subscribe(uint16_t uid, std::function<void(const IMC::Message*)> callback)
 {
-    callbacks[uid] = callback;
+    std::lock_guard<std::mutex> lock(subscribe_mutex);
+    std::shared_ptr<DispatchTable> table = std::make_shared<DispatchTable>(*callbacks);
+    if (uid >= table->size()) {
+        table->resize(uid + 1);
+    }
+    (*table)[uid].push_back(callback);
+    std::atomic_store(&callbacks, std::shared_ptr<const DispatchTable>(table));
 }
 
 void IMCHandle::tcp_callback(const IMC::Message* msg)
 {
     uint16_t uid = msg->getId();
-    if (callbacks.count(uid) > 0) {
+    std::shared_ptr<const DispatchTable> table = std::atomic_load(&callbacks);
+    if (uid < table->size() && !(*table)[uid].empty()) {
 		// 150 is a heartbeat and we dont really care about it. just debug it.
 		// 556 is PlanDB, i _think_ its the planDB succss, meaning "i understood that you got my plan"
 		// neptus basically spams this so im excluding it!
 		if(uid == 150 || uid == 556){
 			ROS_DEBUG("Got callback with id: %u", uid);
 		}else{
-			ROS_INFO("Got callback with id: %u", uid);
+			ROS_INFO_THROTTLE(1.0, "Got callback with id: %u", uid);
+		}
+		for (const Callback& callback : (*table)[uid]) {
+			callback(msg);
 		}
-		callbacks.at(uid)(msg);
     }
     else {
-        ROS_INFO("Got tcp message with no configure callback, msgid: %u!", uid);
-	// lets just print the whole message in json format if we can't parse it yet.
-	std::cout << "Message name: " << msg->getName() << std::endl << "Message JSON:" << std::endl;
-	// (ostream, indent)
-	msg->fieldsToJSON(std::cout, 4);
-	std::cout << std::endl;
-    std::cout << "---------------------" << std::endl;
+        // printing happens on the logger thread, rate limited per id
+        unhandled_logger.log(msg);
     }
 }
 
@@ -108,3 +118,34 @@ void IMCHandle::publish_heartbeat()
     IMC::Heartbeat msg;
     udp_link.publish(msg, neptus_addr);
 }
+
+void IMCHandle::report_queue_latency()
+{
+    for (const UDPLink::QueueLatency& stats : udp_link.take_queue_latency()) {
+        ROS_INFO("IMC %s (%u): %lu msgs, queue latency mean %.3f ms, max %.3f ms%s",
+                 IMC::Factory::getAbbrevFromId(stats.id).c_str(), stats.id,
+                 (unsigned long)stats.count, stats.mean * 1e3, stats.max * 1e3,
+                 UDPLink::is_priority(stats.id) ? " (priority)" : "");
+    }
+}
+
+void IMCHandle::set_bandwidth_limit(double bytes_per_second, double burst_bytes)
+{
+    bandwidth.configure(bytes_per_second, burst_bytes);
+}
+
+OutboundCounters& IMCHandle::counters(const std::string& topic)
+{
+    std::lock_guard<std::mutex> lock(counters_mutex);
+    return outbound_counters[topic];
+}
+
+void IMCHandle::report_outbound_stats()
+{
+    std::lock_guard<std::mutex> lock(counters_mutex);
+    for (const auto& topic : outbound_counters) {
+        ROS_INFO("IMC out %s: %lu sent, %lu coalesced, %lu dropped", topic.first.c_str(),
+                 (unsigned long)topic.second.sent, (unsigned long)topic.second.coalesced,
+                 (unsigned long)topic.second.dropped);
+    }
+}
@@ -0,0 +1,212 @@
+/* Copyright 2019 The SMaRC project (https://smarc.se/)
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Replays an LSF log of received traffic (see ~lsf_path of the bridge) into
+// a running bridge, for offline benchmarks and for re-running field
+// missions without Neptus. Logs of sent traffic (~lsf_tx_path) are for
+// inspection with --list, replaying them would feed the bridge its own
+// output. The file is memory mapped and indexed once, packets are then sent
+// as one UDP datagram each, paced by their IMC timestamps.
+//
+// Run as: imc_replay <file.lsf> [--list] [--speed <factor>|max]
+//                    [--to <addr>:<port>] [--types <id|abbrev>,...]
+//                    [--src <imc source>] [--from <s>] [--until <s>]
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <IMC/Base/Factory.hpp>
+
+#include <imc_udp_link/lsf_index.h>
+
+namespace {
+
+std::string abbrev(uint16_t id)
+{
+    try {
+        return IMC::Factory::getAbbrevFromId(id);
+    }
+    catch (const std::exception&) {
+        return "unknown";
+    }
+}
+
+void print_index(const LsfIndex& index)
+{
+    std::cout << index.entries.size() << " packets, " << index.skipped << " bytes skipped" << std::endl;
+    if (!index.entries.empty()) {
+        auto bounds = std::minmax_element(index.entries.begin(), index.entries.end(),
+            [](const LsfIndexEntry& a, const LsfIndexEntry& b) { return a.time < b.time; });
+        std::cout << "duration " << bounds.second->time - bounds.first->time << " s" << std::endl;
+    }
+    for (const auto& type : index.by_type) {
+        size_t bytes = 0;
+        for (size_t i : type.second) {
+            bytes += index.entries[i].size;
+        }
+        std::cout << abbrev(type.first) << " (" << type.first << "): "
+                  << type.second.size() << " packets, " << bytes << " bytes" << std::endl;
+    }
+}
+
+// message ids from a list like "EstimatedState,550"
+std::vector<uint16_t> parse_types(const std::string& list)
+{
+    std::vector<uint16_t> ids;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty() && std::isdigit((unsigned char)item[0])) {
+            ids.push_back(std::atoi(item.c_str()));
+        }
+        else {
+            ids.push_back(IMC::Factory::getIdFromAbbrev(item));
+        }
+    }
+    return ids;
+}
+
+int usage()
+{
+    std::cerr << "usage: imc_replay <file.lsf> [--list] [--speed <factor>|max]"
+                 " [--to <addr>:<port>] [--types <id|abbrev>,...] [--src <imc source>]"
+                 " [--from <s>] [--until <s>]" << std::endl;
+    return 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        return usage();
+    }
+
+    bool list = false;
+    double speed = 1.0; // 0 = as fast as possible
+    std::string to = "127.0.0.1:6002";
+    std::string types;
+    int src = -1;
+    double from = 0.0;
+    double until = -1.0;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--list") {
+            list = true;
+        }
+        else if (arg == "--speed" && has_value) {
+            std::string value = argv[++i];
+            speed = value == "max" ? 0.0 : std::atof(value.c_str());
+        }
+        else if (arg == "--to" && has_value) {
+            to = argv[++i];
+        }
+        else if (arg == "--types" && has_value) {
+            types = argv[++i];
+        }
+        else if (arg == "--src" && has_value) {
+            src = std::atoi(argv[++i]);
+        }
+        else if (arg == "--from" && has_value) {
+            from = std::atof(argv[++i]);
+        }
+        else if (arg == "--until" && has_value) {
+            until = std::atof(argv[++i]);
+        }
+        else {
+            return usage();
+        }
+    }
+
+    boost::iostreams::mapped_file_source file;
+    try {
+        file.open(argv[1]);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "cannot map " << argv[1] << ": " << e.what() << std::endl;
+        return 1;
+    }
+    const uint8_t* data = (const uint8_t*)file.data();
+
+    LsfIndex index = build_lsf_index(data, file.size());
+    if (list) {
+        print_index(index);
+        return 0;
+    }
+
+    std::vector<uint16_t> ids;
+    try {
+        ids = parse_types(types);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "unknown message type: " << e.what() << std::endl;
+        return 1;
+    }
+    // the selected packets, by time
+    std::vector<size_t> selected = select_packets(index, ids, src);
+    if (selected.empty()) {
+        std::cerr << "no packets selected" << std::endl;
+        return 1;
+    }
+
+    using boost::asio::ip::udp;
+    size_t colon = to.rfind(':');
+    if (colon == std::string::npos) {
+        return usage();
+    }
+    boost::asio::io_service io_service;
+    udp::socket socket(io_service, udp::endpoint(udp::v4(), 0));
+    udp::endpoint destination(boost::asio::ip::address::from_string(to.substr(0, colon)),
+                              std::atoi(to.c_str() + colon + 1));
+
+    typedef std::chrono::steady_clock clock;
+    double t0 = index.entries[selected.front()].time;
+    clock::time_point start = clock::now();
+    size_t sent = 0;
+    size_t bytes = 0;
+    for (size_t i : selected) {
+        const LsfIndexEntry& entry = index.entries[i];
+        double t = entry.time - t0;
+        if (t < from || (until >= 0.0 && t > until)) {
+            continue;
+        }
+        if (speed > 0.0) {
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<clock::duration>(
+                std::chrono::duration<double>((t - from) / speed)));
+        }
+        boost::system::error_code error;
+        socket.send_to(boost::asio::buffer(data + entry.offset, entry.size), destination, 0, error);
+        if (error) {
+            std::cerr << "send failed: " << error.message() << std::endl;
+            return 1;
+        }
+        ++sent;
+        bytes += entry.size;
+    }
+
+    double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    std::cout << "replayed " << sent << " packets, " << bytes << " bytes in " << elapsed << " s ("
+              << sent / std::max(elapsed, 1e-9) << " msg/s)" << std::endl;
+    return 0;
+}
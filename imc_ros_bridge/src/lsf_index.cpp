@@ -0,0 +1,90 @@
+/* Copyright 2019 The SMaRC project (https://smarc.se/)
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <imc_udp_link/lsf_index.h>
+
+#include <algorithm>
+#include <exception>
+
+#include <IMC/Base/Packet.hpp>
+
+LsfIndex build_lsf_index(const uint8_t* data, size_t size)
+{
+    LsfIndex index;
+    size_t offset = 0;
+    while (offset + IMC_CONST_HEADER_SIZE + IMC_CONST_FOOTER_SIZE <= size) {
+        IMC::Header hdr;
+        try {
+            IMC::Packet::deserializeHeader(hdr, data + offset, size - offset);
+        }
+        catch (const std::exception&) {
+            ++offset;
+            ++index.skipped;
+            continue;
+        }
+
+        size_t total = IMC_CONST_HEADER_SIZE + hdr.size + IMC_CONST_FOOTER_SIZE;
+        bool valid = offset + total <= size;
+        if (valid) {
+            const uint8_t* footer = data + offset + total - IMC_CONST_FOOTER_SIZE;
+            uint16_t crc;
+            if (hdr.sync == IMC_CONST_SYNC) {
+                IMC::ByteCopy::copy(crc, footer);
+            }
+            else {
+                IMC::ByteCopy::rcopy(crc, footer);
+            }
+            valid = IMC::CRC16::compute(data + offset, total - IMC_CONST_FOOTER_SIZE) == crc;
+        }
+        if (!valid) {
+            ++offset;
+            ++index.skipped;
+            continue;
+        }
+
+        index.by_type[hdr.mgid].push_back(index.entries.size());
+        index.entries.push_back(LsfIndexEntry{hdr.timestamp, offset, (uint32_t)total, hdr.mgid, hdr.src});
+        offset += total;
+    }
+    index.skipped += size - offset;
+    return index;
+}
+
+std::vector<size_t> select_packets(const LsfIndex& index, const std::vector<uint16_t>& ids, int src)
+{
+    std::vector<size_t> selected;
+    if (ids.empty()) {
+        for (size_t i = 0; i < index.entries.size(); ++i) {
+            selected.push_back(i);
+        }
+    }
+    else {
+        for (uint16_t id : ids) {
+            auto type = index.by_type.find(id);
+            if (type != index.by_type.end()) {
+                selected.insert(selected.end(), type->second.begin(), type->second.end());
+            }
+        }
+        std::sort(selected.begin(), selected.end());
+    }
+    if (src >= 0) {
+        selected.erase(std::remove_if(selected.begin(), selected.end(), [&](size_t i) {
+            return index.entries[i].src != src;
+        }), selected.end());
+    }
+    std::stable_sort(selected.begin(), selected.end(), [&](size_t a, size_t b) {
+        return index.entries[a].time < index.entries[b].time;
+    });
+    return selected;
+}
@@ -0,0 +1,80 @@
+/* Copyright 2019 The SMaRC project (https://smarc.se/)
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <imc_udp_link/lsf_recorder.h>
+
+#include <algorithm>
+#include <chrono>
+
+LsfRecorder::LsfRecorder(const std::string& path, size_t chunk_size, size_t max_buffered,
+                         double flush_interval)
+    : file_(path, std::ios::out | std::ios::app | std::ios::binary),
+      chunk_size_(chunk_size), max_buffered_(std::max(max_buffered, chunk_size)),
+      flush_interval_(flush_interval), stop_(false)
+{
+    filling_.reserve(chunk_size_);
+    if (file_.is_open()) {
+        thread_ = std::thread(&LsfRecorder::run, this);
+    }
+}
+
+LsfRecorder::~LsfRecorder()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void LsfRecorder::record(const uint8_t* data, size_t size)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!file_.is_open() || filling_.size() + size > max_buffered_) {
+        ++dropped_;
+        return;
+    }
+    bool was_below = filling_.size() < chunk_size_;
+    filling_.insert(filling_.end(), data, data + size);
+    if (was_below && filling_.size() >= chunk_size_) {
+        lock.unlock();
+        cv_.notify_one();
+    }
+}
+
+void LsfRecorder::run()
+{
+    std::vector<uint8_t> writing;
+    writing.reserve(chunk_size_);
+    std::chrono::duration<double> interval(flush_interval_);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait_for(lock, interval, [this] { return stop_ || filling_.size() >= chunk_size_; });
+        bool stopping = stop_;
+        if (!filling_.empty()) {
+            writing.swap(filling_);
+            lock.unlock();
+            file_.write((const char*)writing.data(), writing.size());
+            file_.flush();
+            writing.clear();
+            lock.lock();
+        }
+        if (stopping && filling_.empty()) {
+            return;
+        }
+    }
+}
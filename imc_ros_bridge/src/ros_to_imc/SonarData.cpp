@@ -13,6 +13,9 @@
 
 #include <imc_ros_bridge/ros_to_imc/SonarData.h>
 
+#include <algorithm>
+#include <cstring>
+
 namespace ros_to_imc {
 
 template <>
@@ -25,13 +28,153 @@ bool convert(const imc_ros_bridge::SonarData& ros_msg, IMC::SonarData& imc_msg)
     imc_msg.max_range = ros_msg.max_range;
     imc_msg.bits_per_point = ros_msg.bits_per_point;
     imc_msg.scale_factor = ros_msg.scale_factor;
-    for(unsigned int i=0;i<ros_msg.data.size();i++) {
-      //imc_msg.data = ros_msg.data;
-      imc_msg.data.push_back(ros_msg.data[i]);
+    imc_msg.data.assign(ros_msg.data.begin(), ros_msg.data.end());
+
+    return true;
+}
+
+namespace {
+
+uint32_t read_point(const uint8_t* ptr, int bytes)
+{
+    // IMC data is little endian
+    uint32_t value = 0;
+    for (int i = bytes - 1; i >= 0; --i) {
+        value = (value << 8) | ptr[i];
+    }
+    return value;
+}
+
+void write_point(uint32_t value, uint8_t* ptr, int bytes)
+{
+    for (int i = 0; i < bytes; ++i) {
+        ptr[i] = value & 0xff;
+        value >>= 8;
+    }
+}
+
+// Averages groups of factor points and drops the low bits of each result.
+// Sidescan sides are reduced separately so no group mixes port and
+// starboard. Returns the bytes written to out.
+size_t reduce(const uint8_t* in, size_t points, int in_bytes, int sides,
+              size_t factor, int shift, int out_bytes, uint8_t* out)
+{
+    uint8_t* ptr = out;
+    for (int side = 0; side < sides; ++side) {
+        size_t begin = points * side / sides;
+        size_t end = points * (side + 1) / sides;
+        for (size_t i = begin; i < end; i += factor) {
+            size_t n = std::min(factor, end - i);
+            uint64_t sum = 0;
+            for (size_t j = 0; j < n; ++j) {
+                sum += read_point(in + (i + j) * in_bytes, in_bytes);
+            }
+            write_point((uint32_t)(sum / n) >> shift, ptr, out_bytes);
+            ptr += out_bytes;
+        }
+    }
+    return ptr - out;
+}
+
+size_t reduced_size(size_t points, int sides, size_t factor, int out_bytes)
+{
+    size_t size = 0;
+    for (int side = 0; side < sides; ++side) {
+        size_t n = points * (side + 1) / sides - points * side / sides;
+        size += (n + factor - 1) / factor * out_bytes;
     }
+    return size;
+}
+
+} // namespace
 
+SonarDataWriter::SonarDataWriter()
+{
+    int max_data, max_packet;
+    ros::param::param<int>("~sonar/downsample", downsample, 1);
+    ros::param::param<int>("~sonar/bits_per_point", bits_per_point, 0);
+    ros::param::param<int>("~sonar/max_data_size", max_data, 0);
+    ros::param::param<int>("~sonar/max_packet_size", max_packet, 0);
+    downsample = std::max(downsample, 1);
+    max_data_size = std::max(max_data, 0);
+    max_packet_size = std::max(max_packet, 0);
+}
 
+bool SonarDataWriter::write(IMCHandle& imc_handle, const imc_ros_bridge::SonarData& ros_msg) const
+{
+    // everything but the data, which is written into the packet directly
+    IMC::SonarData imc_msg;
+    imc_msg.type = ros_msg.type;
+    imc_msg.frequency = ros_msg.frequency;
+    imc_msg.min_range = ros_msg.min_range;
+    imc_msg.max_range = ros_msg.max_range;
+    imc_msg.bits_per_point = ros_msg.bits_per_point;
+    imc_msg.scale_factor = ros_msg.scale_factor;
+
+    const uint8_t* data = ros_msg.data.data();
+    size_t size = ros_msg.data.size();
+    size_t max_size = IMC::Message::maxSerializedSize() - imc_msg.getSerializationSize();
+
+    // multibeam data is laid out per beam_config, which is not bridged, and
+    // only whole byte points can be averaged
+    int in_bits = ros_msg.bits_per_point;
+    bool reducible = ros_msg.type != imc_ros_bridge::SonarData::ST_MULTIBEAM &&
+                     (in_bits == 8 || in_bits == 16 || in_bits == 32);
+    if (!reducible) {
+        if (size > max_size) {
+            ROS_WARN("SonarData of %lu bytes does not fit an IMC message", (unsigned long)size);
+            return true;
+        }
+        return imc_handle.write_tail(imc_msg, size, [data, size](uint8_t* ptr) {
+            std::memcpy(ptr, data, size);
+        }, max_packet_size);
+    }
+
+    int in_bytes = in_bits / 8;
+    int out_bits = in_bits;
+    if (bits_per_point == 8 || bits_per_point == 16) {
+        out_bits = std::min(in_bits, bits_per_point);
+    }
+    int out_bytes = out_bits / 8;
+    int sides = ros_msg.type == imc_ros_bridge::SonarData::ST_SIDESCAN ? 2 : 1;
+    size_t points = size / in_bytes;
+
+    size_t factor = downsample;
+    size_t out_size = reduced_size(points, sides, factor, out_bytes);
+    while (max_data_size > 0 && out_size > max_data_size && factor < points) {
+        out_size = reduced_size(points, sides, ++factor, out_bytes);
+    }
+
+    if (out_size > max_size) {
+        ROS_WARN("SonarData of %lu bytes does not fit an IMC message, set ~sonar/max_data_size",
+                 (unsigned long)out_size);
+        return true;
+    }
+
+    if (factor == 1 && out_bits == in_bits) {
+        return imc_handle.write_tail(imc_msg, size, [data, size](uint8_t* ptr) {
+            std::memcpy(ptr, data, size);
+        }, max_packet_size);
+    }
+
+    int shift = in_bits - out_bits;
+    imc_msg.bits_per_point = out_bits;
+    imc_msg.scale_factor = ros_msg.scale_factor * (float)(1u << shift);
+    return imc_handle.write_tail(imc_msg, out_size, [=](uint8_t* ptr) {
+        reduce(data, points, in_bytes, sides, factor, shift, out_bytes, ptr);
+    }, max_packet_size);
+}
+
+template <>
+bool BridgeServer<imc_ros_bridge::SonarData, IMC::SonarData>::send(const imc_ros_bridge::SonarData& ros_msg)
+{
+    // constructed on the first ping, once the node is up
+    static const SonarDataWriter writer;
+    if (!writer.write(imc_handle, ros_msg)) {
+        return false;
+    }
+    ++counters.sent;
     return true;
 }
 
-} // namespace imc_to_ros
+} // namespace ros_to_imc
@@ -12,28 +12,51 @@
  */
 
 #include <imc_udp_link/udp_link.h>
+#include <IMC/Spec/MessagePart.hpp>
 
 #include <boost/lexical_cast.hpp>
 #include <ros/ros.h>
 
-/*
-// basic file operations
-#include <iostream>
-#include <fstream>
-std::ofstream myfile;
-*/
+#include <algorithm>
+#include <cstring>
+
 using namespace std;
 
 UDPLink::UDPLink(std::function<void (IMC::Message*)> recv_handler,
-        const std::string& bridge_addr, const std::string& bridge_port, int imc_id, int imc_src)
-    : recv_handler_(recv_handler), bridge_addr(bridge_addr), bridge_port(bridge_port), imc_id(imc_id), imc_src(imc_src)
+        const std::string& bridge_addr, const std::string& bridge_port, int imc_id, int imc_src,
+        size_t batch_size, double flush_interval, size_t worker_threads)
+    : recv_handler_(recv_handler), bridge_addr(bridge_addr), bridge_port(bridge_port), imc_id(imc_id), imc_src(imc_src),
+      batch_size_(batch_size), flush_interval_(flush_interval), worker_threads_(worker_threads)
 {
+    if (worker_threads_ > 0) {
+        work_guard_.reset(new boost::asio::io_service::work(work_service_));
+        priority_guard_.reset(new boost::asio::io_service::work(priority_service_));
+        for (size_t i = 0; i < worker_threads_; ++i) {
+            workers_.create_thread(boost::bind(&boost::asio::io_service::run, &work_service_));
+        }
+        workers_.create_thread(boost::bind(&boost::asio::io_service::run, &priority_service_));
+    }
+
     socket.open(udp::v4());
     socket.set_option(udp::socket::reuse_address(true));
     socket.bind(udp::endpoint(address::from_string(bridge_addr), boost::lexical_cast<int>(bridge_port)));
 
     should_shutdown = false;
 
+#ifdef IMC_UDP_HAVE_MMSG
+    if (batch_size_ > 1) {
+        recv_batch_.reset(new RecvBatch(batch_size_));
+    }
+#else
+    if (batch_size_ > 1) {
+        ROS_WARN("UDP batching needs recvmmsg/sendmmsg, using one datagram per call");
+    }
+    batch_size_ = 0;
+#endif
+    if (batch_size_ == 1) {
+        batch_size_ = 0;
+    }
+
     multicast_socket.open(boost::asio::ip::udp::v4());
 
     wait();
@@ -48,58 +71,187 @@ UDPLink::~UDPLink()
 {
     //multicast_socket.shutdown();
     should_shutdown = true;
+    flush();
     multicast_socket.close();
     run_thread.join();
+    // let the workers finish what is queued
+    work_guard_.reset();
+    priority_guard_.reset();
+    workers_.join_all();
 }
 
-void handler(const boost::system::error_code& error, size_t bytes_transferred)
-{
-}
-
-
-void UDPLink::publish(IMC::Message& msg, const string& addr)
+void UDPLink::stamp(IMC::Message& msg)
 {
     msg.setSource(imc_src);
     msg.setSourceEntity(imc_id);
     msg.setDestination(0);
     msg.setTimeStamp(ros::Time::now().toSec());
+}
 
-    char out_buffer_[4096];
-    uint16_t rv = IMC::Packet::serialize(&msg, (uint8_t*)out_buffer_, sizeof(out_buffer_));
+void UDPLink::publish(IMC::Message& msg, const string& addr)
+{
+    stamp(msg);
 
-    udp::endpoint destination(address::from_string(addr), 6001);
-    socket.async_send_to(boost::asio::buffer(out_buffer_, rv), destination, handler);
+    // the buffer stays alive until the send completes
+    SendBufferPool::Buffer* buffer = send_buffers_.serialize(msg);
 
-    /*
-    myfile.open ("/tmp/test.lsf", ios::out | ios::app | ios::binary);
-    myfile.write(out_buffer_, rv);
-    myfile.flush();
-    myfile.close();
-    */
+    udp::endpoint destination(address::from_string(addr), 6001);
+    record(tx_recorder_, buffer->data.data(), buffer->data.size());
+    send(socket, buffer, destination);
 }
 
 void UDPLink::publish_multicast(IMC::Message& msg, const string& multicast_addr)
 {
-    msg.setSource(imc_src);
-    msg.setSourceEntity(imc_id);
-    msg.setDestination(0);
-    msg.setTimeStamp(ros::Time::now().toSec());
+    stamp(msg);
 
-    char out_buffer_[1024];
-    uint16_t rv = IMC::Packet::serialize(&msg, (uint8_t*)out_buffer_, sizeof(out_buffer_));
+    // one serialization shared by the sends to all announce ports
+    SendBufferPool::Buffer* buffer = send_buffers_.serialize(msg, announce_ports.size());
+    record(tx_recorder_, buffer->data.data(), buffer->data.size());
 
-    std::string message;
     for (int multicast_port : announce_ports)
     {
 		// std::cout << "Writing to port: " << multicast_port << std::endl;
         udp::endpoint destination(address::from_string(multicast_addr), multicast_port);
-        multicast_socket.async_send_to(boost::asio::buffer(out_buffer_, rv), destination, handler);
+        send(multicast_socket, buffer, destination);
+    }
+
+    // announces go out together rather than waiting for the flush timer
+    flush();
+}
+
+void UDPLink::publish_fragments(const uint8_t* packet, size_t size, const string& addr, size_t max_packet)
+{
+    IMC::MessagePart part;
+    stamp(part);
+    size_t overhead = part.getSerializationSize();
+    if (max_packet <= overhead) {
+        ROS_WARN("Cannot fragment IMC packets into %lu bytes", (unsigned long)max_packet);
+        return;
+    }
+
+    size_t chunk = max_packet - overhead;
+    size_t count = (size + chunk - 1) / chunk;
+    if (count > 255) {
+        ROS_WARN("IMC packet of %lu bytes needs %lu fragments, dropping it", (unsigned long)size, (unsigned long)count);
+        return;
+    }
+
+    part.uid = fragment_uid_++;
+    part.num_frags = count;
+    udp::endpoint destination(address::from_string(addr), 6001);
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t* begin = packet + i * chunk;
+        size_t length = std::min(chunk, size - i * chunk);
+        part.frag_number = i;
+        SendBufferPool::Buffer* buffer = send_buffers_.serialize_tail(part, length, [begin, length](uint8_t* ptr) {
+            std::memcpy(ptr, begin, length);
+        });
+        record(tx_recorder_, buffer->data.data(), buffer->data.size());
+        send(socket, buffer, destination);
+    }
+}
+
+void UDPLink::send(udp::socket& sock, SendBufferPool::Buffer* buffer, const udp::endpoint& destination)
+{
+    if (batch_size_ == 0) {
+        sock.async_send_to(boost::asio::buffer(buffer->data), destination,
+                           [this, buffer](const boost::system::error_code&, size_t) {
+            send_buffers_.complete(buffer);
+        });
+        return;
     }
 
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    send_queue_.push_back(QueuedSend{&sock, buffer, destination});
+    if (send_queue_.size() >= batch_size_) {
+        send_queue_locked();
+    }
+    else if (!flush_armed_) {
+        flush_armed_ = true;
+        flush_timer_.expires_from_now(boost::posix_time::microseconds((int64_t)(flush_interval_ * 1e6)));
+        flush_timer_.async_wait([this](const boost::system::error_code& error) {
+            if (!error) {
+                flush();
+            }
+        });
+    }
+}
+
+void UDPLink::flush()
+{
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    send_queue_locked();
+}
+
+bool UDPLink::open_recorder(const string& path, std::unique_ptr<LsfRecorder>& owner,
+                            std::atomic<LsfRecorder*>& recorder)
+{
+    if (owner) {
+        return false;
+    }
+    std::unique_ptr<LsfRecorder> opened(new LsfRecorder(path));
+    if (!opened->is_open()) {
+        ROS_WARN("Could not open %s for logging IMC traffic", path.c_str());
+        return false;
+    }
+    owner = std::move(opened);
+    recorder = owner.get();
+    return true;
+}
+
+bool UDPLink::record_to(const string& path)
+{
+    return open_recorder(path, rx_recorder_owner_, rx_recorder_);
+}
+
+bool UDPLink::record_sent_to(const string& path)
+{
+    return open_recorder(path, tx_recorder_owner_, tx_recorder_);
+}
+
+void UDPLink::send_queue_locked()
+{
+    flush_armed_ = false;
+#ifdef IMC_UDP_HAVE_MMSG
+    size_t begin = 0;
+    while (begin < send_queue_.size()) {
+        // one sendmmsg batch per run of datagrams on the same socket
+        udp::socket* sock = send_queue_[begin].socket;
+        size_t end = begin;
+        while (end < send_queue_.size() && end - begin < batch_size_ && send_queue_[end].socket == sock) {
+            const QueuedSend& q = send_queue_[end];
+            send_batch_.add(q.buffer->data.data(), q.buffer->data.size(), q.destination);
+            ++end;
+        }
+        size_t sent = begin + send_batch_.flush(sock->native_handle());
+
+        for (size_t i = begin; i < sent; ++i) {
+            send_buffers_.complete(send_queue_[i].buffer);
+        }
+        // whatever the kernel did not take (e.g. EAGAIN) goes the asynchronous way
+        for (size_t i = sent; i < end; ++i) {
+            SendBufferPool::Buffer* buffer = send_queue_[i].buffer;
+            sock->async_send_to(boost::asio::buffer(buffer->data), send_queue_[i].destination,
+                                [this, buffer](const boost::system::error_code&, size_t) {
+                send_buffers_.complete(buffer);
+            });
+        }
+        begin = end;
+    }
+#endif
+    send_queue_.clear();
 }
 
 void UDPLink::wait()
 {
+    if (batch_size_ > 0) {
+        // wait for readability only, handle_receive_batch drains the socket
+        socket.async_receive(boost::asio::null_buffers(),
+                             boost::bind(&UDPLink::handle_receive_batch,
+                                         this, boost::asio::placeholders::error));
+        return;
+    }
+
     socket.async_receive_from(boost::asio::buffer(recv_buffer),
                               remote_endpoint,
                               boost::bind(&UDPLink::handle_receive,
@@ -126,15 +278,100 @@ void UDPLink::handle_receive(const boost::system::error_code& error, size_t byte
     // it seems like the socket does not return the whole package (as evidenced by bytes_transferred being smaller than what wireshark captures).
     // so we are only receiving the payload here.
 
-    for (size_t i = 0; i < bytes_transferred; ++i) {
-        IMC::Message* m = parser_.parse(recv_buffer[i]);
-        if (m) {
-            recv_handler_(m);
-            delete m;
+    parse_datagram((const uint8_t*)recv_buffer.data(), bytes_transferred);
+
+    if (!should_shutdown) {
+        wait();
+    }
+}
+
+void UDPLink::handle_receive_batch(const boost::system::error_code& error)
+{
+    if (error) {
+        std::cout << "Receive failed: " << error.message() << "\n";
+        return;
+    }
+
+#ifdef IMC_UDP_HAVE_MMSG
+    while (true) {
+        int n = recv_batch_->receive(socket.native_handle());
+        if (n < 0) {
+            std::cout << "Receive failed: " << strerror(errno) << "\n";
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            parse_datagram(recv_batch_->data(i), recv_batch_->size(i));
+        }
+        if ((size_t)n < recv_batch_->capacity()) {
+            break; // drained
         }
     }
+#endif
 
     if (!should_shutdown) {
         wait();
     }
 }
+
+void UDPLink::parse_datagram(const uint8_t* data, size_t size)
+{
+    // a datagram carries whole IMC packets, so it is logged as is
+    record(rx_recorder_, data, size);
+    // parse them in place
+    parser_.parse(data, size, [this](IMC::Message* m) { dispatch(m); });
+}
+
+void UDPLink::dispatch(IMC::Message* m)
+{
+    if (worker_threads_ == 0) {
+        // hands the message back to the pool once the handler is done
+        IMC::MessagePool::Handle handle = message_pool_.wrap(m);
+        recv_handler_(handle.get());
+        return;
+    }
+
+    std::shared_ptr<IMC::Message> shared(m, IMC::MessagePool::Releaser(&message_pool_));
+    std::chrono::steady_clock::time_point queued = std::chrono::steady_clock::now();
+    auto job = [this, shared, queued]() {
+        record_latency(shared->getId(), queued);
+        recv_handler_(shared.get());
+    };
+
+    if (is_priority(m->getId())) {
+        priority_service_.post(job);
+        return;
+    }
+
+    std::unique_ptr<boost::asio::io_service::strand>& strand = peer_strands_[m->getSource()];
+    if (!strand) {
+        strand.reset(new boost::asio::io_service::strand(work_service_));
+    }
+    strand->post(job);
+}
+
+void UDPLink::record_latency(uint16_t id, std::chrono::steady_clock::time_point queued)
+{
+    double latency = std::chrono::duration<double>(std::chrono::steady_clock::now() - queued).count();
+    std::lock_guard<std::mutex> lock(latency_mutex_);
+    if (id >= latency_.size()) {
+        latency_.resize(id + 1);
+    }
+    LatencyAccumulator& acc = latency_[id];
+    ++acc.count;
+    acc.sum += latency;
+    acc.max = std::max(acc.max, latency);
+}
+
+std::vector<UDPLink::QueueLatency> UDPLink::take_queue_latency()
+{
+    std::vector<QueueLatency> stats;
+    std::lock_guard<std::mutex> lock(latency_mutex_);
+    for (size_t id = 0; id < latency_.size(); ++id) {
+        LatencyAccumulator& acc = latency_[id];
+        if (acc.count > 0) {
+            stats.push_back(QueueLatency{(uint16_t)id, acc.count, acc.sum / acc.count, acc.max});
+            acc = LatencyAccumulator();
+        }
+    }
+    return stats;
+}
@@ -0,0 +1,90 @@
+/* Copyright 2019 The SMaRC project (https://smarc.se/)
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <imc_tcp_link/unhandled_message_logger.h>
+
+#include <chrono>
+#include <iostream>
+#include <ros/ros.h>
+
+namespace {
+
+double now_seconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+UnhandledMessageLogger::UnhandledMessageLogger(double interval, size_t max_queue)
+    : interval_(interval), max_queue_(max_queue), stop_(false)
+{
+    thread_ = std::thread(&UnhandledMessageLogger::run, this);
+}
+
+UnhandledMessageLogger::~UnhandledMessageLogger()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+}
+
+void UnhandledMessageLogger::log(const IMC::Message* msg)
+{
+    uint16_t uid = msg->getId();
+    double now = now_seconds();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (uid >= last_logged_.size()) {
+        last_logged_.resize(uid + 1, -1e9);
+        suppressed_.resize(uid + 1, 0);
+    }
+    if (now - last_logged_[uid] < interval_ || queue_.size() >= max_queue_) {
+        ++suppressed_[uid];
+        return;
+    }
+    last_logged_[uid] = now;
+    queue_.emplace_back(std::unique_ptr<IMC::Message>(msg->clone()), suppressed_[uid]);
+    suppressed_[uid] = 0;
+    lock.unlock();
+    cv_.notify_one();
+}
+
+void UnhandledMessageLogger::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            return; // stopping
+        }
+        std::unique_ptr<IMC::Message> msg = std::move(queue_.front().first);
+        uint32_t suppressed = queue_.front().second;
+        queue_.pop_front();
+        lock.unlock();
+
+        ROS_INFO("Got tcp message with no configure callback, msgid: %u! (%u similar suppressed)",
+                 msg->getId(), suppressed);
+        // lets just print the whole message in json format if we can't parse it yet.
+        std::cout << "Message name: " << msg->getName() << std::endl << "Message JSON:" << std::endl;
+        // (ostream, indent)
+        msg->fieldsToJSON(std::cout, 4);
+        std::cout << std::endl;
+        std::cout << "---------------------" << std::endl;
+
+        lock.lock();
+    }
+}
@@ -0,0 +1,179 @@
+/* Copyright 2019 The SMaRC project (https://smarc.se/)
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+// Records datagrams the way the bridge logs received traffic and checks
+// that the index imc_replay builds, its packet selection and the replayed
+// datagrams give back exactly what was recorded.
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <gtest/gtest.h>
+
+#include <IMC/Base/Packet.hpp>
+#include <IMC/Spec/EstimatedState.hpp>
+#include <IMC/Spec/Heartbeat.hpp>
+#include <IMC/Spec/MessagePart.hpp>
+
+#include <imc_udp_link/lsf_index.h>
+#include <imc_udp_link/lsf_recorder.h>
+
+namespace {
+
+std::vector<uint8_t> serialize(IMC::Message& msg, uint16_t src, double time)
+{
+    msg.setSource(src);
+    msg.setTimeStamp(time);
+    std::vector<uint8_t> packet(msg.getSerializationSize());
+    packet.resize(IMC::Packet::serialize(&msg, packet.data(), packet.size()));
+    return packet;
+}
+
+std::vector<uint8_t> read_file(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+class LsfReplay : public ::testing::Test {
+
+protected:
+
+    void SetUp() override
+    {
+        path = ::testing::TempDir() + "test_lsf_replay.lsf";
+        std::remove(path.c_str());
+
+        IMC::EstimatedState state;
+        state.lat = 1.0459;
+        state.depth = 3.2f;
+        IMC::Heartbeat heartbeat;
+        IMC::MessagePart part;
+        part.uid = 7;
+        part.frag_number = 1;
+        part.num_frags = 3;
+        part.data.assign(300, 0x5a);
+
+        // not in time order, as datagrams from several systems arrive
+        packets.push_back(serialize(state, 10, 100.0));
+        packets.push_back(serialize(heartbeat, 20, 100.5));
+        packets.push_back(serialize(part, 20, 100.25));
+        state.depth = 4.0f;
+        packets.push_back(serialize(state, 20, 101.0));
+
+        LsfRecorder recorder(path, 64, 1 << 20, 0.01);
+        ASSERT_TRUE(recorder.is_open());
+        for (size_t i = 0; i < packets.size(); ++i) {
+            recorder.record(packets[i].data(), packets[i].size());
+            if (i == 1) {
+                // a truncated datagram, must be skipped by the index
+                recorder.record(packets[0].data(), 11);
+            }
+        }
+        EXPECT_EQ(0u, recorder.dropped());
+        // the destructor writes everything recorded
+    }
+
+    void TearDown() override
+    {
+        std::remove(path.c_str());
+    }
+
+    std::string path;
+    std::vector<std::vector<uint8_t> > packets;
+
+};
+
+} // namespace
+
+TEST_F(LsfReplay, IndexGivesBackRecordedPackets)
+{
+    std::vector<uint8_t> log = read_file(path);
+    LsfIndex index = build_lsf_index(log.data(), log.size());
+
+    ASSERT_EQ(packets.size(), index.entries.size());
+    EXPECT_EQ(11u, index.skipped);
+    for (size_t i = 0; i < packets.size(); ++i) {
+        const LsfIndexEntry& entry = index.entries[i];
+        ASSERT_EQ(packets[i].size(), entry.size);
+        EXPECT_TRUE(std::equal(packets[i].begin(), packets[i].end(), log.begin() + entry.offset)) << i;
+    }
+
+    EXPECT_EQ(IMC::EstimatedState::getIdStatic(), index.entries[0].id);
+    EXPECT_EQ(10, index.entries[0].src);
+    EXPECT_DOUBLE_EQ(100.0, index.entries[0].time);
+    EXPECT_EQ(IMC::MessagePart::getIdStatic(), index.entries[2].id);
+    EXPECT_EQ(2u, index.by_type[IMC::EstimatedState::getIdStatic()].size());
+
+    // fragments stay fragments, the bridge reassembles them on replay
+    IMC::Message* msg = IMC::Packet::deserialize(log.data() + index.entries[2].offset, index.entries[2].size);
+    ASSERT_NE(nullptr, msg);
+    const IMC::MessagePart* part = static_cast<const IMC::MessagePart*>(msg);
+    EXPECT_EQ(7, part->uid);
+    EXPECT_EQ(300u, part->data.size());
+    delete msg;
+}
+
+TEST_F(LsfReplay, SelectsByTypeAndSourceInTimeOrder)
+{
+    std::vector<uint8_t> log = read_file(path);
+    LsfIndex index = build_lsf_index(log.data(), log.size());
+
+    EXPECT_EQ(std::vector<size_t>({0, 2, 1, 3}), select_packets(index, {}, -1));
+    EXPECT_EQ(std::vector<size_t>({0, 3}), select_packets(index, {IMC::EstimatedState::getIdStatic()}, -1));
+    EXPECT_EQ(std::vector<size_t>({2, 1, 3}), select_packets(index, {}, 20));
+    EXPECT_EQ(std::vector<size_t>({1, 3}),
+              select_packets(index, {IMC::EstimatedState::getIdStatic(), IMC::Heartbeat::getIdStatic()}, 20));
+    EXPECT_TRUE(select_packets(index, {IMC::Heartbeat::getIdStatic()}, 10).empty());
+}
+
+TEST_F(LsfReplay, ReplayedDatagramsMatchRecording)
+{
+    std::vector<uint8_t> log = read_file(path);
+    LsfIndex index = build_lsf_index(log.data(), log.size());
+    std::vector<size_t> selected = select_packets(index, {}, -1);
+
+    // one datagram per packet, as imc_replay sends them
+    using boost::asio::ip::udp;
+    boost::asio::io_service io_service;
+    udp::socket bridge(io_service, udp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+    udp::socket replay(io_service, udp::endpoint(udp::v4(), 0));
+    for (size_t i : selected) {
+        const LsfIndexEntry& entry = index.entries[i];
+        replay.send_to(boost::asio::buffer(log.data() + entry.offset, entry.size), bridge.local_endpoint());
+    }
+
+    std::vector<uint8_t> datagram(65536);
+    for (size_t i : selected) {
+        size_t size = bridge.receive(boost::asio::buffer(datagram));
+        ASSERT_EQ(packets[i].size(), size);
+        EXPECT_TRUE(std::equal(packets[i].begin(), packets[i].end(), datagram.begin())) << i;
+
+        IMC::Message* msg = IMC::Packet::deserialize(datagram.data(), size);
+        ASSERT_NE(nullptr, msg);
+        EXPECT_EQ(index.entries[i].id, msg->getId());
+        EXPECT_EQ(index.entries[i].src, msg->getSource());
+        delete msg;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -46,11 +46,49 @@ class Dynamics
   // \brief Reset state.
   public: virtual void Reset();
 
+  /// \brief Numerical schemes available to nonlinear models.
+  public: enum Integrator
+  {
+    /// \brief Single explicit Euler step per update (legacy behaviour).
+    EULER,
+    /// \brief Classical Runge-Kutta, optionally split into fixed sub-steps.
+    RK4,
+    /// \brief RK4 sub-steps with step-doubling error control.
+    ADAPTIVE
+  };
+
+  /// \brief Read the optional integrator, maxStep and tolerance elements.
+  /// \return False if the sdf holds an unknown or inconsistent setting.
+  public: bool SetIntegrator(sdf::ElementPtr _sdf);
+
+  /// \brief Return the integration scheme in use.
+  public: Integrator GetIntegrator() const { return this->integrator; }
+
+  /// \brief Time derivative of the state for a constant command.
+  /// Only models advanced through Integrate() need to implement this.
+  protected: virtual double StateDerivative(double _state, double _cmd)
+  { return 0.0; }
+
+  /// \brief Advance the state by _dt holding _cmd constant.
+  protected: double Integrate(double _cmd, double _dt);
+
+  /// \brief Single classical Runge-Kutta step starting from _state.
+  private: double RK4Step(double _state, double _cmd, double _h);
+
   /// \brief Time of last state update.
   protected: double prevTime;
 
   /// \brief Latest state.
   protected: double state;
+
+  /// \brief Integration scheme used by Integrate().
+  protected: Integrator integrator = EULER;
+
+  /// \brief Largest sub-step in seconds (0 means one step per update).
+  protected: double maxStep = 0.0;
+
+  /// \brief Relative local error tolerance for the adaptive scheme.
+  protected: double tolerance = 1e-6;
 };
 
 /// \brief Function pointer to create a certain thruster dynamics object.
@@ -110,6 +148,9 @@ class DynamicsZeroOrder : public Dynamics
 
 
 /// \brief First-order dynamic system.
+///
+/// The state is advanced with the exact solution for a command held
+/// constant over the step, so it stays accurate for any step size.
 class DynamicsFirstOrder : public Dynamics
 {
   /// \brief Create thruster model of this type with parameter values from sdf.
@@ -151,6 +192,9 @@ class ThrusterDynamicsYoerger : public Dynamics
   /// \brief Update dynamical model given input value and time.
   public: virtual double update(double _cmd, double _t);
 
+  /// \brief Right-hand side of the model's differential equation.
+  protected: virtual double StateDerivative(double _state, double _cmd);
+
   /// \brief Register this model with the factory.
   private: REGISTER_DYNAMICS(ThrusterDynamicsYoerger);
 
@@ -184,6 +228,9 @@ class ThrusterDynamicsBessa : public Dynamics
   /// \brief Update dynamical model given input value and time.
   public: virtual double update(double _cmd, double _t);
 
+  /// \brief Right-hand side of the model's differential equation.
+  protected: virtual double StateDerivative(double _state, double _cmd);
+
   /// \brief Register this model with the factory.
   private: REGISTER_DYNAMICS(ThrusterDynamicsBessa);
 
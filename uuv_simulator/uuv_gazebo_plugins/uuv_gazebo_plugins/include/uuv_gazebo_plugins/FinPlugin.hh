@@ -87,6 +87,9 @@ class FinPlugin : public ModelPlugin
     /// \brief Force component calculated from the lift and drag module
     protected: ignition::math::Vector3d finForce;
 
+    /// \brief Torque component calculated from the lift and drag module
+    protected: ignition::math::Vector3d finTorque;
+
     /// \brief Latest input command.
     protected: double inputCommand;
 
@@ -205,9 +205,52 @@ class HMFossen : public HydrodynamicModel
   /// \brief Returns the added-mass matrix with the scaling and offset
   protected: Eigen::Matrix6d GetAddedMass() const;
 
+  /// \brief Computes the added-mass forces and torques with a semi-implicit
+  /// correction. The generalized force that accelerated the link in the
+  /// previous step is reconstructed from the rigid-body mass matrix and the
+  /// added-mass force applied then, and the added-mass force is computed as
+  /// -Ma * (Mrb + Ma)^-1 * tau. Unlike the explicit mode, this does not feed
+  /// the lagged acceleration back into itself and remains stable when the
+  /// added mass is large compared to the link's mass or the physics step is
+  /// increased.
+  protected: Eigen::Vector6d ComputeSemiImplicitAddedMass(
+    const Eigen::Vector6d& _velRel, double _time);
+
+  /// \brief Returns the semi-implicit added-mass force from the acceleration
+  /// _acc of the previous step and the added-mass force _lastForce applied
+  /// during it
+  public: static Eigen::Vector6d SemiImplicitAddedMassForce(
+    const Eigen::Matrix6d& _Mrb, const Eigen::Matrix6d& _gain,
+    const Eigen::Vector6d& _acc, const Eigen::Vector6d& _lastForce);
+
+  /// \brief Returns the gain Ma * (Mrb + Ma)^-1 of the semi-implicit
+  /// added-mass mode
+  public: static Eigen::Matrix6d SemiImplicitAddedMassGain(
+    const Eigen::Matrix6d& _Mrb, const Eigen::Matrix6d& _Ma);
+
+  /// \brief Updates the rigid-body mass matrix from the link's inertial and
+  /// the gain Ma * (Mrb + Ma)^-1 used by the semi-implicit added-mass mode
+  protected: void UpdateAddedMassGain();
+
   /// \brief Added-mass matrix
   protected: Eigen::Matrix6d Ma;
 
+  /// \brief If true, the added-mass forces are computed with the
+  /// semi-implicit correction instead of the filtered acceleration
+  protected: bool semiImplicitAddedMass;
+
+  /// \brief Flag set to false when the added-mass gain has to be recomputed
+  protected: bool addedMassGainValid;
+
+  /// \brief Rigid-body mass matrix of the link wrt the link frame (NED)
+  protected: Eigen::Matrix6d Mrb;
+
+  /// \brief Gain Ma * (Mrb + Ma)^-1 for the semi-implicit added-mass mode
+  protected: Eigen::Matrix6d addedMassGain;
+
+  /// \brief Added-mass forces and torques applied in the last step
+  protected: Eigen::Vector6d lastAddedMassForce;
+
   /// \brief Scaling of the added-mass matrix
   protected: double scalingAddedMass;
 
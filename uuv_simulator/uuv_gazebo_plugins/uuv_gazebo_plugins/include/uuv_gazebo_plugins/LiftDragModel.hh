@@ -21,6 +21,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include <gazebo/gazebo.hh>
 
@@ -48,6 +49,16 @@ class LiftDrag
   public: virtual ignition::math::Vector3d compute(
     const ignition::math::Vector3d &_velL) = 0;
 
+  /// \brief Compute the lift and drag force and the pitching moment in the
+  /// fin's frame. Models without a moment description return zero torque.
+  public: virtual void compute(const ignition::math::Vector3d &_velL,
+                               ignition::math::Vector3d &_forceL,
+                               ignition::math::Vector3d &_torqueL)
+  {
+    _forceL = this->compute(_velL);
+    _torqueL = ignition::math::Vector3d::Zero;
+  }
+
   /// \brief Return paramater in vector form for the given tag
   public: virtual bool GetParam(std::string _tag,
     double& _output) = 0;
@@ -105,6 +116,9 @@ class LiftDragQuadratic : public LiftDrag
   /// \brief Return (derived) type of dynamic system.
   public: virtual std::string GetType() { return IDENTIFIER; }
 
+  /// \brief Keep the base class overloads of compute visible.
+  public: using LiftDrag::compute;
+
   /// \brief Compute the lift and drag force.
   public: virtual ignition::math::Vector3d compute(const ignition::math::Vector3d &velL);
 
@@ -143,6 +157,9 @@ class LiftDragTwoLines: public LiftDrag
   /// \brief Return (derived) type of dynamic system.
   public: virtual std::string GetType() { return IDENTIFIER; }
 
+  /// \brief Keep the base class overloads of compute visible.
+  public: using LiftDrag::compute;
+
   /// \brief Compute the lift and drag force.
   public: virtual ignition::math::Vector3d compute(const ignition::math::Vector3d &_velL);
 
@@ -191,6 +208,95 @@ class LiftDragTwoLines: public LiftDrag
       cla(_cla), claStall(_claStall),
       cda(_cda), cdaStall(_cdaStall) {}
 };
+
+/// \brief Lift&drag model interpolating tabulated lift, drag and (optionally)
+/// moment coefficients over the angle of attack. Several tables can be given
+/// for different Reynolds numbers, in which case the coefficients are also
+/// interpolated over the Reynolds number of the current flow. The tables are
+/// resampled at load time into arrays with uniform angle spacing, so that the
+/// lookup at each update has constant cost.
+class LiftDragTable: public LiftDrag
+{
+  /// \brief Create lift&drag model of this type with parameter values from
+  /// sdf.
+  public: static LiftDrag* create(sdf::ElementPtr _sdf);
+
+  /// \brief Return (derived) type of dynamic system.
+  public: virtual std::string GetType() { return IDENTIFIER; }
+
+  /// \brief Keep the base class overloads of compute visible.
+  public: using LiftDrag::compute;
+
+  /// \brief Compute the lift and drag force.
+  public: virtual ignition::math::Vector3d compute(
+    const ignition::math::Vector3d &_velL);
+
+  /// \brief Compute the lift and drag force and the pitching moment.
+  public: virtual void compute(const ignition::math::Vector3d &_velL,
+                               ignition::math::Vector3d &_forceL,
+                               ignition::math::Vector3d &_torqueL);
+
+  /// \brief Register this model with the factory.
+  private: REGISTER_LIFTDRAG(LiftDragTable);
+
+  /// \brief Unique identifier for this dynamical model.
+  private: static const std::string IDENTIFIER;
+
+  /// \brief Return paramater in scalar form for the given tag
+  public: virtual bool GetParam(std::string _tag, double& _output);
+
+  /// \brief Return list of all parameters
+  public: virtual std::map<std::string, double> GetListParams();
+
+  /// \brief Reads a table from its SDF element, either from the alpha, cl,
+  /// cd and cm elements or from the file given in the file element. Returns
+  /// false if the table is invalid.
+  protected: static bool ReadTable(sdf::ElementPtr _sdf,
+                                   std::vector<double> &_alpha,
+                                   std::vector<double> &_cl,
+                                   std::vector<double> &_cd,
+                                   std::vector<double> &_cm);
+
+  /// \brief Interpolates the lift, drag and moment coefficients for the
+  /// angle of attack _alpha and the Reynolds number _re
+  protected: void GetCoefficients(double _alpha, double _re, double &_cl,
+                                  double &_cd, double &_cm) const;
+
+  /// \brief Airfoil area.
+  protected: double area;
+
+  /// \brief Fluid density.
+  protected: double fluidDensity;
+
+  /// \brief Chord length, used for the moment and the Reynolds number.
+  protected: double chord;
+
+  /// \brief Kinematic viscosity of the fluid, used for the Reynolds number.
+  protected: double kinematicViscosity;
+
+  /// \brief Angle of attack of the first sample of the resampled tables.
+  protected: double alphaMin;
+
+  /// \brief Angle spacing of the resampled tables.
+  protected: double alphaStep;
+
+  /// \brief Number of samples per resampled table.
+  protected: int numSamples;
+
+  /// \brief Reynolds numbers of the tables, in increasing order.
+  protected: std::vector<double> reynolds;
+
+  /// \brief Resampled coefficients of all tables, stored as consecutive
+  /// (cl, cd, cm) triplets for each angle sample, one table after the other.
+  protected: std::vector<double> coefficients;
+
+  /// \brief Constructor.
+  private: LiftDragTable(double _area, double _fluidDensity, double _chord,
+                         double _kinematicViscosity)
+    : LiftDrag(), area(_area), fluidDensity(_fluidDensity), chord(_chord),
+      kinematicViscosity(_kinematicViscosity), alphaMin(0.0),
+      alphaStep(1.0), numSamples(0) {}
+};
 }
 
 #endif
@@ -0,0 +1,180 @@
+// Copyright (c) 2016 The UUV Simulator Authors.
+// All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/// \file ThrusterArrayPlugin.hh
+/// \brief Model plugin for all thrusters of a vehicle, updated in a single
+/// callback
+
+#ifndef __UUV_GAZEBO_PLUGINS_THRUSTER_ARRAY_PLUGIN_HH__
+#define __UUV_GAZEBO_PLUGINS_THRUSTER_ARRAY_PLUGIN_HH__
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <gazebo/gazebo.hh>
+#include <gazebo/transport/TransportTypes.hh>
+
+#include <sdf/sdf.hh>
+
+#include <uuv_gazebo_plugins/ThrusterConversionFcn.hh>
+#include <uuv_gazebo_plugins/Dynamics.hh>
+
+#include "DoubleArray.pb.h"
+
+namespace gazebo
+{
+/// \brief Definition of a pointer to the floating point array message
+typedef const boost::shared_ptr<
+  const uuv_gazebo_plugins_msgs::msgs::DoubleArray> ConstDoubleArrayPtr;
+
+/// \brief Plugin that owns all thrusters of a model. Instead of one update
+/// callback, input subscriber and thrust publisher per thruster, the inputs
+/// for all thrusters are received in one vector message, all thrusters are
+/// updated in a single world update callback and the thrust forces are
+/// published in one message at a configurable rate.
+///
+/// Each thruster is described by a <thruster> element with the same
+/// parameters as the ThrusterPlugin. The position of a thruster's input and
+/// thrust force in the vector messages is its thrusterID.
+///
+/// The inputs and thrust forces are only exchanged over Gazebo topics. There
+/// is no ROS wrapper or vehicle xacro macro for this plugin yet, so the
+/// thruster manager cannot drive it; vehicles using the thruster manager
+/// still need one ThrusterROSPlugin per thruster.
+class ThrusterArrayPlugin : public ModelPlugin
+{
+  /// \brief Constructor
+  public: ThrusterArrayPlugin();
+
+  /// \brief Destructor
+  public: virtual ~ThrusterArrayPlugin();
+
+  // Documentation inherited.
+  public: virtual void Load(physics::ModelPtr _model,
+                            sdf::ElementPtr _sdf);
+
+  // Documentation inherited.
+  public: virtual void Init();
+
+  /// \brief Custom plugin reset behavior.
+  public: virtual void Reset();
+
+  /// \brief Update the simulation state.
+  /// \param[in] _info Information used in the update event.
+  public: void Update(const common::UpdateInfo &_info);
+
+  /// \brief Computes the dynamic state and thrust force of all thrusters
+  /// from the latest input commands.
+  /// \param[in] _time Simulation time in seconds
+  protected: void UpdateThrusters(double _time);
+
+  /// \brief Callback for the input topic subscriber
+  protected: void UpdateInput(ConstDoubleArrayPtr &_msg);
+
+  /// \brief Sizes the input and thrust vectors for the loaded thrusters
+  protected: void AllocateVectors();
+
+  /// \brief Reads the parameters of a thruster from its SDF element, returns
+  /// false if the description is invalid
+  protected: bool LoadThruster(physics::ModelPtr _model,
+                               sdf::ElementPtr _sdf);
+
+  /// \brief Description and state of a single thruster
+  protected: struct Thruster
+  {
+    /// \brief Thruster dynamic model
+    std::shared_ptr<Dynamics> dynamics;
+
+    /// \brief Thruster conversion function
+    std::shared_ptr<ConversionFunction> conversionFunction;
+
+    /// \brief Pointer to the thruster link
+    physics::LinkPtr link;
+
+    /// \brief Optional: The rotor joint, used for visualization
+    physics::JointPtr joint;
+
+    /// \brief The axis about which the thruster rotates
+    ignition::math::Vector3d axis;
+
+    /// \brief Thruster ID, index in the input and thrust vectors
+    int id;
+
+    /// \brief Commands less than this value will be clamped.
+    double clampMin;
+
+    /// \brief Commands greater than this value will be clamped.
+    double clampMax;
+
+    /// \brief Minimum thrust force output
+    double thrustMin;
+
+    /// \brief Maximum thrust force output
+    double thrustMax;
+
+    /// \brief Gain factor: Desired angular velocity = command * gain
+    double gain;
+
+    /// \brief Output thrust efficiency factor of the thruster
+    double thrustEfficiency;
+
+    /// \brief Propeller angular velocity efficiency term
+    double propellerEfficiency;
+
+    /// \brief Dynamic state of the last update
+    double dynamicState;
+  };
+
+  /// \brief All thrusters of the model
+  protected: std::vector<Thruster> thrusters;
+
+  /// \brief Latest input commands, indexed by thruster ID
+  protected: std::vector<double> inputCommands;
+
+  /// \brief Copy of the input commands used during an update
+  protected: std::vector<double> currentInputs;
+
+  /// \brief Latest thrust forces in [N], indexed by thruster ID
+  protected: std::vector<double> thrustForces;
+
+  /// \brief Mutex for the input commands written by the subscriber
+  protected: std::mutex inputLock;
+
+  /// \brief Rate in Hz at which the thrust forces are published, if zero
+  /// they are published at every update
+  protected: double thrustPublishRate;
+
+  /// \brief Simulation time of the last published thrust message
+  protected: common::Time lastThrustPublish;
+
+  /// \brief Update event
+  protected: event::ConnectionPtr updateConnection;
+
+  /// \brief Gazebo node
+  protected: transport::NodePtr node;
+
+  /// \brief Subscriber to the input vector topic.
+  protected: transport::SubscriberPtr commandSubscriber;
+
+  /// \brief Publisher to the output thrust vector topic
+  protected: transport::PublisherPtr thrustTopicPublisher;
+
+  /// \brief Preallocated thrust message
+  protected: uuv_gazebo_plugins_msgs::msgs::DoubleArray thrustMsg;
+};
+}
+#endif  // __UUV_GAZEBO_PLUGINS_THRUSTER_ARRAY_PLUGIN_HH__
@@ -186,6 +186,17 @@ class ConversionFunctionLinearInterp: public ConversionFunction
 
   /// \brief Lookup table maps input values -> output values.
   private: std::map<double, double> lookupTable;
+
+  /// \brief Sorted input values of the lookup table, stored contiguously
+  /// for the interpolation in convert()
+  private: std::vector<double> inputValues;
+
+  /// \brief Output values matching inputValues
+  private: std::vector<double> outputValues;
+
+  /// \brief Inverse of the spacing between input values if they are
+  /// uniformly spaced, zero otherwise (binary search is used instead)
+  private: double invInputStep;
 };
 }
 
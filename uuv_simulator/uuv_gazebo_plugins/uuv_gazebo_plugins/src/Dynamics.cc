@@ -15,6 +15,9 @@
 
 #include <gazebo/gazebo.hh>
 
+#include <algorithm>
+#include <cmath>
+
 #include <uuv_gazebo_plugins/Dynamics.hh>
 
 namespace gazebo {
@@ -26,6 +29,106 @@ void Dynamics::Reset()
   this->state = 0.;
 }
 
+/////////////////////////////////////////////////
+bool Dynamics::SetIntegrator(sdf::ElementPtr _sdf)
+{
+  if (_sdf->HasElement("integrator"))
+  {
+    std::string name = _sdf->Get<std::string>("integrator");
+    if (name == "euler")
+      this->integrator = EULER;
+    else if (name == "rk4")
+      this->integrator = RK4;
+    else if (name == "adaptive")
+      this->integrator = ADAPTIVE;
+    else
+    {
+      std::cerr << "Dynamics: unknown integrator " << name
+                << ", expected euler, rk4 or adaptive" << std::endl;
+      return false;
+    }
+  }
+
+  if (_sdf->HasElement("maxStep"))
+    this->maxStep = _sdf->Get<double>("maxStep");
+  if (_sdf->HasElement("tolerance"))
+    this->tolerance = _sdf->Get<double>("tolerance");
+
+  if (this->maxStep < 0.0 || this->tolerance <= 0.0)
+  {
+    std::cerr << "Dynamics: maxStep must be non-negative and tolerance"
+              << " positive" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////
+double Dynamics::RK4Step(double _state, double _cmd, double _h)
+{
+  double k1 = this->StateDerivative(_state, _cmd);
+  double k2 = this->StateDerivative(_state + 0.5*_h*k1, _cmd);
+  double k3 = this->StateDerivative(_state + 0.5*_h*k2, _cmd);
+  double k4 = this->StateDerivative(_state + _h*k3, _cmd);
+  return _state + _h*(k1 + 2.0*k2 + 2.0*k3 + k4)/6.0;
+}
+
+/////////////////////////////////////////////////
+double Dynamics::Integrate(double _cmd, double _dt)
+{
+  if (_dt <= 0.0)
+    return this->state;
+
+  double x = this->state;
+
+  if (this->integrator == EULER)
+    return x + _dt*this->StateDerivative(x, _cmd);
+
+  if (this->integrator == RK4)
+  {
+    int n = 1;
+    if (this->maxStep > 0.0)
+      n = std::max(1, static_cast<int>(std::ceil(_dt/this->maxStep)));
+    double h = _dt/n;
+    for (int i = 0; i < n; i++)
+      x = this->RK4Step(x, _cmd, h);
+    return x;
+  }
+
+  // Adaptive: compare one full step against two half steps. The
+  // difference estimates the local error of the half-step result, which is
+  // then improved by Richardson extrapolation.
+  double h = _dt;
+  if (this->maxStep > 0.0)
+    h = std::min(h, this->maxStep);
+  const double minStep = 1e-6*_dt;
+  double t = 0.0;
+  while (t < _dt)
+  {
+    h = std::min(h, _dt - t);
+    double full = this->RK4Step(x, _cmd, h);
+    double half = this->RK4Step(this->RK4Step(x, _cmd, 0.5*h), _cmd, 0.5*h);
+    double err = std::abs(half - full)/15.0;
+    double scale = this->tolerance*(1.0 + std::abs(half));
+
+    if (err <= scale || h <= minStep)
+    {
+      x = half + (half - full)/15.0;
+      t += h;
+      double grow = err > 0.0 ? 0.9*std::pow(scale/err, 0.2) : 4.0;
+      h *= std::min(4.0, grow);
+      if (this->maxStep > 0.0)
+        h = std::min(h, this->maxStep);
+    }
+    else
+    {
+      h *= std::max(0.1, 0.9*std::pow(scale/err, 0.25));
+      h = std::max(h, minStep);
+    }
+  }
+  return x;
+}
+
 /////////////////////////////////////////////////
 Dynamics* DynamicsFactory::CreateDynamics(
     sdf::ElementPtr _sdf)
@@ -115,6 +218,8 @@ double DynamicsFirstOrder::update(double _cmd, double _t)
   }
 
   double dt = _t - prevTime;
+  if (dt <= 0.0)
+    return state;
 
   double alpha = std::exp(-dt/tau);
   state = state*alpha + (1.0 - alpha)*_cmd;
@@ -153,7 +258,14 @@ Dynamics* ThrusterDynamicsYoerger::create(sdf::ElementPtr _sdf)
     return NULL;
   }
   double beta = _sdf->Get<double>("beta");
-  return new ThrusterDynamicsYoerger(alpha, beta);
+
+  Dynamics* dyn = new ThrusterDynamicsYoerger(alpha, beta);
+  if (!dyn->SetIntegrator(_sdf))
+  {
+    delete dyn;
+    return NULL;
+  }
+  return dyn;
 }
 
 /////////////////////////////////////////////////
@@ -167,11 +279,19 @@ double ThrusterDynamicsYoerger::update(double _cmd, double _t)
 
   double dt = _t - prevTime;
 
-  state += dt*(beta*_cmd - alpha*state*std::abs(state));
+  state = this->Integrate(_cmd, dt);
+
+  prevTime = _t;
 
   return state;
 }
 
+/////////////////////////////////////////////////
+double ThrusterDynamicsYoerger::StateDerivative(double _state, double _cmd)
+{
+  return beta*_cmd - alpha*_state*std::abs(_state);
+}
+
 /////////////////////////////////////////////////
 ThrusterDynamicsYoerger::ThrusterDynamicsYoerger(double _alpha, double _beta)
   : Dynamics(), alpha(_alpha), beta(_beta)
@@ -221,11 +341,17 @@ Dynamics* ThrusterDynamicsBessa::create(sdf::ElementPtr _sdf)
                  << std::endl;
     return NULL;
   }
-  return new ThrusterDynamicsBessa(_sdf->Get<double>("Jmsp"),
-                                   _sdf->Get<double>("Kv1"),
-                                   _sdf->Get<double>("Kv2"),
-                                   _sdf->Get<double>("Kt"),
-                                   _sdf->Get<double>("Rm"));
+  Dynamics* dyn = new ThrusterDynamicsBessa(_sdf->Get<double>("Jmsp"),
+                                            _sdf->Get<double>("Kv1"),
+                                            _sdf->Get<double>("Kv2"),
+                                            _sdf->Get<double>("Kt"),
+                                            _sdf->Get<double>("Rm"));
+  if (!dyn->SetIntegrator(_sdf))
+  {
+    delete dyn;
+    return NULL;
+  }
+  return dyn;
 }
 
 /////////////////////////////////////////////////
@@ -239,12 +365,19 @@ double ThrusterDynamicsBessa::update(double _cmd, double _t)
 
   double dt = _t - prevTime;
 
-  state += dt*(_cmd*Kt/Rm - Kv1*state
-                - Kv2*state*std::abs(state))/Jmsp;
+  state = this->Integrate(_cmd, dt);
+
+  prevTime = _t;
 
   return state;
 }
 
+/////////////////////////////////////////////////
+double ThrusterDynamicsBessa::StateDerivative(double _state, double _cmd)
+{
+  return (_cmd*Kt/Rm - Kv1*_state - Kv2*_state*std::abs(_state))/Jmsp;
+}
+
 /////////////////////////////////////////////////
 ThrusterDynamicsBessa::ThrusterDynamicsBessa(double _Jmsp, double _Kv1,
                                              double _Kv2, double _Kt,
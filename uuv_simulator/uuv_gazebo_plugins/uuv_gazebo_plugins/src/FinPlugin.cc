@@ -174,9 +174,11 @@ void FinPlugin::OnUpdate(const common::UpdateInfo &_info)
   ignition::math::Vector3d velInLDPlaneL = finPose.Rot().RotateVectorReverse(velInLDPlaneI);
 
   // Compute lift and drag forces:
-  this->finForce = this->liftdrag->compute(velInLDPlaneL);
+  this->liftdrag->compute(velInLDPlaneL, this->finForce, this->finTorque);
 
   this->link->AddRelativeForce(this->finForce);
+  if (this->finTorque != ignition::math::Vector3d::Zero)
+    this->link->AddRelativeTorque(this->finTorque);
   // Apply forces at cg (with torques for position shift).
 
   // Apply new fin angle. Do this last since this sets link's velocity to zero.
@@ -16,6 +16,8 @@
 #include <gazebo/gazebo.hh>
 #include <uuv_gazebo_plugins/HydrodynamicModel.hh>
 
+#include <eigen3/Eigen/LU>
+
 namespace gazebo
 {
 /////////////////////////////////////////////////
@@ -27,6 +29,7 @@ HydrodynamicModel::HydrodynamicModel(sdf::ElementPtr _sdf,
   // Initialize filtered acceleration & last velocity
   this->filteredAcc.setZero();
   this->lastVelRel.setZero();
+  this->lastTime = 0.0;
 
   // Set volume
   if (_sdf->HasElement("volume"))
@@ -304,6 +307,28 @@ HMFossen::HMFossen(sdf::ElementPtr _sdf,
   // Set the offset of the linear damping coefficients to default value
   this->offsetNonLinDamping = 0.0;
 
+  // Select how the added-mass forces are computed. The default (explicit)
+  // mode uses the filtered acceleration of the previous step, the
+  // semi-implicit mode allows larger physics step sizes for vehicles whose
+  // added mass is large in comparison to their mass
+  this->semiImplicitAddedMass = false;
+  if (modelParams->HasElement("added_mass_integration"))
+  {
+    std::string mode = modelParams->Get<std::string>("added_mass_integration");
+    if (!mode.compare("semi_implicit"))
+      this->semiImplicitAddedMass = true;
+    else if (mode.compare("explicit"))
+      gzerr << "HMFossen: Invalid added-mass integration mode <" << mode
+        << ">, options are explicit or semi_implicit" << std::endl;
+  }
+  gzmsg << "HMFossen: Added-mass integration mode = " <<
+    (this->semiImplicitAddedMass ? "semi_implicit" : "explicit") << std::endl;
+
+  this->addedMassGainValid = false;
+  this->Mrb.setZero();
+  this->addedMassGain.setZero();
+  this->lastAddedMassForce.setZero();
+
   // Adding the volume to the parameter list
   this->params.push_back("volume");
   // Add volume's scaling factor to the parameter list
@@ -396,9 +421,6 @@ void HMFossen::ApplyHydrodynamicForces(
   // Update damping matrix
   this->ComputeDampingMatrix(velRel, this->D);
 
-  // Filter acceleration (see issue explanation above)
-  this->ComputeAcc(velRel, _time, 0.3);
-
   // We can now compute the additional forces/torques due to thisdynamic
   // effects based on Eq. 8.136 on p.222 of Fossen: Handbook of Marine Craft ...
 
@@ -406,7 +428,17 @@ void HMFossen::ApplyHydrodynamicForces(
   Eigen::Vector6d damping = -this->D * velRel;
 
   // Added-mass forces and torques
-  Eigen::Vector6d added = -this->GetAddedMass() * this->filteredAcc;
+  Eigen::Vector6d added;
+  if (this->semiImplicitAddedMass)
+  {
+    added = this->ComputeSemiImplicitAddedMass(velRel, _time);
+  }
+  else
+  {
+    // Filter acceleration (see issue explanation above)
+    this->ComputeAcc(velRel, _time, 0.3);
+    added = -this->GetAddedMass() * this->filteredAcc;
+  }
 
   // Added Coriolis term
   Eigen::Vector6d cor = -this->Ca * velRel;
@@ -493,6 +525,103 @@ Eigen::Matrix6d HMFossen::GetAddedMass() const
     (this->Ma + this->offsetAddedMass * Eigen::Matrix6d::Identity());
 }
 
+/////////////////////////////////////////////////
+Eigen::Vector6d HMFossen::ComputeSemiImplicitAddedMass(
+  const Eigen::Vector6d& _velRel, double _time)
+{
+  double dt = _time - this->lastTime;
+
+  // Reuse the last force if the update was called twice for the same step
+  if (dt <= 0.0)
+    return this->lastAddedMassForce;
+
+  if (!this->addedMassGainValid)
+    this->UpdateAddedMassGain();
+
+  Eigen::Vector6d acc = (_velRel - this->lastVelRel) / dt;
+  this->lastAddedMassForce = SemiImplicitAddedMassForce(this->Mrb,
+    this->addedMassGain, acc, this->lastAddedMassForce);
+
+  this->lastTime = _time;
+  this->lastVelRel = _velRel;
+
+  return this->lastAddedMassForce;
+}
+
+/////////////////////////////////////////////////
+Eigen::Vector6d HMFossen::SemiImplicitAddedMassForce(
+  const Eigen::Matrix6d& _Mrb, const Eigen::Matrix6d& _gain,
+  const Eigen::Vector6d& _acc, const Eigen::Vector6d& _lastForce)
+{
+  // The acceleration of the last step was computed by the physics engine
+  // from Mrb * acc + Crb(v) * v = tau + tauAdded, where tauAdded is the
+  // added-mass force applied in that step and tau includes all other forces
+  // and torques (thrusters, damping, added Coriolis, restoring, ...).
+  //
+  // With added mass, the same velocity and forces would give
+  // (Mrb + Ma) * acc' + Crb(v) * v = tau, so
+  // acc' = (Mrb + Ma)^-1 * (tau - Crb(v) * v)
+  //      = (Mrb + Ma)^-1 * (Mrb * acc - tauAdded).
+  // The rigid-body Coriolis term is part of both equations and cancels, it
+  // does not have to be computed here. The added-mass force is -Ma * acc'.
+  // Since the previous added-mass force cancels out as well, the estimate
+  // does not depend on its own history and cannot start oscillating.
+  return -_gain * (_Mrb * _acc - _lastForce);
+}
+
+/////////////////////////////////////////////////
+Eigen::Matrix6d HMFossen::SemiImplicitAddedMassGain(
+  const Eigen::Matrix6d& _Mrb, const Eigen::Matrix6d& _Ma)
+{
+  // Ma * (Mrb + Ma)^-1, computed as the transposed solution of
+  // (Mrb + Ma)^T * X^T = Ma^T
+  return (_Mrb + _Ma).transpose().fullPivLu().solve(
+    _Ma.transpose()).transpose();
+}
+
+/////////////////////////////////////////////////
+void HMFossen::UpdateAddedMassGain()
+{
+  double mass;
+  ignition::math::Matrix3d moi;
+  ignition::math::Pose3d cogPose;
+#if GAZEBO_MAJOR_VERSION >= 8
+  physics::InertialPtr inertial = this->link->GetInertial();
+  mass = inertial->Mass();
+  moi = inertial->MOI();
+  cogPose = inertial->Pose();
+#else
+  physics::InertialPtr inertial = this->link->GetInertial();
+  mass = inertial->GetMass();
+  moi = ignition::math::Matrix3d(
+    inertial->GetIXX(), inertial->GetIXY(), inertial->GetIXZ(),
+    inertial->GetIXY(), inertial->GetIYY(), inertial->GetIYZ(),
+    inertial->GetIXZ(), inertial->GetIYZ(), inertial->GetIZZ());
+  cogPose = inertial->GetPose().Ign();
+#endif
+
+  // Inertia tensor wrt the link frame, using the parallel axis theorem for
+  // the offset of the center of gravity
+  Eigen::Matrix3d rot = ToEigen(ignition::math::Matrix3d(cogPose.Rot()));
+  Eigen::Matrix3d Sg = CrossProductOperator(cogPose.Pos());
+  Eigen::Matrix3d Io = rot * ToEigen(moi) * rot.transpose() - mass * Sg * Sg;
+
+  // Rigid-body mass matrix in Gazebo's link frame (Fossen, 2011)
+  Eigen::Matrix6d M;
+  M << mass * Eigen::Matrix3d::Identity(), -mass * Sg,
+       mass * Sg, Io;
+
+  // Convert it to comply with the NED reference frame
+  Eigen::Vector6d ned;
+  ned << 1, -1, -1, 1, -1, -1;
+  this->Mrb = ned.asDiagonal() * M * ned.asDiagonal();
+
+  this->addedMassGain = SemiImplicitAddedMassGain(this->Mrb,
+    this->GetAddedMass());
+
+  this->addedMassGainValid = true;
+}
+
 /////////////////////////////////////////////////
 bool HMFossen::GetParam(std::string _tag, std::vector<double>& _output)
 {
@@ -591,6 +720,7 @@ bool HMFossen::SetParam(std::string _tag, double _input)
     if (_input < 0)
       return false;
     this->scalingAddedMass = _input;
+    this->addedMassGainValid = false;
   }
   else if (!_tag.compare("scaling_damping"))
   {
@@ -607,7 +737,10 @@ bool HMFossen::SetParam(std::string _tag, double _input)
   else if (!_tag.compare("offset_volume"))
     this->offsetVolume = _input;
   else if (!_tag.compare("offset_added_mass"))
+  {
     this->offsetAddedMass = _input;
+    this->addedMassGainValid = false;
+  }
   else if (!_tag.compare("offset_linear_damping"))
     this->offsetLinearDamping = _input;
   else if (!_tag.compare("offset_lin_forward_speed_damping"))
@@ -0,0 +1,221 @@
+// Copyright (c) 2016 The UUV Simulator Authors.
+// All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <iostream>
+#include <gtest/gtest.h>
+#include <eigen3/Eigen/LU>
+#include <uuv_gazebo_plugins/HydrodynamicModel.hh>
+
+/// \brief Coriolis matrix of a symmetric mass matrix, eq. 6.43 on p. 120 in
+/// Fossen, "Handbook of Marine Craft and Hydrodynamics and Motion Control"
+Eigen::Matrix6d CoriolisMatrix(const Eigen::Matrix6d& _M,
+                               const Eigen::Vector6d& _vel)
+{
+  Eigen::Vector6d mv = _M * _vel;
+  Eigen::Matrix3d S = -1 * gazebo::CrossProductOperator(
+    Eigen::Vector3d(mv.head<3>()));
+  Eigen::Matrix6d C;
+  C << Eigen::Matrix3d::Zero(), S,
+       S, -1 * gazebo::CrossProductOperator(Eigen::Vector3d(mv.tail<3>()));
+  return C;
+}
+
+/// \brief Rigid body moving under a constant force, integrated the way the
+/// physics engine does it: the hydrodynamic model only adds forces, the
+/// rigid-body dynamics Mrb * acc + Crb(v) * v = tau do not know about the
+/// added mass.
+class TestVehicle
+{
+  public: enum Mode { EXPLICIT, SEMI_IMPLICIT, REFERENCE };
+
+  public: TestVehicle(double _ratio)
+  {
+    // Light vehicle with a center of gravity below the origin
+    double mass = 10.0;
+    Eigen::Matrix3d Sg = gazebo::CrossProductOperator(
+      Eigen::Vector3d(0.0, 0.0, 0.02));
+    Eigen::Matrix3d Io = Eigen::Vector3d(0.2, 0.25, 0.3).asDiagonal();
+    Io -= mass * Sg * Sg;
+    this->Mrb << mass * Eigen::Matrix3d::Identity(), -mass * Sg,
+                 mass * Sg, Io;
+
+    // Added mass proportional to the rigid-body mass with some coupling
+    this->Ma = _ratio * this->Mrb;
+    this->Ma(0, 4) = this->Ma(4, 0) = 0.1 * _ratio;
+
+    this->tau << 20.0, 5.0, -3.0, 1.0, 0.5, -2.0;
+    this->vel0 << 1.5, 0.2, -0.1, 0.3, -0.2, 0.5;
+  }
+
+  /// \brief Runs the simulation for _duration seconds and returns the final
+  /// velocity and the last added-mass force
+  public: Eigen::Vector6d Run(Mode _mode, double _dt, double _duration,
+                              Eigen::Vector6d& _added) const
+  {
+    Eigen::Matrix6d gain =
+      gazebo::HMFossen::SemiImplicitAddedMassGain(this->Mrb, this->Ma);
+    Eigen::Matrix6d MrbInv = this->Mrb.inverse();
+    Eigen::Matrix6d MInv = (this->Mrb + this->Ma).inverse();
+
+    Eigen::Vector6d vel = this->vel0;
+    Eigen::Vector6d lastVel = this->vel0;
+    Eigen::Vector6d filteredAcc = Eigen::Vector6d::Zero();
+    _added.setZero();
+
+    int steps = static_cast<int>(_duration / _dt + 0.5);
+    for (int i = 0; i < steps; i++)
+    {
+      // Forces of the hydrodynamic model for this step
+      Eigen::Vector6d acc = (vel - lastVel) / _dt;
+      if (_mode == SEMI_IMPLICIT)
+      {
+        _added = gazebo::HMFossen::SemiImplicitAddedMassForce(
+          this->Mrb, gain, acc, _added);
+      }
+      else if (_mode == EXPLICIT)
+      {
+        filteredAcc = 0.7 * filteredAcc + 0.3 * acc;
+        _added = -this->Ma * filteredAcc;
+      }
+      Eigen::Vector6d cor = -CoriolisMatrix(this->Ma, vel) * vel;
+      lastVel = vel;
+
+      // Physics step
+      Eigen::Vector6d rigid = CoriolisMatrix(this->Mrb, vel) * vel;
+      if (_mode == REFERENCE)
+      {
+        // (Mrb + Ma) * acc + Crb(v) * v + Ca(v) * v = tau
+        acc = MInv * (this->tau + cor - rigid);
+        _added = -this->Ma * acc;
+      }
+      else
+      {
+        acc = MrbInv * (this->tau + cor + _added - rigid);
+      }
+      vel += _dt * acc;
+    }
+    return vel;
+  }
+
+  public: Eigen::Matrix6d Mrb;
+  public: Eigen::Matrix6d Ma;
+  public: Eigen::Vector6d tau;
+  public: Eigen::Vector6d vel0;
+};
+
+TEST(HydrodynamicModel, SemiImplicitAddedMassMatchesExplicit)
+{
+  // Spinning up to several rad/s, so the Coriolis terms matter
+  TestVehicle vehicle(1.5);
+  const double dt = 0.001;
+
+  // Both modes lag the true acceleration by a step, compare them with a
+  // converged solution instead of the reference at the same step size
+  Eigen::Vector6d addedExplicit, addedSemiImplicit, addedReference;
+  Eigen::Vector6d velReference = vehicle.Run(TestVehicle::REFERENCE, 1e-5,
+    2.0, addedReference);
+  Eigen::Vector6d velExplicit = vehicle.Run(TestVehicle::EXPLICIT, dt, 2.0,
+    addedExplicit);
+  Eigen::Vector6d velSemiImplicit = vehicle.Run(TestVehicle::SEMI_IMPLICIT,
+    dt, 2.0, addedSemiImplicit);
+
+  double errVelExplicit = (velExplicit - velReference).norm();
+  double errVelSemiImplicit = (velSemiImplicit - velReference).norm();
+  double errAddedExplicit = (addedExplicit - addedReference).norm();
+  double errAddedSemiImplicit = (addedSemiImplicit - addedReference).norm();
+
+  // At a small step both modes follow the dynamics with added mass, the
+  // semi-implicit mode at least as closely as the explicit one
+  EXPECT_LT(errVelExplicit, 1e-2 * velReference.norm());
+  EXPECT_LT(errVelSemiImplicit, 1e-2 * velReference.norm());
+  EXPECT_LE(errVelSemiImplicit, errVelExplicit);
+
+  EXPECT_LT(errAddedExplicit, 0.1 * addedReference.norm());
+  EXPECT_LT(errAddedSemiImplicit, 0.1 * addedReference.norm());
+  EXPECT_LE(errAddedSemiImplicit, errAddedExplicit);
+}
+
+TEST(HydrodynamicModel, SemiImplicitAddedMassLargeRatio)
+{
+  // The explicit mode cannot follow an added mass this large compared to
+  // the vehicle's own mass, the semi-implicit mode must
+  TestVehicle vehicle(8.0);
+  Eigen::Vector6d addedReference;
+  Eigen::Vector6d velReference = vehicle.Run(TestVehicle::REFERENCE, 1e-5,
+    2.0, addedReference);
+
+  for (double dt : {0.001, 0.005, 0.01, 0.02})
+  {
+    Eigen::Vector6d addedExplicit, addedSemiImplicit;
+    double errExplicit = (vehicle.Run(TestVehicle::EXPLICIT, dt, 2.0,
+      addedExplicit) - velReference).norm();
+    double errSemiImplicit = (vehicle.Run(TestVehicle::SEMI_IMPLICIT, dt,
+      2.0, addedSemiImplicit) - velReference).norm();
+
+    std::cout << "Added mass / mass = 8, step " << dt * 1000.0
+              << " ms: velocity error after 2 s, explicit " << errExplicit
+              << ", semi-implicit " << errSemiImplicit << std::endl;
+
+    // First order in the step size, 1 % of the velocity per millisecond
+    EXPECT_LT(errSemiImplicit, 10.0 * dt * velReference.norm())
+      << "dt=" << dt;
+  }
+}
+
+TEST(HydrodynamicModel, AddedMassCost)
+{
+  TestVehicle vehicle(1.5);
+  Eigen::Matrix6d gain =
+    gazebo::HMFossen::SemiImplicitAddedMassGain(vehicle.Mrb, vehicle.Ma);
+
+  // Benchmark: ns per added-mass force of both modes
+  const int n = 1000000;
+  Eigen::Vector6d acc = vehicle.tau / 10.0;
+  Eigen::Vector6d filteredAcc = Eigen::Vector6d::Zero();
+  Eigen::Vector6d added = Eigen::Vector6d::Zero();
+  double sumExplicit = 0.0, sumSemiImplicit = 0.0;
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < n; i++)
+  {
+    acc[0] += 1e-9;
+    filteredAcc = 0.7 * filteredAcc + 0.3 * acc;
+    added = -vehicle.Ma * filteredAcc;
+    sumExplicit += added[0];
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  for (int i = 0; i < n; i++)
+  {
+    acc[0] += 1e-9;
+    added = gazebo::HMFossen::SemiImplicitAddedMassForce(vehicle.Mrb, gain,
+      acc, added);
+    sumSemiImplicit += added[0];
+  }
+  auto t2 = std::chrono::steady_clock::now();
+
+  std::cout << "Added-mass force: explicit "
+            << std::chrono::duration<double, std::nano>(t1 - t0).count() / n
+            << " ns/step, semi-implicit "
+            << std::chrono::duration<double, std::nano>(t2 - t1).count() / n
+            << " ns/step" << std::endl;
+  EXPECT_FALSE(std::isnan(sumExplicit + sumSemiImplicit));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -15,7 +15,11 @@
 
 #include <gazebo/gazebo.hh>
 
+#include <algorithm>
+#include <fstream>
+
 #include <uuv_gazebo_plugins/LiftDragModel.hh>
+#include <uuv_gazebo_plugins/Def.hh>
 
 namespace gazebo {
 
@@ -309,4 +313,342 @@ std::map<std::string, double> LiftDragTwoLines::GetListParams()
   return params;
 }
 
+/////////////////////////////////////////////////
+const std::string LiftDragTable::IDENTIFIER = "Table";
+REGISTER_LIFTDRAG_CREATOR(LiftDragTable,
+                          &LiftDragTable::create)
+
+/////////////////////////////////////////////////
+LiftDrag* LiftDragTable::create(sdf::ElementPtr _sdf)
+{
+  if (!LiftDrag::CheckForElement(_sdf, "area") ||
+      !LiftDrag::CheckForElement(_sdf, "fluid_density") ||
+      !LiftDrag::CheckForElement(_sdf, "table"))
+    return NULL;
+
+  double chord = 0.0;
+  if (_sdf->HasElement("chord"))
+    chord = _sdf->Get<double>("chord");
+
+  // Kinematic viscosity of sea water at 20 degC
+  double viscosity = 1.05e-6;
+  if (_sdf->HasElement("kinematic_viscosity"))
+    viscosity = _sdf->Get<double>("kinematic_viscosity");
+
+  // Angle spacing of the resampled tables, default is 0.5 deg
+  double resolution = 0.5 * M_PI / 180.0;
+  if (_sdf->HasElement("resolution"))
+    resolution = _sdf->Get<double>("resolution");
+
+  if (resolution <= 0.0 || viscosity <= 0.0)
+  {
+    std::cerr << "LiftDragTable: resolution and kinematic_viscosity must be"
+              << " greater than zero" << std::endl;
+    return NULL;
+  }
+
+  std::vector<std::vector<double> > alpha, cl, cd, cm;
+  std::vector<double> reynolds;
+  bool hasMoment = false;
+  for (sdf::ElementPtr table = _sdf->GetElement("table"); table;
+       table = table->GetNextElement("table"))
+  {
+    alpha.push_back(std::vector<double>());
+    cl.push_back(std::vector<double>());
+    cd.push_back(std::vector<double>());
+    cm.push_back(std::vector<double>());
+    if (!LiftDragTable::ReadTable(table, alpha.back(), cl.back(), cd.back(),
+                                  cm.back()))
+      return NULL;
+
+    hasMoment = hasMoment || table->HasElement("cm") ||
+      std::any_of(cm.back().begin(), cm.back().end(),
+                  [](double _c) { return _c != 0.0; });
+
+    if (table->HasElement("reynolds"))
+      reynolds.push_back(table->Get<double>("reynolds"));
+    else
+      reynolds.push_back(0.0);
+  }
+
+  // The Reynolds number is only needed to choose between several tables
+  if (alpha.size() > 1)
+  {
+    for (size_t i = 1; i < reynolds.size(); i++)
+    {
+      if (reynolds[i] <= reynolds[i - 1])
+      {
+        std::cerr << "LiftDragTable: tables must be given in increasing order"
+                  << " of their reynolds element" << std::endl;
+        return NULL;
+      }
+    }
+  }
+
+  if ((alpha.size() > 1 || hasMoment) && chord <= 0.0)
+  {
+    std::cerr << "LiftDragTable: chord is required for moment coefficients"
+              << " and for tables for multiple Reynolds numbers" << std::endl;
+    return NULL;
+  }
+
+  LiftDragTable* model = new LiftDragTable(
+    _sdf->Get<double>("area"), _sdf->Get<double>("fluid_density"),
+    chord, viscosity);
+
+  // Use a common angle grid covering all tables, each table is extended with
+  // its boundary values
+  double alphaMin = alpha[0].front();
+  double alphaMax = alpha[0].back();
+  for (size_t k = 1; k < alpha.size(); k++)
+  {
+    alphaMin = std::min(alphaMin, alpha[k].front());
+    alphaMax = std::max(alphaMax, alpha[k].back());
+  }
+
+  model->numSamples = std::max(2,
+    static_cast<int>(std::ceil((alphaMax - alphaMin) / resolution)) + 1);
+  model->alphaMin = alphaMin;
+  model->alphaStep = (alphaMax - alphaMin) / (model->numSamples - 1);
+  model->reynolds = reynolds;
+  model->coefficients.reserve(3 * model->numSamples * alpha.size());
+
+  for (size_t k = 0; k < alpha.size(); k++)
+  {
+    size_t j = 0;
+    for (int i = 0; i < model->numSamples; i++)
+    {
+      double a = alphaMin + i * model->alphaStep;
+      // Find the segment [alpha[j], alpha[j+1]] containing a
+      while (j + 2 < alpha[k].size() && a > alpha[k][j + 1])
+        j++;
+      double t = (a - alpha[k][j]) / (alpha[k][j + 1] - alpha[k][j]);
+      t = std::max(0.0, std::min(1.0, t));
+
+      model->coefficients.push_back((1 - t) * cl[k][j] + t * cl[k][j + 1]);
+      model->coefficients.push_back((1 - t) * cd[k][j] + t * cd[k][j + 1]);
+      model->coefficients.push_back((1 - t) * cm[k][j] + t * cm[k][j + 1]);
+    }
+  }
+
+  gzmsg << "LiftDragTable: " << alpha.size() << " table(s) resampled with "
+        << model->numSamples << " samples in [" << alphaMin << ", "
+        << alphaMax << "] rad" << std::endl;
+
+  return model;
+}
+
+/////////////////////////////////////////////////
+bool LiftDragTable::ReadTable(sdf::ElementPtr _sdf,
+                              std::vector<double> &_alpha,
+                              std::vector<double> &_cl,
+                              std::vector<double> &_cd,
+                              std::vector<double> &_cm)
+{
+  if (_sdf->HasElement("file"))
+  {
+    // Each line of the file contains the angle of attack [rad] and the
+    // lift, drag and (optionally) moment coefficients, separated by
+    // whitespaces or commas. Lines starting with # are ignored.
+    std::string filename = _sdf->Get<std::string>("file");
+    std::ifstream file(filename.c_str());
+    if (!file.is_open())
+    {
+      std::cerr << "LiftDragTable: could not open table file "
+                << filename << std::endl;
+      return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+      line = line.substr(0, line.find('#'));
+      std::replace(line.begin(), line.end(), ',', ' ');
+      std::vector<double> row = Str2Vector(line);
+      if (row.empty())
+        continue;
+      if (row.size() < 3 || row.size() > 4)
+      {
+        std::cerr << "LiftDragTable: invalid line in table file "
+                  << filename << ": " << line << std::endl;
+        return false;
+      }
+      _alpha.push_back(row[0]);
+      _cl.push_back(row[1]);
+      _cd.push_back(row[2]);
+      _cm.push_back(row.size() == 4 ? row[3] : 0.0);
+    }
+  }
+  else
+  {
+    if (!LiftDrag::CheckForElement(_sdf, "alpha") ||
+        !LiftDrag::CheckForElement(_sdf, "cl") ||
+        !LiftDrag::CheckForElement(_sdf, "cd"))
+      return false;
+
+    _alpha = Str2Vector(_sdf->Get<std::string>("alpha"));
+    _cl = Str2Vector(_sdf->Get<std::string>("cl"));
+    _cd = Str2Vector(_sdf->Get<std::string>("cd"));
+    if (_sdf->HasElement("cm"))
+      _cm = Str2Vector(_sdf->Get<std::string>("cm"));
+    else
+      _cm = std::vector<double>(_alpha.size(), 0.0);
+  }
+
+  if (_alpha.size() < 2 || _cl.size() != _alpha.size() ||
+      _cd.size() != _alpha.size() || _cm.size() != _alpha.size())
+  {
+    std::cerr << "LiftDragTable: tables must have at least two samples and "
+              << "the same number of elements for alpha, cl, cd and cm"
+              << std::endl;
+    return false;
+  }
+
+  for (size_t i = 1; i < _alpha.size(); i++)
+  {
+    if (_alpha[i] <= _alpha[i - 1])
+    {
+      std::cerr << "LiftDragTable: angles of attack must be strictly "
+                << "increasing" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////
+void LiftDragTable::GetCoefficients(double _alpha, double _re, double &_cl,
+                                    double &_cd, double &_cm) const
+{
+  // Index and weight on the uniform angle grid
+  double x = (_alpha - this->alphaMin) / this->alphaStep;
+  int i = 0;
+  double t = 0.0;
+  if (x >= this->numSamples - 1)
+  {
+    i = this->numSamples - 2;
+    t = 1.0;
+  }
+  else if (x > 0.0)
+  {
+    i = static_cast<int>(x);
+    t = x - i;
+  }
+
+  // Table and weight for the Reynolds number
+  size_t k = 0;
+  double w = 0.0;
+  if (this->reynolds.size() > 1)
+  {
+    if (_re >= this->reynolds.back())
+    {
+      k = this->reynolds.size() - 2;
+      w = 1.0;
+    }
+    else if (_re > this->reynolds.front())
+    {
+      while (_re > this->reynolds[k + 1])
+        k++;
+      w = (_re - this->reynolds[k]) /
+        (this->reynolds[k + 1] - this->reynolds[k]);
+    }
+  }
+
+  const double* c = &this->coefficients[3 * (k * this->numSamples + i)];
+  _cl = (1 - t) * c[0] + t * c[3];
+  _cd = (1 - t) * c[1] + t * c[4];
+  _cm = (1 - t) * c[2] + t * c[5];
+
+  if (w > 0.0)
+  {
+    c += 3 * this->numSamples;
+    _cl = (1 - w) * _cl + w * ((1 - t) * c[0] + t * c[3]);
+    _cd = (1 - w) * _cd + w * ((1 - t) * c[1] + t * c[4]);
+    _cm = (1 - w) * _cm + w * ((1 - t) * c[2] + t * c[5]);
+  }
+}
+
+/////////////////////////////////////////////////
+ignition::math::Vector3d LiftDragTable::compute(
+  const ignition::math::Vector3d &_velL)
+{
+  ignition::math::Vector3d force, torque;
+  this->compute(_velL, force, torque);
+  return force;
+}
+
+/////////////////////////////////////////////////
+void LiftDragTable::compute(const ignition::math::Vector3d &_velL,
+                            ignition::math::Vector3d &_forceL,
+                            ignition::math::Vector3d &_torqueL)
+{
+  _forceL = ignition::math::Vector3d::Zero;
+  _torqueL = ignition::math::Vector3d::Zero;
+
+  // Norm of the velocity in the lift/drag plane, which is also the norm of
+  // the lift direction vector
+  double uPlane = std::sqrt(_velL.X() * _velL.X() + _velL.Y() * _velL.Y());
+  double u = _velL.Length();
+  if (uPlane < 1e-6)
+    return;
+
+  double angle = atan2(_velL.Y(), _velL.X());
+
+  // Make sure angle is in [-pi/2, pi/2]
+  if (angle > M_PI_2)
+    angle -= M_PI;
+  else if (angle < -M_PI_2)
+    angle += M_PI;
+
+  double cl, cd, cm;
+  this->GetCoefficients(angle, u * this->chord / this->kinematicViscosity,
+                        cl, cd, cm);
+
+  // Dynamic pressure times the fin area
+  double qa = 0.5 * this->fluidDensity * u * u * this->area;
+
+  // Same directions as for the other models, lift along
+  // -UnitZ x velL and drag along -velL
+  double lift = cl * qa / uPlane;
+  double drag = cd * qa / u;
+  _forceL.X() = lift * _velL.Y() - drag * _velL.X();
+  _forceL.Y() = -lift * _velL.X() - drag * _velL.Y();
+  _forceL.Z() = -drag * _velL.Z();
+
+  // Pitching moment around the fin axis, positive coefficients turn the fin
+  // towards larger angles of attack
+  _torqueL.Z() = -cm * qa * this->chord;
+}
+
+/////////////////////////////////////////////////
+bool LiftDragTable::GetParam(std::string _tag, double& _output)
+{
+  _output = 0.0;
+  if (!_tag.compare("area"))
+    _output = this->area;
+  else if (!_tag.compare("fluid_density"))
+    _output = this->fluidDensity;
+  else if (!_tag.compare("chord"))
+    _output = this->chord;
+  else if (!_tag.compare("kinematic_viscosity"))
+    _output = this->kinematicViscosity;
+  else
+    return false;
+
+  gzmsg << "LiftDragTable::GetParam <" << _tag << ">=" << _output <<
+    std::endl;
+  return true;
+}
+
+/////////////////////////////////////////////////
+std::map<std::string, double> LiftDragTable::GetListParams()
+{
+  std::map<std::string, double> params;
+  params["area"] = this->area;
+  params["fluid_density"] = this->fluidDensity;
+  params["chord"] = this->chord;
+  params["kinematic_viscosity"] = this->kinematicViscosity;
+  return params;
+}
+
 }
@@ -0,0 +1,174 @@
+// Copyright (c) 2016 The UUV Simulator Authors.
+// All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <string>
+#include <memory>
+#include <gtest/gtest.h>
+#include <uuv_gazebo_plugins/LiftDragModel.hh>
+
+std::shared_ptr<gazebo::LiftDrag> LiftDragFromString(
+    const std::string& description)
+{
+  std::stringstream stream;
+  stream << "<sdf version='" << SDF_VERSION << "'>" << std::endl
+         << "<model name='test_model'>" << std::endl
+         << "<plugin name='test_plugin' filename='test_file.so'>" << std::endl
+         << description
+         << "</plugin>" << std::endl
+         << "</model>" << std::endl
+         << "</sdf>" << std::endl;
+
+  sdf::SDF sdfParsed;
+  sdfParsed.SetFromString(stream.str());
+
+  sdf::ElementPtr liftdrag = sdfParsed.Root()->GetElement("model")
+      ->GetElement("plugin")->GetElement("liftdrag");
+
+  std::shared_ptr<gazebo::LiftDrag> model;
+  model.reset(gazebo::LiftDragFactory::GetInstance().CreateLiftDrag(liftdrag));
+
+  return model;
+}
+
+/// \brief Returns the lift and drag coefficients from the force computed for
+/// a fin with the given area and fluid density
+void GetCoefficients(std::shared_ptr<gazebo::LiftDrag> _model, double _alpha,
+                     double _u, double _area, double _rho, double &_cl,
+                     double &_cd)
+{
+  ignition::math::Vector3d vel(_u * cos(_alpha), _u * sin(_alpha), 0.0);
+  ignition::math::Vector3d force = _model->compute(vel);
+  double qa = 0.5 * _rho * _u * _u * _area;
+  _cl = (force.X() * vel.Y() - force.Y() * vel.X()) / (_u * qa);
+  _cd = -(force.X() * vel.X() + force.Y() * vel.Y()) / (_u * qa);
+}
+
+TEST(LiftDragModel, Table)
+{
+  std::vector<double> alpha = {-0.4, 0.0, 0.2, 0.4};
+  std::vector<double> cl = {-1.0, 0.0, 0.8, 0.6};
+  std::vector<double> cd = {0.3, 0.01, 0.05, 0.3};
+
+  std::stringstream stream;
+  stream << "<liftdrag> \n"
+         << "  <type>Table</type> \n"
+         << "  <area>0.1</area> \n"
+         << "  <fluid_density>1000</fluid_density> \n"
+         << "  <resolution>0.01</resolution> \n"
+         << "  <table> \n"
+         << "    <alpha>";
+  for (double d : alpha)
+    stream << d << " ";
+  stream << "</alpha> \n"
+         << "    <cl>";
+  for (double d : cl)
+    stream << d << " ";
+  stream << "</cl> \n"
+         << "    <cd>";
+  for (double d : cd)
+    stream << d << " ";
+  stream << "</cd> \n"
+         << "  </table> \n"
+         << "</liftdrag>";
+
+  std::shared_ptr<gazebo::LiftDrag> model;
+  model = LiftDragFromString(stream.str());
+
+  EXPECT_TRUE(model != NULL);
+  EXPECT_EQ(model->GetType(), "Table");
+
+  double c_l, c_d;
+  // The samples are on the resampled grid, the result must match the table
+  for (size_t i = 0; i < alpha.size(); i++)
+  {
+    GetCoefficients(model, alpha[i], 2.0, 0.1, 1000, c_l, c_d);
+    EXPECT_NEAR(cl[i], c_l, 1e-6);
+    EXPECT_NEAR(cd[i], c_d, 1e-6);
+  }
+
+  // Outside of defined range: return closest value
+  GetCoefficients(model, alpha[0] - 0.2, 2.0, 0.1, 1000, c_l, c_d);
+  EXPECT_NEAR(cl[0], c_l, 1e-6);
+  GetCoefficients(model, alpha.back() + 0.2, 2.0, 0.1, 1000, c_l, c_d);
+  EXPECT_NEAR(cl.back(), c_l, 1e-6);
+
+  // In between: linear interpolation
+  GetCoefficients(model, 0.1, 2.0, 0.1, 1000, c_l, c_d);
+  EXPECT_NEAR(0.4, c_l, 1e-6);
+  EXPECT_NEAR(0.03, c_d, 1e-6);
+
+  // No force without flow
+  ignition::math::Vector3d force = model->compute(
+    ignition::math::Vector3d::Zero);
+  EXPECT_EQ(0.0, force.Length());
+}
+
+TEST(LiftDragModel, TableReynolds)
+{
+  std::string description =
+        "<liftdrag> \n"
+        "  <type>Table</type> \n"
+        "  <area>0.1</area> \n"
+        "  <fluid_density>1000</fluid_density> \n"
+        "  <chord>0.1</chord> \n"
+        "  <kinematic_viscosity>1e-6</kinematic_viscosity> \n"
+        "  <resolution>0.1</resolution> \n"
+        "  <table> \n"
+        "    <reynolds>1e5</reynolds> \n"
+        "    <alpha>-0.5 0.5</alpha> \n"
+        "    <cl>-1 1</cl> \n"
+        "    <cd>0.1 0.1</cd> \n"
+        "  </table> \n"
+        "  <table> \n"
+        "    <reynolds>3e5</reynolds> \n"
+        "    <alpha>-0.5 0.5</alpha> \n"
+        "    <cl>-2 2</cl> \n"
+        "    <cd>0.2 0.2</cd> \n"
+        "    <cm>0.5 -0.5</cm> \n"
+        "  </table> \n"
+        "</liftdrag>";
+
+  std::shared_ptr<gazebo::LiftDrag> model;
+  model = LiftDragFromString(description);
+
+  EXPECT_TRUE(model != NULL);
+
+  double c_l, c_d;
+  // Re = 1e5 and Re = 3e5
+  GetCoefficients(model, 0.5, 1.0, 0.1, 1000, c_l, c_d);
+  EXPECT_NEAR(1.0, c_l, 1e-6);
+  EXPECT_NEAR(0.1, c_d, 1e-6);
+  GetCoefficients(model, 0.5, 3.0, 0.1, 1000, c_l, c_d);
+  EXPECT_NEAR(2.0, c_l, 1e-6);
+  EXPECT_NEAR(0.2, c_d, 1e-6);
+
+  // Re = 2e5 is halfway between both tables
+  GetCoefficients(model, 0.5, 2.0, 0.1, 1000, c_l, c_d);
+  EXPECT_NEAR(1.5, c_l, 1e-6);
+  EXPECT_NEAR(0.15, c_d, 1e-6);
+
+  // Moment around the fin axis
+  ignition::math::Vector3d force, torque;
+  model->compute(ignition::math::Vector3d(3.0, 0.0, 0.0), force, torque);
+  EXPECT_NEAR(0.0, torque.Length(), 1e-6);
+  model->compute(ignition::math::Vector3d(3.0 * cos(0.5), 3.0 * sin(0.5), 0.0),
+                 force, torque);
+  EXPECT_NEAR(0.5 * 0.5 * 1000 * 9.0 * 0.1 * 0.1, torque.Z(), 1e-6);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
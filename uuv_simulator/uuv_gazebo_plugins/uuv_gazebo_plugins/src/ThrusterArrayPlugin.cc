@@ -0,0 +1,363 @@
+// Copyright (c) 2016 The UUV Simulator Authors.
+// All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <algorithm>
+#include <limits>
+
+#include <gazebo/gazebo.hh>
+#include <gazebo/msgs/msgs.hh>
+#include <gazebo/physics/Joint.hh>
+#include <gazebo/physics/Link.hh>
+#include <gazebo/physics/Model.hh>
+#include <gazebo/physics/World.hh>
+#include <gazebo/transport/TransportTypes.hh>
+#include <sdf/sdf.hh>
+
+#include <math.h>
+
+#include <uuv_gazebo_plugins/ThrusterArrayPlugin.hh>
+#include <uuv_gazebo_plugins/Def.hh>
+
+
+GZ_REGISTER_MODEL_PLUGIN(gazebo::ThrusterArrayPlugin)
+
+namespace gazebo {
+
+/////////////////////////////////////////////////
+ThrusterArrayPlugin::ThrusterArrayPlugin() : thrustPublishRate(0.0)
+{
+}
+
+/////////////////////////////////////////////////
+ThrusterArrayPlugin::~ThrusterArrayPlugin()
+{
+  if (this->updateConnection)
+  {
+#if GAZEBO_MAJOR_VERSION >= 8
+    this->updateConnection.reset();
+#else
+    event::Events::DisconnectWorldUpdateBegin(this->updateConnection);
+#endif
+  }
+}
+
+/////////////////////////////////////////////////
+void ThrusterArrayPlugin::Load(physics::ModelPtr _model,
+                               sdf::ElementPtr _sdf)
+{
+  GZ_ASSERT(_model != NULL, "Invalid model pointer");
+
+  // Initializing the transport node
+  this->node = transport::NodePtr(new transport::Node());
+#if GAZEBO_MAJOR_VERSION >= 8
+  this->node->Init(_model->GetWorld()->Name());
+#else
+  this->node->Init(_model->GetWorld()->GetName());
+#endif
+
+  GZ_ASSERT(_sdf->HasElement("thruster"), "Could not find thruster.");
+  for (sdf::ElementPtr thrusterElem = _sdf->GetElement("thruster");
+       thrusterElem; thrusterElem = thrusterElem->GetNextElement("thruster"))
+  {
+    if (!this->LoadThruster(_model, thrusterElem))
+      gzerr << "ThrusterArrayPlugin: Invalid thruster description, "
+        << "skipping thruster" << std::endl;
+  }
+
+  this->AllocateVectors();
+
+  // Rate of the thrust output messages
+  if (_sdf->HasElement("thrust_publish_rate"))
+    this->thrustPublishRate = _sdf->Get<double>("thrust_publish_rate");
+  if (this->thrustPublishRate < 0.0)
+  {
+    gzmsg << "Invalid thrust publish rate, publishing at every update"
+      << std::endl;
+    this->thrustPublishRate = 0.0;
+  }
+
+  // Root string for topics
+  std::string topicPrefix = "/" + _model->GetName() + "/thrusters/";
+  std::string inputTopic = topicPrefix + "input";
+  std::string thrustTopic = topicPrefix + "thrust";
+  if (_sdf->HasElement("input_topic"))
+    inputTopic = _sdf->Get<std::string>("input_topic");
+  if (_sdf->HasElement("thrust_topic"))
+    thrustTopic = _sdf->Get<std::string>("thrust_topic");
+
+  // Advertise the thrust topic
+  this->thrustTopicPublisher =
+    this->node->Advertise<uuv_gazebo_plugins_msgs::msgs::DoubleArray>(
+      thrustTopic);
+
+  // Subscribe to the input signal topic
+  this->commandSubscriber = this->node->Subscribe(inputTopic,
+    &ThrusterArrayPlugin::UpdateInput, this);
+
+  gzmsg << "ThrusterArrayPlugin: " << this->thrusters.size()
+    << " thrusters, input topic=" << inputTopic << ", thrust topic="
+    << thrustTopic << std::endl;
+
+  // Connect the update event
+  this->updateConnection = event::Events::ConnectWorldUpdateBegin(
+        boost::bind(&ThrusterArrayPlugin::Update,
+                    this, _1));
+}
+
+/////////////////////////////////////////////////
+bool ThrusterArrayPlugin::LoadThruster(physics::ModelPtr _model,
+                                       sdf::ElementPtr _sdf)
+{
+  Thruster thruster;
+  thruster.clampMin = std::numeric_limits<double>::lowest();
+  thruster.clampMax = std::numeric_limits<double>::max();
+  thruster.thrustMin = std::numeric_limits<double>::lowest();
+  thruster.thrustMax = std::numeric_limits<double>::max();
+  thruster.gain = 1.0;
+  thruster.thrustEfficiency = 1.0;
+  thruster.propellerEfficiency = 1.0;
+  thruster.dynamicState = 0.0;
+
+  // Retrieve the link name on which the thrust will be applied
+  if (!_sdf->HasElement("linkName") || !_sdf->HasElement("thrusterID") ||
+      !_sdf->HasElement("dynamics") || !_sdf->HasElement("conversion"))
+  {
+    gzerr << "ThrusterArrayPlugin: linkName, thrusterID, dynamics and "
+      << "conversion are required for each thruster" << std::endl;
+    return false;
+  }
+
+  thruster.link = _model->GetLink(_sdf->Get<std::string>("linkName"));
+  if (!thruster.link)
+  {
+    gzerr << "ThrusterArrayPlugin: thruster link "
+      << _sdf->Get<std::string>("linkName") << " is invalid" << std::endl;
+    return false;
+  }
+
+  thruster.id = _sdf->Get<int>("thrusterID");
+  if (thruster.id < 0)
+  {
+    gzerr << "ThrusterArrayPlugin: thrusterID must be greater or equal "
+      << "than zero" << std::endl;
+    return false;
+  }
+  for (auto &other : this->thrusters)
+  {
+    if (other.id == thruster.id)
+    {
+      gzerr << "ThrusterArrayPlugin: thrusterID " << thruster.id
+        << " is used twice" << std::endl;
+      return false;
+    }
+  }
+
+  thruster.dynamics.reset(
+    DynamicsFactory::GetInstance().CreateDynamics(
+      _sdf->GetElement("dynamics")));
+  thruster.conversionFunction.reset(
+    ConversionFunctionFactory::GetInstance().CreateConversionFunction(
+      _sdf->GetElement("conversion")));
+  if (!thruster.dynamics || !thruster.conversionFunction)
+    return false;
+
+  // Optional paramters:
+  // Rotor joint, used for visualization if available.
+  if (_sdf->HasElement("jointName"))
+    thruster.joint = _model->GetJoint(_sdf->Get<std::string>("jointName"));
+
+  // Clamping interval
+  if (_sdf->HasElement("clampMin"))
+    thruster.clampMin = _sdf->Get<double>("clampMin");
+
+  if (_sdf->HasElement("clampMax"))
+    thruster.clampMax = _sdf->Get<double>("clampMax");
+
+  if (thruster.clampMin >= thruster.clampMax)
+  {
+    gzmsg << "clampMax must be greater than clampMin, returning to default values..." << std::endl;
+    thruster.clampMin = std::numeric_limits<double>::lowest();
+    thruster.clampMax = std::numeric_limits<double>::max();
+  }
+
+  // Thrust force interval
+  if (_sdf->HasElement("thrustMin"))
+    thruster.thrustMin = _sdf->Get<double>("thrustMin");
+
+  if (_sdf->HasElement("thrustMax"))
+    thruster.thrustMax = _sdf->Get<double>("thrustMax");
+
+  if (thruster.thrustMin >= thruster.thrustMax)
+  {
+    gzmsg << "thrustMax must be greater than thrustMin, returning to default values..." << std::endl;
+    thruster.thrustMin = std::numeric_limits<double>::lowest();
+    thruster.thrustMax = std::numeric_limits<double>::max();
+  }
+
+  // Gain (1.0 by default)
+  if (_sdf->HasElement("gain"))
+    thruster.gain = _sdf->Get<double>("gain");
+
+  if (_sdf->HasElement("thrust_efficiency"))
+  {
+    thruster.thrustEfficiency = _sdf->Get<double>("thrust_efficiency");
+    if (thruster.thrustEfficiency < 0.0 || thruster.thrustEfficiency > 1.0)
+    {
+      gzmsg << "Invalid thrust efficiency factor, setting it to 100%"
+        << std::endl;
+      thruster.thrustEfficiency = 1.0;
+    }
+  }
+
+  if (_sdf->HasElement("propeller_efficiency"))
+  {
+    thruster.propellerEfficiency = _sdf->Get<double>("propeller_efficiency");
+    if (thruster.propellerEfficiency < 0.0 ||
+        thruster.propellerEfficiency > 1.0)
+    {
+      gzmsg <<
+        "Invalid propeller dynamics efficiency factor, setting it to 100%"
+        << std::endl;
+      thruster.propellerEfficiency = 1.0;
+    }
+  }
+
+  // The thrust is applied along the rotor joint's axis, or along the link's
+  // x axis if no joint was given
+  thruster.axis = ignition::math::Vector3d::UnitX;
+  if (thruster.joint)
+  {
+#if GAZEBO_MAJOR_VERSION >= 8
+    thruster.axis = thruster.joint->WorldPose().Rot().RotateVectorReverse(
+      thruster.joint->GlobalAxis(0));
+#else
+    thruster.axis = thruster.joint->GetWorldPose().rot.Ign().RotateVectorReverse(
+      thruster.joint->GetGlobalAxis(0).Ign());
+#endif
+  }
+
+  this->thrusters.push_back(thruster);
+  return true;
+}
+
+/////////////////////////////////////////////////
+void ThrusterArrayPlugin::AllocateVectors()
+{
+  // The vectors are indexed by the thruster IDs
+  int maxID = -1;
+  for (auto &thruster : this->thrusters)
+    maxID = std::max(maxID, thruster.id);
+  this->inputCommands.assign(maxID + 1, 0.0);
+  this->currentInputs.assign(maxID + 1, 0.0);
+  this->thrustForces.assign(maxID + 1, 0.0);
+
+  this->thrustMsg.clear_value();
+  for (int i = 0; i <= maxID; i++)
+    this->thrustMsg.add_value(0.0);
+}
+
+/////////////////////////////////////////////////
+void ThrusterArrayPlugin::Init()
+{
+}
+
+/////////////////////////////////////////////////
+void ThrusterArrayPlugin::Reset()
+{
+  for (auto &thruster : this->thrusters)
+    thruster.dynamics->Reset();
+  this->lastThrustPublish = common::Time();
+}
+
+/////////////////////////////////////////////////
+void ThrusterArrayPlugin::Update(const common::UpdateInfo &_info)
+{
+  this->UpdateThrusters(_info.simTime.Double());
+
+  for (auto &thruster : this->thrusters)
+  {
+    thruster.link->AddRelativeForce(
+      this->thrustForces[thruster.id] * thruster.axis);
+
+    if (thruster.joint)
+    {
+      // Let joint rotate with correct angular velocity.
+      thruster.joint->SetVelocity(0, thruster.dynamicState);
+    }
+  }
+
+  // Publish all thrust forces in a single message
+  if (this->thrustPublishRate > 0.0 &&
+      (_info.simTime - this->lastThrustPublish).Double() <
+        1.0 / this->thrustPublishRate)
+    return;
+
+  for (size_t i = 0; i < this->thrustForces.size(); i++)
+    this->thrustMsg.set_value(i, this->thrustForces[i]);
+  this->thrustMsg.mutable_time()->set_sec(_info.simTime.sec);
+  this->thrustMsg.mutable_time()->set_nsec(_info.simTime.nsec);
+  this->thrustTopicPublisher->Publish(this->thrustMsg);
+  this->lastThrustPublish = _info.simTime;
+}
+
+/////////////////////////////////////////////////
+void ThrusterArrayPlugin::UpdateThrusters(double _time)
+{
+  // Copy the latest inputs, the buffer has the same size and is reused
+  {
+    std::lock_guard<std::mutex> lock(this->inputLock);
+    this->currentInputs = this->inputCommands;
+  }
+  const std::vector<double> &inputs = this->currentInputs;
+
+  for (auto &thruster : this->thrusters)
+  {
+    GZ_ASSERT(!std::isnan(inputs[thruster.id]), "nan in input command");
+
+    double clamped = inputs[thruster.id];
+    clamped = std::min(clamped, thruster.clampMax);
+    clamped = std::max(clamped, thruster.clampMin);
+
+    thruster.dynamicState = thruster.propellerEfficiency *
+      thruster.dynamics->update(thruster.gain * clamped, _time);
+    GZ_ASSERT(!std::isnan(thruster.dynamicState), "Invalid dynamic state");
+
+    // Multiply the output force magnitude with the efficiency
+    double thrustForce = thruster.thrustEfficiency *
+      thruster.conversionFunction->convert(thruster.dynamicState);
+    GZ_ASSERT(!std::isnan(thrustForce), "Invalid thrust force");
+
+    // Use the thrust force limits
+    thrustForce = std::max(thrustForce, thruster.thrustMin);
+    thrustForce = std::min(thrustForce, thruster.thrustMax);
+    this->thrustForces[thruster.id] = thrustForce;
+  }
+}
+
+/////////////////////////////////////////////////
+void ThrusterArrayPlugin::UpdateInput(ConstDoubleArrayPtr &_msg)
+{
+  std::lock_guard<std::mutex> lock(this->inputLock);
+  // Inputs for thrusters that do not exist are ignored, missing inputs keep
+  // their previous value
+  int n = std::min(_msg->value_size(),
+                   static_cast<int>(this->inputCommands.size()));
+  for (int i = 0; i < n; i++)
+    this->inputCommands[i] = _msg->value(i);
+}
+}
@@ -0,0 +1,130 @@
+// Copyright (c) 2016 The UUV Simulator Authors.
+// All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/make_shared.hpp>
+#include <gtest/gtest.h>
+#include <uuv_gazebo_plugins/ThrusterArrayPlugin.hh>
+
+std::string PluginFromString(const std::string& description)
+{
+  std::stringstream stream;
+  stream << "<sdf version='" << SDF_VERSION << "'>" << std::endl
+         << "<model name='test_model'>" << std::endl
+         << "<plugin name='test_plugin' filename='test_file.so'>" << std::endl
+         << description
+         << "</plugin>" << std::endl
+         << "</model>" << std::endl
+         << "</sdf>" << std::endl;
+  return stream.str();
+}
+
+/// \brief Gives the test access to the thrusters without loading a model
+class TestThrusterArray : public gazebo::ThrusterArrayPlugin
+{
+  public: void AddThruster(int _id, double _rotorConstant, double _gain,
+                           double _clampMax, double _thrustEfficiency)
+  {
+    Thruster thruster;
+    thruster.id = _id;
+    std::stringstream description;
+    description << "<dynamics><type>ZeroOrder</type></dynamics>"
+                << "<conversion><type>Basic</type><rotorConstant>"
+                << _rotorConstant << "</rotorConstant></conversion>";
+
+    sdf::SDF sdfParsed;
+    sdfParsed.SetFromString(PluginFromString(description.str()));
+    sdf::ElementPtr plugin = sdfParsed.Root()->GetElement("model")
+        ->GetElement("plugin");
+
+    thruster.dynamics.reset(
+      gazebo::DynamicsFactory::GetInstance().CreateDynamics(
+        plugin->GetElement("dynamics")));
+    thruster.conversionFunction.reset(
+      gazebo::ConversionFunctionFactory::GetInstance().
+        CreateConversionFunction(plugin->GetElement("conversion")));
+    thruster.axis = ignition::math::Vector3d::UnitX;
+    thruster.clampMin = -_clampMax;
+    thruster.clampMax = _clampMax;
+    thruster.thrustMin = std::numeric_limits<double>::lowest();
+    thruster.thrustMax = std::numeric_limits<double>::max();
+    thruster.gain = _gain;
+    thruster.thrustEfficiency = _thrustEfficiency;
+    thruster.propellerEfficiency = 1.0;
+    thruster.dynamicState = 0.0;
+    this->thrusters.push_back(thruster);
+    this->AllocateVectors();
+  }
+
+  public: void SetInputs(const std::vector<double> &_inputs)
+  {
+    auto msg = boost::make_shared<uuv_gazebo_plugins_msgs::msgs::DoubleArray>();
+    for (double input : _inputs)
+      msg->add_value(input);
+    gazebo::ConstDoubleArrayPtr constMsg(msg);
+    this->UpdateInput(constMsg);
+  }
+
+  public: void Step(double _time)
+  {
+    this->UpdateThrusters(_time);
+  }
+
+  public: const std::vector<double> &Thrust()
+  {
+    return this->thrustForces;
+  }
+};
+
+TEST(ThrusterArrayPlugin, UpdatesAllThrusters)
+{
+  // IDs need not be contiguous, ID 1 has no thruster
+  TestThrusterArray array;
+  array.AddThruster(0, 0.0049, 2.0, 100.0, 1.0);
+  array.AddThruster(2, 0.01, 1.0, 10.0, 0.5);
+  array.AddThruster(3, 0.002, -1.0, 100.0, 1.0);
+  ASSERT_EQ(4u, array.Thrust().size());
+
+  array.SetInputs({20.0, 5.0, 30.0, -40.0});
+  array.Step(0.0);
+
+  // Basic conversion: thrust = rotorConstant * |w| * w, w = gain * input
+  EXPECT_DOUBLE_EQ(0.0049 * 40.0 * 40.0, array.Thrust()[0]);
+  EXPECT_EQ(0.0, array.Thrust()[1]);
+  // Input clamped to 10, half of the thrust is lost
+  EXPECT_DOUBLE_EQ(0.5 * 0.01 * 10.0 * 10.0, array.Thrust()[2]);
+  EXPECT_DOUBLE_EQ(0.002 * 40.0 * 40.0, array.Thrust()[3]);
+
+  // Missing inputs keep their previous value, extra inputs are ignored
+  array.SetInputs({-20.0});
+  array.Step(0.1);
+  EXPECT_DOUBLE_EQ(-0.0049 * 40.0 * 40.0, array.Thrust()[0]);
+  EXPECT_DOUBLE_EQ(0.5 * 0.01 * 10.0 * 10.0, array.Thrust()[2]);
+  EXPECT_DOUBLE_EQ(0.002 * 40.0 * 40.0, array.Thrust()[3]);
+
+  array.SetInputs({0.0, 0.0, 0.0, 0.0, 50.0});
+  array.Step(0.2);
+  for (double thrust : array.Thrust())
+    EXPECT_EQ(0.0, thrust);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
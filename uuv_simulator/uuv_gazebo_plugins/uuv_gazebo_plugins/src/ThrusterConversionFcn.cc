@@ -15,6 +15,9 @@
 
 #include <uuv_gazebo_plugins/ThrusterConversionFcn.hh>
 
+#include <algorithm>
+#include <cmath>
+
 #include <uuv_gazebo_plugins/Def.hh>
 
 namespace gazebo
@@ -267,28 +270,40 @@ ConversionFunction* ConversionFunctionLinearInterp::create(sdf::ElementPtr _sdf)
 /////////////////////////////////////////////////
 double ConversionFunctionLinearInterp::convert(double _cmd)
 {
-  GZ_ASSERT(!lookupTable.empty(), "Lookup table is empty");
+  GZ_ASSERT(!this->inputValues.empty(), "Lookup table is empty");
+
+  const std::vector<double> &in = this->inputValues;
+  const std::vector<double> &out = this->outputValues;
 
-  // "first element whose key is NOT considered to go before _cmd"
-  auto iter = lookupTable.lower_bound(_cmd);
+  // Outside of the table: return the closest value
+  if (_cmd <= in.front())
+    return out.front();
+  if (_cmd >= in.back())
+    return out.back();
 
-  if (iter == lookupTable.end())
+  // Index of the last input value smaller than _cmd
+  size_t idx;
+  if (this->invInputStep > 0.0)
   {
-    // "all keys are considered to go before"
-    // last element is closest
-    return lookupTable.rbegin()->second;
+    // Uniformly spaced input values: index the table directly and correct
+    // for rounding errors at the segment boundaries
+    idx = static_cast<size_t>((_cmd - in.front()) * this->invInputStep);
+    idx = std::min(idx, in.size() - 2);
+    if (_cmd <= in[idx] && idx > 0)
+      idx--;
+    else if (_cmd > in[idx + 1])
+      idx++;
+  }
+  else
+  {
+    // "first element whose key is NOT considered to go before _cmd"
+    idx = std::lower_bound(in.begin(), in.end(), _cmd) - in.begin() - 1;
   }
 
-  double i1 = iter->first;
-  double o1 = iter->second;
-
-  if (iter == lookupTable.begin())
-    return o1;
-
-  iter--;
-
-  double i0 = iter->first;
-  double o0 = iter->second;
+  double i0 = in[idx];
+  double o0 = out[idx];
+  double i1 = in[idx + 1];
+  double o1 = out[idx + 1];
 
   double w1 = _cmd - i0;
   double w0 = i1 - _cmd;
@@ -299,7 +314,7 @@ double ConversionFunctionLinearInterp::convert(double _cmd)
 /////////////////////////////////////////////////
 ConversionFunctionLinearInterp::ConversionFunctionLinearInterp(
     const std::vector<double> &_input,
-    const std::vector<double> &_output)
+    const std::vector<double> &_output) : invInputStep(0.0)
 {
   GZ_ASSERT(_input.size() == _output.size(), "input and output do not match");
 
@@ -307,6 +322,34 @@ ConversionFunctionLinearInterp::ConversionFunctionLinearInterp(
   {
     lookupTable[_input[i]] = _output[i];
   }
+
+  // Store the sorted table in contiguous arrays
+  for (auto& i : lookupTable)
+  {
+    this->inputValues.push_back(i.first);
+    this->outputValues.push_back(i.second);
+  }
+
+  // Check if the input values are uniformly spaced, which allows computing
+  // the interpolation segment without searching
+  if (this->inputValues.size() > 2)
+  {
+    double range = this->inputValues.back() - this->inputValues.front();
+    double step = range / (this->inputValues.size() - 1);
+    bool uniform = true;
+    for (size_t i = 0; i < this->inputValues.size(); i++)
+    {
+      double expected = this->inputValues.front() + i * step;
+      if (std::fabs(this->inputValues[i] - expected) > 1e-9 * range)
+      {
+        uniform = false;
+        break;
+      }
+    }
+    if (uniform)
+      this->invInputStep = 1.0 / step;
+  }
+
   gzmsg << "ConversionFunctionLinearInterp::Create conversion function"
     << std::endl;
   gzmsg << "\t- Input values:" << std::endl;
@@ -317,6 +360,8 @@ ConversionFunctionLinearInterp::ConversionFunctionLinearInterp(
   for (auto& i : lookupTable)
     std::cout << i.second << " ";
   std::cout << std::endl;
+  gzmsg << "\t- Uniformly spaced input values: "
+    << (this->invInputStep > 0.0 ? "yes" : "no") << std::endl;
 }
 
 /////////////////////////////////////////////////
@@ -15,6 +15,10 @@
 
 #include <string>
 #include <memory>
+#include <map>
+#include <chrono>
+#include <random>
+#include <iomanip>
 #include <gtest/gtest.h>
 #include <uuv_gazebo_plugins/ThrusterConversionFcn.hh>
 
@@ -142,6 +146,105 @@ TEST(ThrusterConversionFcn, LinearInterp)
   }
 }
 
+/// \brief Reference implementation of the linear interpolation using a
+/// lookup in a std::map, as the conversion function was implemented before
+/// storing the table in flat arrays
+double MapLinearInterp(const std::map<double, double>& _table, double _cmd)
+{
+  auto iter = _table.lower_bound(_cmd);
+  if (iter == _table.end())
+    return _table.rbegin()->second;
+  double i1 = iter->first;
+  double o1 = iter->second;
+  if (iter == _table.begin())
+    return o1;
+  iter--;
+  double i0 = iter->first;
+  double o0 = iter->second;
+  double w1 = _cmd - i0;
+  double w0 = i1 - _cmd;
+  return (o0*w0 + o1*w1)/(w0 + w1);
+}
+
+/// \brief Creates a LinearInterp conversion function for the T200 thruster
+/// like table with _n entries, either with uniform or with randomly spaced
+/// input values
+std::shared_ptr<gazebo::ConversionFunction> CreateThrustTable(int _n,
+  bool _uniform, std::map<double, double>& _table)
+{
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> jitter(-0.3, 0.3);
+
+  std::stringstream in, out;
+  in << std::setprecision(17);
+  out << std::setprecision(17);
+  _table.clear();
+  for (int i = 0; i < _n; i++)
+  {
+    double x = -1.0 + 2.0 * i / (_n - 1);
+    if (!_uniform && i > 0 && i < _n - 1)
+      x += jitter(gen) / (_n - 1);
+    double y = 40.0 * x * std::abs(x);
+    _table[x] = y;
+    in << x << " ";
+    out << y << " ";
+  }
+
+  std::stringstream stream;
+  stream << "<conversion> \n"
+         << "  <type>LinearInterp</type> \n"
+         << "  <inputValues>" << in.str() << "</inputValues> \n"
+         << "  <outputValues>" << out.str() << "</outputValues> \n"
+         << "</conversion>";
+  return ConversionFromString(stream.str());
+}
+
+TEST(ThrusterConversionFcn, LinearInterpFlatTable)
+{
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<double> cmd(-1.2, 1.2);
+  std::vector<double> inputs(10000);
+  for (double& x : inputs)
+    x = cmd(gen);
+
+  for (bool uniform : {true, false})
+  {
+    std::map<double, double> table;
+    std::shared_ptr<gazebo::ConversionFunction> func;
+    func = CreateThrustTable(201, uniform, table);
+
+    EXPECT_TRUE(func != NULL);
+
+    // The flat table must give the same results as the map lookup
+    for (double x : inputs)
+      EXPECT_NEAR(MapLinearInterp(table, x), func->convert(x), 1e-9);
+    for (auto& entry : table)
+      EXPECT_NEAR(entry.second, func->convert(entry.first), 1e-9);
+
+    // Benchmark: ns per conversion of the map lookup and the flat table
+    const int reps = 100;
+    double sumMap = 0.0, sumFlat = 0.0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; r++)
+      for (double x : inputs)
+        sumMap += MapLinearInterp(table, x);
+    auto t1 = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; r++)
+      for (double x : inputs)
+        sumFlat += func->convert(x);
+    auto t2 = std::chrono::steady_clock::now();
+
+    double n = static_cast<double>(reps * inputs.size());
+    std::cout << "LinearInterp (" << (uniform ? "uniform" : "non-uniform")
+              << " table, " << table.size() << " entries): std::map "
+              << std::chrono::duration<double, std::nano>(t1 - t0).count() / n
+              << " ns/conversion, flat table "
+              << std::chrono::duration<double, std::nano>(t2 - t1).count() / n
+              << " ns/conversion" << std::endl;
+    EXPECT_NEAR(sumMap, sumFlat, 1e-6 * std::abs(sumMap) + 1e-6);
+  }
+}
+
 int main(int argc, char **argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -15,6 +15,9 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
+
 #include <uuv_gazebo_plugins/Dynamics.hh>
 
 std::shared_ptr<gazebo::Dynamics> DynamicsFromString(
@@ -74,6 +77,11 @@ TEST(ThrusterDynamics, FirstOrder)
   EXPECT_EQ(dyn->GetType(), "FirstOrder");
   EXPECT_EQ(0.0, dyn->update(0.0, 0));
   EXPECT_NEAR(1-0.36787944, dyn->update(1.0, 0.5), 1e-5);
+
+  // The exact solution holds for arbitrarily large steps
+  EXPECT_NEAR(1.0 - 0.36787944*std::exp(-4.0), dyn->update(1.0, 2.5), 1e-8);
+  // Repeated time stamps leave the state untouched
+  EXPECT_NEAR(1.0 - 0.36787944*std::exp(-4.0), dyn->update(0.0, 2.5), 1e-8);
 }
 
 TEST(ThrusterDynamics, Yoerger)
@@ -91,7 +99,104 @@ TEST(ThrusterDynamics, Yoerger)
   EXPECT_TRUE(dyn != NULL);
   EXPECT_EQ(dyn->GetType(), "Yoerger");
   EXPECT_EQ(0.0, dyn->update(0.0, 0));
-  // TODO: Actually test dynamic behavior
+  EXPECT_EQ(gazebo::Dynamics::EULER, dyn->GetIntegrator());
+
+  // Explicit Euler: x1 = dt*beta*u
+  EXPECT_NEAR(0.05, dyn->update(1.0, 0.1), 1e-12);
+}
+
+// For constant u > 0 and x(0) = 0 the Yoerger model has the closed-form
+// solution x(t) = sqrt(beta*u/alpha)*tanh(sqrt(alpha*beta*u)*t).
+double YoergerSolution(double _alpha, double _beta, double _u, double _t)
+{
+  return std::sqrt(_beta*_u/_alpha)*std::tanh(std::sqrt(_alpha*_beta*_u)*_t);
+}
+
+TEST(ThrusterDynamics, YoergerIntegrators)
+{
+  const double alpha = 0.5, beta = 2.0, u = 3.0;
+  const char* integrators[] = {"rk4", "adaptive"};
+  const double steps[] = {0.1, 0.5};
+
+  for (const char* integrator : integrators)
+  {
+    for (double dt : steps)
+    {
+      std::stringstream description;
+      description << "<dynamics>\n"
+                  << "  <type>Yoerger</type>\n"
+                  << "  <alpha>" << alpha << "</alpha>\n"
+                  << "  <beta>" << beta << "</beta>\n"
+                  << "  <integrator>" << integrator << "</integrator>\n"
+                  << "  <maxStep>0.1</maxStep>\n"
+                  << "</dynamics>";
+
+      std::shared_ptr<gazebo::Dynamics> dyn;
+      dyn = DynamicsFromString(description.str());
+      ASSERT_TRUE(dyn != NULL);
+
+      dyn->update(0.0, 0.0);
+      for (int i = 1; i <= static_cast<int>(3.0/dt + 0.5); i++)
+      {
+        double t = i*dt;
+        EXPECT_NEAR(YoergerSolution(alpha, beta, u, t), dyn->update(u, t),
+                    1e-4) << integrator << " dt=" << dt << " t=" << t;
+      }
+    }
+  }
+}
+
+TEST(ThrusterDynamics, YoergerLargeStep)
+{
+  // With alpha*beta*u = 3 a single Euler step of 0.5 s overshoots and
+  // oscillates; both higher-order schemes must remain on the solution.
+  std::string euler =
+        "<dynamics>\n"
+        "  <type>Yoerger</type>\n"
+        "  <alpha>0.5</alpha>\n"
+        "  <beta>2.0</beta>\n"
+        "</dynamics>";
+  std::string adaptive =
+        "<dynamics>\n"
+        "  <type>Yoerger</type>\n"
+        "  <alpha>0.5</alpha>\n"
+        "  <beta>2.0</beta>\n"
+        "  <integrator>adaptive</integrator>\n"
+        "</dynamics>";
+
+  std::shared_ptr<gazebo::Dynamics> dynEuler = DynamicsFromString(euler);
+  std::shared_ptr<gazebo::Dynamics> dynAdaptive =
+      DynamicsFromString(adaptive);
+  ASSERT_TRUE(dynEuler != NULL);
+  ASSERT_TRUE(dynAdaptive != NULL);
+  EXPECT_EQ(gazebo::Dynamics::ADAPTIVE, dynAdaptive->GetIntegrator());
+
+  dynEuler->update(0.0, 0.0);
+  dynAdaptive->update(0.0, 0.0);
+  double errEuler = 0.0, errAdaptive = 0.0;
+  for (int i = 1; i <= 10; i++)
+  {
+    double t = 0.5*i;
+    double ref = YoergerSolution(0.5, 2.0, 3.0, t);
+    errEuler = std::max(errEuler, std::abs(dynEuler->update(3.0, t) - ref));
+    errAdaptive = std::max(errAdaptive,
+                           std::abs(dynAdaptive->update(3.0, t) - ref));
+  }
+  EXPECT_GT(errEuler, 0.1);
+  EXPECT_LT(errAdaptive, 1e-4);
+}
+
+TEST(ThrusterDynamics, UnknownIntegrator)
+{
+  std::string description =
+        "<dynamics>\n"
+        "  <type>Yoerger</type>\n"
+        "  <alpha>0.5</alpha>\n"
+        "  <beta>0.5</beta>\n"
+        "  <integrator>midpoint</integrator>\n"
+        "</dynamics>";
+
+  EXPECT_TRUE(DynamicsFromString(description) == NULL);
 }
 
 TEST(ThrusterDynamics, Bessa)
@@ -112,7 +217,52 @@ TEST(ThrusterDynamics, Bessa)
   EXPECT_TRUE(dyn != NULL);
   EXPECT_EQ(dyn->GetType(), "Bessa");
   EXPECT_EQ(0.0, dyn->update(0.0, 0));
-  // TODO: Actually test dynamic behavior
+}
+
+TEST(ThrusterDynamics, BessaIntegrators)
+{
+  // For constant u and x > 0 the model is a Riccati equation
+  //   Jmsp*dx/dt = -Kv2*(x - r1)*(x - r2),
+  // with r1 > 0 > r2 the roots of Kv2*x^2 + Kv1*x - u*Kt/Rm. Starting
+  // from rest, x(t) = r1*r2*(1 - e)/(r2 - r1*e) with e = exp(-k*t) and
+  // k = Kv2*(r1 - r2)/Jmsp.
+  const double Jmsp = 0.5, Kv1 = 0.5, Kv2 = 0.5, Kt = 0.5, Rm = 0.5;
+  const double u = 2.0;
+  const double c = u*Kt/Rm;
+  const double disc = std::sqrt(Kv1*Kv1 + 4.0*Kv2*c);
+  const double r1 = (-Kv1 + disc)/(2.0*Kv2);
+  const double r2 = (-Kv1 - disc)/(2.0*Kv2);
+  const double k = Kv2*(r1 - r2)/Jmsp;
+
+  const char* integrators[] = {"rk4", "adaptive"};
+  for (const char* integrator : integrators)
+  {
+    std::stringstream description;
+    description << "<dynamics>\n"
+                << "  <type>Bessa</type>\n"
+                << "  <Jmsp>" << Jmsp << "</Jmsp>\n"
+                << "  <Kv1>" << Kv1 << "</Kv1>\n"
+                << "  <Kv2>" << Kv2 << "</Kv2>\n"
+                << "  <Kt>" << Kt << "</Kt>\n"
+                << "  <Rm>" << Rm << "</Rm>\n"
+                << "  <integrator>" << integrator << "</integrator>\n"
+                << "  <maxStep>0.05</maxStep>\n"
+                << "</dynamics>";
+
+    std::shared_ptr<gazebo::Dynamics> dyn;
+    dyn = DynamicsFromString(description.str());
+    ASSERT_TRUE(dyn != NULL);
+
+    dyn->update(0.0, 0.0);
+    for (int i = 1; i <= 10; i++)
+    {
+      double t = 0.25*i;
+      double e = std::exp(-k*t);
+      double expected = r1*r2*(1.0 - e)/(r2 - r1*e);
+      EXPECT_NEAR(expected, dyn->update(u, t), 1e-5)
+          << integrator << " t=" << t;
+    }
+  }
 }
 
 
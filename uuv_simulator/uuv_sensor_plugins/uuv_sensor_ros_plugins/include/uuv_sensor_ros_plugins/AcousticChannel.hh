@@ -0,0 +1,166 @@
+// Copyright (c) 2016 The UUV Simulator Authors.
+// All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef __ACOUSTIC_CHANNEL_HH__
+#define __ACOUSTIC_CHANNEL_HH__
+
+#include <gazebo/common/common.hh>
+#include <gazebo/physics/physics.hh>
+#include <ignition/math/Vector3.hh>
+#include <uuv_sensor_ros_plugins/SensorScheduler.hh>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace gazebo
+{
+  /// \brief Underwater acoustic channel shared by the acoustic sensors of a
+  /// world. It computes the propagation of acoustic signals, directly or
+  /// reflected at the sea surface, and delivers messages when they arrive.
+  /// Pending messages are kept in a queue ordered by arrival time that is
+  /// checked once per physics step for all senders, instead of every sensor
+  /// polling for its own messages.
+  class AcousticChannel
+  {
+    /// \brief Function delivering a message
+    public: typedef std::function<void()> Callback;
+
+    /// \brief Returns the channel of the world, created on first use.
+    /// The channel lives as long as someone holds the pointer.
+    public: static std::shared_ptr<AcousticChannel> Get(
+      physics::WorldPtr _world);
+
+    /// \brief Creates a channel that is not shared, delivering its messages
+    /// in the updates of _scheduler. Plugins use Get().
+    public: explicit AcousticChannel(
+      std::shared_ptr<SensorScheduler> _scheduler);
+
+    /// \brief Class destructor
+    public: ~AcousticChannel();
+
+    /// \brief Speed of sound [m/s]
+    public: double SoundSpeed();
+
+    /// \brief Sets the speed of sound [m/s] for all users of the channel
+    public: void SetSoundSpeed(double _speed);
+
+    /// \brief Height of the sea surface in the world frame [m]
+    public: double SurfaceHeight();
+
+    /// \brief Sets the height of the sea surface in the world frame [m]
+    public: void SetSurfaceHeight(double _height);
+
+    /// \brief Length of the direct path between two points [m]
+    public: static double DirectPath(const ignition::math::Vector3d &_from,
+      const ignition::math::Vector3d &_to);
+
+    /// \brief Length of the path between two points reflected once at the
+    /// sea surface [m]
+    public: double SurfacePath(const ignition::math::Vector3d &_from,
+      const ignition::math::Vector3d &_to);
+
+    /// \brief Seconds a signal needs to travel a path of length _length
+    public: double TravelTime(double _length);
+
+    /// \brief Registers a sender, returns its ID for Send()
+    public: int AddSender();
+
+    /// \brief Removes a sender, its messages that did not arrive yet are
+    /// dropped
+    public: void RemoveSender(int _sender);
+
+    /// \brief Calls _callback once the simulation time reaches _arrival.
+    /// Messages are delivered in the order of their arrival times, and in
+    /// the order they were sent if these are equal.
+    public: void Send(int _sender, double _arrival,
+      const Callback &_callback);
+
+    /// \brief Number of messages that did not arrive yet
+    public: size_t Pending();
+
+    /// \brief Delivers the messages that arrived by the current time
+    private: void OnUpdate(const common::UpdateInfo &_info);
+
+    /// \brief A message on its way
+    private: struct Message
+    {
+      /// \brief Simulation time of the arrival
+      double arrival;
+
+      /// \brief Order of sending, breaks ties between equal arrival times
+      uint64_t sequence;
+
+      /// \brief ID of the sender
+      int sender;
+
+      /// \brief Delivery function
+      Callback callback;
+
+      /// \brief Order of a min-heap on the arrival time
+      bool operator<(const Message &_other) const
+      {
+        if (this->arrival != _other.arrival)
+          return this->arrival > _other.arrival;
+        return this->sequence > _other.sequence;
+      }
+    };
+
+    /// \brief Messages ordered by arrival time
+    private: std::priority_queue<Message> messages;
+
+    /// \brief IDs of the registered senders
+    private: std::set<int> senders;
+
+    /// \brief ID of the next sender
+    private: int nextSender;
+
+    /// \brief Number of messages sent so far
+    private: uint64_t sequence;
+
+    /// \brief Speed of sound [m/s]
+    private: double soundSpeed;
+
+    /// \brief Height of the sea surface [m]
+    private: double surfaceHeight;
+
+    /// \brief Simulation time of the last update
+    private: double lastTime;
+
+    /// \brief Recursive so that callbacks may send messages
+    private: std::recursive_mutex mutex;
+
+    /// \brief Scheduler running the deliveries
+    private: std::shared_ptr<SensorScheduler> scheduler;
+
+    /// \brief ID of the delivery in the scheduler
+    private: int schedulerId;
+
+    /// \brief Channels by world name
+    private: static std::map<std::string, std::weak_ptr<AcousticChannel>>
+      channels;
+
+    /// \brief Protects channels
+    private: static std::mutex channelsMutex;
+  };
+}
+
+#endif // __ACOUSTIC_CHANNEL_HH__
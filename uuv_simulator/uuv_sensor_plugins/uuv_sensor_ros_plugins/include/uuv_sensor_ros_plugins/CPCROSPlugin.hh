@@ -22,7 +22,8 @@
 #include <uuv_sensor_ros_plugins_msgs/ChemicalParticleConcentration.h>
 #include <uuv_sensor_ros_plugins_msgs/Salinity.h>
 #include <sensor_msgs/PointCloud.h>
-#include <uuv_sensor_ros_plugins/ROSBaseModelPlugin.hh>
+#include <uuv_sensor_ros_plugins/PlumeParticleIndex.hh>
+#include <memory>
 
 namespace gazebo
 {
@@ -63,6 +64,10 @@ namespace gazebo
     // account in the concentration computation
     protected: double smoothingLength;
 
+    /// \brief Grid over the plume particles, shared with the other sensors
+    /// on the same plume topic
+    protected: std::shared_ptr<PlumeParticleIndex> plumeIndex;
+
     /// \brief Last update from the point cloud callback
     protected: ros::Time lastUpdateTimestamp;
 
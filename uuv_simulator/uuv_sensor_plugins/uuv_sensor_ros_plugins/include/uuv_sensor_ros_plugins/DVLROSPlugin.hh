@@ -17,6 +17,7 @@
 #define __UUV_DVL_ROS_PLUGIN_HH__
 
 #include <gazebo/gazebo.hh>
+#include <gazebo/physics/RayShape.hh>
 #include <ros/ros.h>
 #include <boost/bind.hpp>
 #include <boost/shared_ptr.hpp>
@@ -26,16 +27,17 @@
 #include <uuv_sensor_ros_plugins/ROSBaseModelPlugin.hh>
 #include <uuv_sensor_ros_plugins_msgs/DVL.h>
 #include <uuv_sensor_ros_plugins_msgs/DVLBeam.h>
-#include <message_filters/subscriber.h>
-#include <message_filters/time_synchronizer.h>
-#include <tf/transform_listener.h>
 #include <vector>
 #include "SensorDvl.pb.h"
 
 #define ALTITUDE_OUT_OF_RANGE -1.0
 namespace gazebo
 {
-  /// TODO: Modify computation of velocity using the beams
+  /// \brief Doppler velocity log. The acoustic beams are cast as rays into
+  /// the physics scene on every update, each beam measures the projection of
+  /// its own velocity on the beam axis and the velocity vector is solved from
+  /// all beams with a bottom return. With less than three returns the bottom
+  /// lock is lost and the velocity is flagged as invalid.
   class DVLROSPlugin : public ROSBaseModelPlugin
   {
     /// \brief Class constructor
@@ -50,20 +52,45 @@ namespace gazebo
     /// \brief Update sensor measurement
     protected: virtual bool OnUpdate(const common::UpdateInfo& _info);
 
-    /// \brief Get beam Range message update
-    protected: void OnBeamCallback(const sensor_msgs::RangeConstPtr& _range0,
-      const sensor_msgs::RangeConstPtr& _range1,
-      const sensor_msgs::RangeConstPtr& _range2,
-      const sensor_msgs::RangeConstPtr& _range3);
+    /// \brief Casts all beams from the DVL pose and stores the ranges,
+    /// returns the number of beams with a bottom return
+    protected: int CastBeams(const ignition::math::Pose3d &_pose);
 
-    /// \brief Updates the poses of each beam wrt the DVL frame
-    protected: bool UpdateBeamTransforms();
+    /// \brief Publishes the beam ranges on the optional beam topics
+    protected: void PublishBeamRanges(const common::Time &_time);
 
-    protected: bool beamTransformsInitialized;
+    /// \brief Inverts a 3x3 matrix, returns false if it is singular
+    public: static bool InvertMatrix3(const double _m[3][3],
+      double _inv[3][3]);
+
+    /// \brief Least squares solution _vel of the velocities _beamVel
+    /// measured along the unit vectors _dirs, and its covariance
+    /// _sigma^2 (D^T D)^-1 for a per-beam noise _sigma. Returns false if
+    /// there are less than three beams or they do not span three
+    /// dimensions.
+    public: static bool SolveBeamVelocity(
+      const std::vector<ignition::math::Vector3d> &_dirs,
+      const std::vector<double> &_beamVel, double _sigma,
+      ignition::math::Vector3d &_vel, double _cov[3][3]);
 
     /// \brief Measured altitude in meters
     protected: double altitude;
 
+    /// \brief True while enough beams have a bottom return
+    protected: bool bottomLock;
+
+    /// \brief Minimum range of the beams [m]
+    protected: double beamMinRange;
+
+    /// \brief Maximum range of the beams [m]
+    protected: double beamMaxRange;
+
+    /// \brief Standard deviation of the noise on each beam range [m]
+    protected: double beamRangeNoiseSigma;
+
+    /// \brief Handle of the beam range noise model
+    protected: NoiseGenerator::Model beamRangeNoise;
+
     /// \brief ROS DVL message
     protected: uuv_sensor_ros_plugins_msgs::DVL dvlROSMsg;
 
@@ -81,26 +108,27 @@ namespace gazebo
     /// \brief List of beam topics
     protected: std::vector<std::string> beamTopics;
 
+    /// \brief Publishers of the beam ranges, if beam topics are given
+    protected: std::vector<ros::Publisher> beamRangePubs;
+
     /// \brief List of poses of each beam wrt to the DVL frame
     protected: std::vector<ignition::math::Pose3d> beamPoses;
 
-    protected: boost::shared_ptr<message_filters::TimeSynchronizer<
-      sensor_msgs::Range, sensor_msgs::Range, sensor_msgs::Range, sensor_msgs::Range>>
-      syncBeamMessages;
-
-    protected: boost::shared_ptr<message_filters::Subscriber<
-      sensor_msgs::Range>> beamSub0;
+    /// \brief Unit vector of each beam axis wrt to the DVL frame
+    protected: std::vector<ignition::math::Vector3d> beamDirections;
 
-    protected: boost::shared_ptr<message_filters::Subscriber<
-      sensor_msgs::Range>> beamSub1;
+    /// \brief Last range measured by each beam, negative if no return
+    protected: std::vector<double> beamRanges;
 
-    protected: boost::shared_ptr<message_filters::Subscriber<
-      sensor_msgs::Range>> beamSub2;
+    /// \brief Ray shape used to cast each beam
+    protected: std::vector<physics::RayShapePtr> beamRays;
 
-    protected: boost::shared_ptr<message_filters::Subscriber<
-      sensor_msgs::Range>> beamSub3;
+    /// \brief Directions of the beams with a bottom return in the last
+    /// update, reused between updates
+    protected: std::vector<ignition::math::Vector3d> returnDirections;
 
-    protected: tf::TransformListener transformListener;
+    /// \brief Velocities measured by the beams with a bottom return
+    protected: std::vector<double> returnVelocities;
   };
 }
 
@@ -117,6 +117,32 @@ namespace gazebo
     /// \brief Update sensor measurement
     protected: virtual bool OnUpdate(const common::UpdateInfo& _info);
 
+    /// \brief Creates the noise models and turn-on biases and writes the
+    /// measurement covariances to the ROS IMU message
+    protected: void InitNoiseModels();
+
+    /// \brief Computes the noisy measurements from the state of the sensor
+    /// link and writes them to the ROS and, if enabled, Gazebo messages.
+    /// This is all of an update except reading the link and publishing.
+    protected: void UpdateMeasurement(
+                 const ignition::math::Quaterniond& _linkRot,
+                 const ignition::math::Vector3d& _bodyAngVel,
+                 const ignition::math::Vector3d& _bodyLinAcc, double _dt,
+                 const common::Time& _simTime);
+
+    /// \brief Computes the ideal measurements from the world orientation,
+    /// angular velocity and linear acceleration of the sensor link
+    protected: void ComputeMeasurement(
+                 const ignition::math::Quaterniond& _linkRot,
+                 const ignition::math::Vector3d& _bodyAngVel,
+                 const ignition::math::Vector3d& _bodyLinAcc);
+
+    /// \brief Writes the constant covariances to the Gazebo IMU message
+    protected: void InitGazeboMessage();
+
+    /// \brief Writes the last measurements to the Gazebo IMU message
+    protected: void FillGazeboMessage();
+
     /// \brief Apply and add nosie model to ideal measurements.
     protected: void AddNoise(ignition::math::Vector3d& _linAcc,
                              ignition::math::Vector3d& _angVel,
@@ -147,11 +173,35 @@ namespace gazebo
     /// \brief Constant turn-on accelerometer bias.
     protected: ignition::math::Vector3d accelerometerTurnOnBias;
 
+    /// \brief Gyroscope white noise model
+    protected: NoiseGenerator::Model gyroNoise;
+
+    /// \brief Accelerometer white noise model
+    protected: NoiseGenerator::Model accNoise;
+
+    /// \brief Orientation white noise model
+    protected: NoiseGenerator::Model orientationNoise;
+
+    /// \brief Gyroscope bias drift model
+    protected: NoiseGenerator::Model gyroBiasNoise;
+
+    /// \brief Accelerometer bias drift model
+    protected: NoiseGenerator::Model accBiasNoise;
+
     /// \brief IMU model parameters.
     protected: IMUParameters imuParameters;
 
     /// \brief ROS IMU message
     protected: sensor_msgs::Imu imuROSMessage;
+
+    /// \brief Gazebo IMU message, the covariances are set on load
+    protected: sensor_msgs::msgs::Imu imuGazeboMessage;
+
+    /// \brief Inverse rotation of the reference frame
+    protected: ignition::math::Quaterniond referenceRotInverse;
+
+    /// \brief Flag set to true once referenceRotInverse was computed
+    protected: bool isReferenceRotInit;
   };
 }
 
@@ -76,6 +76,12 @@ namespace gazebo
     /// \brief Constant turn-on bias [muT].
     protected: ignition::math::Vector3d turnOnBias;
 
+    /// \brief Noise model of the horizontal axes
+    protected: NoiseGenerator::Model noiseXY;
+
+    /// \brief Noise model of the vertical axis
+    protected: NoiseGenerator::Model noiseZ;
+
     /// \brief Last measurement of magnetic field
     protected: ignition::math::Vector3d measMagneticField;
 
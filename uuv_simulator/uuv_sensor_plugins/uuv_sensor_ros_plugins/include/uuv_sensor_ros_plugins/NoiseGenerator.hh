@@ -0,0 +1,123 @@
+// Copyright (c) 2016 The UUV Simulator Authors.
+// All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __UUV_NOISE_GENERATOR_HH__
+#define __UUV_NOISE_GENERATOR_HH__
+
+#include <ignition/math/Vector3.hh>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gazebo
+{
+  /// \brief Gaussian noise source of one sensor plugin. Noise models are
+  /// referenced by integer handles and draw from a private random stream,
+  /// so no sample needs a lookup or a lock. Standard normal samples are
+  /// generated in blocks, so drawing one is an array read.
+  class NoiseGenerator
+  {
+    /// \brief Handle of a noise model
+    public: typedef int Model;
+
+    /// \brief Class constructor
+    public: explicit NoiseGenerator(uint64_t _seed = 0);
+
+    /// \brief Restart the random stream
+    public: void Seed(uint64_t _seed);
+
+    /// \brief Seed derived from a world seed and a name unique to the
+    /// plugin, so every plugin gets its own reproducible stream
+    public: static uint64_t StreamSeed(uint64_t _worldSeed,
+      const std::string &_name);
+
+    /// \brief White noise with standard deviation _sigma
+    public: Model AddWhite(double _sigma);
+
+    /// \brief White noise given as a density [unit/sqrt(Hz)], the standard
+    /// deviation of a sample is _density / sqrt(dt)
+    public: Model AddWhiteDensity(double _density);
+
+    /// \brief Colored noise, e.g. a drifting bias: a first order
+    /// Gauss-Markov process per axis with random walk _sigma
+    /// [unit/s/sqrt(Hz)] and correlation time _tau [s]. _tau <= 0 gives a
+    /// pure random walk.
+    public: Model AddGaussMarkov(double _sigma, double _tau);
+
+    /// \brief Number of models
+    public: size_t Size() const { return this->models.size(); }
+
+    /// \brief One sample of a white noise model, scaled by _amp
+    public: double Sample(Model _model, double _amp, double _dt = 1.0);
+
+    /// \brief Three samples of a white noise model, or the next state of a
+    /// Gauss-Markov model after _dt seconds, with its driving noise scaled
+    /// by _amp
+    public: ignition::math::Vector3d Sample3(Model _model, double _amp,
+      double _dt = 1.0);
+
+    /// \brief A standard normal sample
+    public: double Normal()
+    {
+      if (this->next == kBlockSize)
+        this->Refill();
+      return this->block[this->next++];
+    }
+
+    /// \brief A sample uniformly distributed in [0, 1), drawn from the same
+    /// stream, e.g. to decide on random events
+    public: double Uniform();
+
+    /// \brief Number of samples generated per block
+    public: static const size_t kBlockSize = 256;
+
+    /// \brief Generate the next block of standard normal samples
+    private: void Refill();
+
+    /// \brief Next raw random number (xoshiro256**)
+    private: uint64_t NextRandom();
+
+    /// \brief Model types
+    private: enum Type
+    {
+      WHITE,
+      WHITE_DENSITY,
+      GAUSS_MARKOV
+    };
+
+    /// \brief Noise model parameters and state
+    private: struct ModelData
+    {
+      Type type;
+      double sigma;
+      double tau;
+      ignition::math::Vector3d state;
+    };
+
+    /// \brief Noise models by handle
+    private: std::vector<ModelData> models;
+
+    /// \brief State of the random number generator
+    private: uint64_t rng[4];
+
+    /// \brief Current block of standard normal samples
+    private: double block[kBlockSize];
+
+    /// \brief Index of the next unused sample in block
+    private: size_t next;
+  };
+}
+
+#endif // __UUV_NOISE_GENERATOR_HH__
@@ -0,0 +1,135 @@
+// Copyright (c) 2016 The UUV Simulator Authors.
+// All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __UUV_PLUME_PARTICLE_INDEX_HH__
+#define __UUV_PLUME_PARTICLE_INDEX_HH__
+
+#include <ignition/math/Vector3.hh>
+#include <sensor_msgs/PointCloud.h>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace gazebo
+{
+  /// \brief Uniform grid over the particles of a plume point cloud, used to
+  /// evaluate the SPH concentration kernel at a position. The grid is built
+  /// once per cloud and shared by all concentration sensors listening to
+  /// the same topic with the same kernel parameters, so a query only visits
+  /// the particles in the cells around the sensor.
+  class PlumeParticleIndex
+  {
+    /// \brief Returns the index for a plume topic and kernel parameters,
+    /// created on first use. It lives as long as someone holds the pointer.
+    public: static std::shared_ptr<PlumeParticleIndex> Get(
+      const std::string &_topic, double _smoothingLength, double _gamma);
+
+    /// \brief Kernel sum of the particles of _cloud around _pos. The grid
+    /// is rebuilt if _cloud is not the cloud currently indexed.
+    public: double Concentration(
+      const sensor_msgs::PointCloud::ConstPtr &_cloud,
+      const ignition::math::Vector3d &_pos);
+
+    /// \brief Indices in _cloud of the particles whose kernel support
+    /// contains _pos, in no particular order. The grid is rebuilt if _cloud
+    /// is not the cloud currently indexed.
+    public: void Neighbors(const sensor_msgs::PointCloud::ConstPtr &_cloud,
+      const ignition::math::Vector3d &_pos, std::vector<size_t> &_indices);
+
+    /// \brief Number of particles indexed
+    public: size_t Size();
+
+    /// \brief Class constructor, use Get()
+    private: PlumeParticleIndex(double _smoothingLength, double _gamma);
+
+    /// \brief Returns true if _cloud is the cloud currently indexed
+    private: bool IsIndexed(const sensor_msgs::PointCloud::ConstPtr &_cloud)
+      const;
+
+    /// \brief Builds the grid for a new cloud
+    private: void Build(const sensor_msgs::PointCloud::ConstPtr &_cloud);
+
+    /// \brief Index of the cell containing a position along one axis,
+    /// clamped to the grid
+    private: int64_t CellCoord(double _pos, int _axis) const;
+
+    /// \brief Calls _fn with every particle whose kernel support contains
+    /// _pos and its squared distance to _pos
+    private: template<typename Fn>
+      void ForEachNeighbor(const ignition::math::Vector3d &_pos, Fn _fn)
+      const;
+
+    /// \brief A particle with its kernel parameters
+    private: struct Particle
+    {
+      /// \brief Position
+      double x, y, z;
+
+      /// \brief Index of the particle in the cloud
+      uint32_t index;
+
+      /// \brief Inverse of the smoothing parameter
+      double invH;
+
+      /// \brief Square of the kernel support, 2 * smoothing parameter
+      double supportSq;
+
+      /// \brief Kernel normalization, 1 / (4 pi h^3)
+      double norm;
+    };
+
+    /// \brief Radius of the kernel at the particle's creation
+    private: double smoothingLength;
+
+    /// \brief Growth rate of the smoothing parameter
+    private: double gamma;
+
+    /// \brief Cloud currently indexed
+    private: sensor_msgs::PointCloud::ConstPtr cloud;
+
+    /// \brief Particles sorted by cell
+    private: std::vector<Particle> particles;
+
+    /// \brief Index of the first particle of each cell, plus one entry
+    /// with the number of particles
+    private: std::vector<uint32_t> cellStart;
+
+    /// \brief Lower corner of the grid
+    private: double origin[3];
+
+    /// \brief Number of cells along each axis
+    private: int64_t dims[3];
+
+    /// \brief Edge length of a cell, at least the largest kernel support
+    private: double cellSize;
+
+    /// \brief Protects the grid, clouds and queries may arrive on
+    /// different callback threads
+    private: std::mutex mutex;
+
+    /// \brief Indices by topic and kernel parameters
+    private: static std::map<std::tuple<std::string, double, double>,
+      std::weak_ptr<PlumeParticleIndex>> indices;
+
+    /// \brief Protects indices
+    private: static std::mutex indicesMutex;
+  };
+}
+
+#endif // __UUV_PLUME_PARTICLE_INDEX_HH__
@@ -30,8 +30,6 @@
 #include <ros/ros.h>
 #include <nav_msgs/Odometry.h>
 #include <gazebo/physics/physics.hh>
-#include <geometry_msgs/TransformStamped.h>
-#include <tf2_ros/transform_listener.h>
 #include <boost/shared_ptr.hpp>
 #include <uuv_sensor_ros_plugins/ROSBaseModelPlugin.hh>
 
@@ -74,10 +72,6 @@ namespace gazebo
 
     protected: bool publishNEDOdom;
 
-    protected: tf2_ros::Buffer tfBuffer;
-
-    protected: boost::shared_ptr<tf2_ros::TransformListener> tfListener;
-
     protected: ignition::math::Vector3d lastLinVel;
     protected: ignition::math::Vector3d lastAngVel;
     protected: ignition::math::Vector3d linAcc;
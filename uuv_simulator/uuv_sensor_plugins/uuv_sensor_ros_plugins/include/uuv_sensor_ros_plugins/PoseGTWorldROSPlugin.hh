@@ -0,0 +1,155 @@
+// Copyright (c) 2016 The UUV Simulator Authors.
+// All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef __UUV_POSE_GT_WORLD_ROS_PLUGIN_HH__
+#define __UUV_POSE_GT_WORLD_ROS_PLUGIN_HH__
+
+#include <gazebo/gazebo.hh>
+#include <gazebo/common/Plugin.hh>
+#include <gazebo/physics/physics.hh>
+#include <ros/ros.h>
+#include <nav_msgs/Odometry.h>
+#include <uuv_sensor_ros_plugins/Common.hh>
+#include <uuv_sensor_ros_plugins/SensorScheduler.hh>
+#include <uuv_sensor_ros_plugins/StaticTransformCache.hh>
+#include <uuv_sensor_ros_plugins_msgs/OdometryArray.h>
+#include <boost/shared_ptr.hpp>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace gazebo
+{
+  /// \brief Publishes the ground truth odometry of several vehicles from a
+  /// single world plugin. The links of all vehicles are read in one pass at
+  /// a fixed rate, so all messages of a cycle carry the same simulation time
+  /// stamp. The odometry is published as one OdometryArray message and,
+  /// optionally, per vehicle in the format of PoseGTROSPlugin.
+  ///
+  /// Vehicles are given as <vehicle> elements with a <model_name> and
+  /// optionally a <link_name> (the canonical link by default) and a <topic>
+  /// (<model_name>/pose_gt by default). Without <vehicle> elements all
+  /// non-static models of the world are published. Models spawned after
+  /// the world was loaded are picked up as they appear.
+  class PoseGTWorldROSPlugin : public WorldPlugin
+  {
+    /// \brief Class constructor
+    public: PoseGTWorldROSPlugin();
+
+    /// \brief Class destructor
+    public: virtual ~PoseGTWorldROSPlugin();
+
+    /// \brief Load the plugin
+    public: virtual void Load(physics::WorldPtr _world, sdf::ElementPtr _sdf);
+
+    /// \brief Reads the state of all vehicles and publishes their odometry
+    protected: void OnUpdate(const common::UpdateInfo &_info);
+
+    /// \brief Looks up the vehicles' links if the models of the world
+    /// changed
+    protected: void ResolveVehicles();
+
+    /// \brief Writes a pose and twist into an odometry message
+    protected: static void FillOdometry(nav_msgs::Odometry &_msg,
+      const ignition::math::Pose3d &_pose,
+      const ignition::math::Vector3d &_linVel,
+      const ignition::math::Vector3d &_angVel);
+
+    /// \brief A vehicle whose odometry is published
+    protected: struct Vehicle
+    {
+      /// \brief Name of the model
+      std::string modelName;
+
+      /// \brief Name of the link, empty for the canonical link
+      std::string linkName;
+
+      /// \brief Link whose state is published, NULL until it is found
+      physics::LinkPtr link;
+
+      /// \brief Publisher of the vehicle's odometry
+      ros::Publisher odomPub;
+
+      /// \brief Publisher of the vehicle's odometry wrt world_ned
+      ros::Publisher nedOdomPub;
+
+      /// \brief Index of the vehicle's entry in the array message, -1 if
+      /// the link was not found
+      int index;
+
+      /// \brief NED odometry message, reused between updates
+      nav_msgs::Odometry nedOdomMsg;
+    };
+
+    /// \brief Pointer to the world
+    protected: physics::WorldPtr world;
+
+    /// \brief ROS node handle
+    protected: boost::shared_ptr<ros::NodeHandle> rosNode;
+
+    /// \brief Publisher of the odometry of all vehicles
+    protected: ros::Publisher arrayPub;
+
+    /// \brief Odometry of all vehicles, reused between updates and also
+    /// published per vehicle
+    protected: uuv_sensor_ros_plugins_msgs::OdometryArray arrayMsg;
+
+    /// \brief Vehicles in the order of the array message
+    protected: std::vector<Vehicle> vehicles;
+
+    /// \brief Flag set to true if all non-static models are published
+    protected: bool trackAllModels;
+
+    /// \brief Models of the world when they were last scanned. They are
+    /// held so that a removed model is not mistaken for a newly spawned
+    /// one at the same address.
+    protected: physics::Model_V models;
+
+    /// \brief Flag set to true if the array message is published
+    protected: bool publishArray;
+
+    /// \brief Flag set to true if a message per vehicle is published
+    protected: bool publishPerVehicle;
+
+    /// \brief Flag set to true if the odometry wrt world_ned is published
+    /// per vehicle as well
+    protected: bool publishNEDOdom;
+
+    /// \brief Pose of world_ned wrt world
+    protected: ignition::math::Pose3d nedReference;
+
+    /// \brief Flag set to true once the pose of world_ned is known
+    protected: bool isNEDReferenceInit;
+
+    /// \brief Protects nedReference, which is set from the ROS thread
+    protected: std::mutex nedMutex;
+
+    /// \brief Fixed frames of the world, resolves world_ned
+    protected: std::shared_ptr<StaticTransformCache> transformCache;
+
+    /// \brief ID of the wait for world_ned, -1 if none
+    protected: int nedWatchId;
+
+    /// \brief Scheduler running the updates
+    protected: std::shared_ptr<SensorScheduler> scheduler;
+
+    /// \brief ID of the update in the scheduler
+    protected: int schedulerId;
+  };
+}
+
+#endif // __UUV_POSE_GT_WORLD_ROS_PLUGIN_HH__
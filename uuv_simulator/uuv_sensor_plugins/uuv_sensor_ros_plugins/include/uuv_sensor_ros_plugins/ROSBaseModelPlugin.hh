@@ -20,6 +20,7 @@
 #include <gazebo/gazebo.hh>
 #include <gazebo/physics/physics.hh>
 #include <uuv_sensor_ros_plugins/ROSBasePlugin.hh>
+#include <uuv_sensor_ros_plugins/SensorScheduler.hh>
 #include <functional>
 #include <memory>
 #include <string>
@@ -66,6 +67,13 @@ namespace gazebo
 
     /// \brief Returns true if the base_link_ned frame exists
     protected: void SendLocalNEDTransform();
+
+    /// \brief Scheduler calling OnUpdate() at the update rate, shared by
+    /// all sensor plugins of the world
+    protected: std::shared_ptr<SensorScheduler> scheduler;
+
+    /// \brief ID of this plugin's entry in the scheduler
+    protected: int schedulerId;
   };
 }
 
@@ -19,6 +19,8 @@
 #include <gazebo/common/common.hh>
 #include <gazebo/physics/physics.hh>
 #include <uuv_sensor_ros_plugins/Common.hh>
+#include <uuv_sensor_ros_plugins/NoiseGenerator.hh>
+#include <uuv_sensor_ros_plugins/StaticTransformCache.hh>
 #include <ros/ros.h>
 #include <std_msgs/Bool.h>
 #include <uuv_sensor_ros_plugins_msgs/ChangeSensorState.h>
@@ -26,10 +28,8 @@
 #include <gazebo/sensors/Noise.hh>
 #include <boost/shared_ptr.hpp>
 #include <boost/bind.hpp>
-#include <tf/tfMessage.h>
 #include <tf/tf.h>
-#include <chrono>
-#include <random>
+#include <memory>
 #include <string>
 #include <map>
 
@@ -82,12 +82,14 @@ namespace gazebo
     /// the sensor messages needed are only ROS messages
     protected: bool gazeboMsgEnabled;
 
-    /// \brief Pseudo random number generator
-    protected: std::default_random_engine rndGen;
+    /// \brief Noise source of this plugin, seeded from the world seed
+    protected: NoiseGenerator noise;
 
-    /// \brief Normal distribution describing the noise models
-    protected: std::map<std::string, std::normal_distribution<double>>
-      noiseModels;
+    /// \brief Handles of the named Gaussian noise models
+    protected: std::map<std::string, NoiseGenerator::Model> noiseModels;
+
+    /// \brief Handle of the default Gaussian noise model
+    protected: NoiseGenerator::Model defaultNoiseModel;
 
     /// \brief Flag to control the generation of output messages
     protected: std_msgs::Bool isOn;
@@ -110,11 +112,17 @@ namespace gazebo
     /// \brief ROS publisher for the switchable sensor data
     protected: ros::Publisher pluginStatePub;
 
+    /// \brief Last state sent by PublishState(), -1 if none was sent yet
+    protected: int publishedState;
+
     /// \brief Pose of the reference frame wrt world frame
     protected: ignition::math::Pose3d referenceFrame;
 
-    /// \brief ROS subscriber for the TF static reference frame
-    protected: ros::Subscriber tfStaticSub;
+    /// \brief Fixed frames of the world, resolves the static reference frame
+    protected: std::shared_ptr<StaticTransformCache> transformCache;
+
+    /// \brief ID of the wait for the static reference frame, -1 if none
+    protected: int referenceWatchId;
 
     /// \brief Frame ID of the reference frame
     protected: std::string referenceFrameID;
@@ -128,7 +136,8 @@ namespace gazebo
     /// \brief Returns true if the plugin is activated
     protected: bool IsOn();
 
-    /// \brief Publish the current state of the plugin
+    /// \brief Publish the current state of the plugin if it changed since
+    /// the last call, the topic is latched
     protected: void PublishState();
 
     /// \brief Change sensor state (ON/OFF)
@@ -136,9 +145,6 @@ namespace gazebo
         uuv_sensor_ros_plugins_msgs::ChangeSensorState::Request& _req,
         uuv_sensor_ros_plugins_msgs::ChangeSensorState::Response& _res);
 
-    /// \brief Callback function for the static TF message
-    protected: void GetTFMessage(const tf::tfMessage::ConstPtr &_msg);
-
     /// \brief Returns noise value for a function with zero mean from the
     /// default Gaussian noise model
     protected: double GetGaussianNoise(double _amp);
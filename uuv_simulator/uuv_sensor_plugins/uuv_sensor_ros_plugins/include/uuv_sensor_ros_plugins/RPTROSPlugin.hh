@@ -19,6 +19,7 @@
 #include <gazebo/gazebo.hh>
 #include <ros/ros.h>
 #include <uuv_sensor_ros_plugins/ROSBaseModelPlugin.hh>
+#include <uuv_sensor_ros_plugins/AcousticChannel.hh>
 #include <uuv_sensor_ros_plugins_msgs/PositionWithCovarianceStamped.h>
 #include <geometry_msgs/PoseWithCovarianceStamped.h>
 #include "SensorRpt.pb.h"
@@ -39,11 +40,44 @@ namespace gazebo
     /// \brief Update sensor measurement
     protected: virtual bool OnUpdate(const common::UpdateInfo& _info);
 
+    /// \brief Computes the fix when the ping reaches the transponder and
+    /// sends it back to the beacon
+    protected: void Reply(double _replyTime);
+
+    /// \brief Publishes a position fix once it arrived at the beacon
+    protected: void PublishFix(double _stamp,
+      const ignition::math::Vector3d &_position);
+
     /// \brief Latest measured position.
     protected: ignition::math::Vector3d position;
 
     /// \brief Store message since many attributes do not change (cov.).
     protected: uuv_sensor_ros_plugins_msgs::PositionWithCovarianceStamped rosMessage;
+
+    /// \brief Gazebo message, the covariance is set on load
+    protected: sensor_msgs::msgs::Rpt gazeboMessage;
+
+    /// \brief Acoustic channel delivering the fixes
+    protected: std::shared_ptr<AcousticChannel> channel;
+
+    /// \brief ID of this transponder in the channel
+    protected: int channelSender;
+
+    /// \brief Position of the beacon wrt the reference frame
+    protected: ignition::math::Vector3d beaconPosition;
+
+    /// \brief Time the beacon needs to compute a fix [s]
+    protected: double processingDelay;
+
+    /// \brief Probability of a ping not being answered
+    protected: double dropoutProbability;
+
+    /// \brief Probability of the reply arriving over the surface reflected
+    /// path, which gives a fix at a too long range
+    protected: double multipathProbability;
+
+    /// \brief Maximum range of the acoustic link [m], 0 for no limit
+    protected: double maxRange;
   };
 }
 
@@ -0,0 +1,143 @@
+// Copyright (c) 2016 The UUV Simulator Authors.
+// All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __SENSOR_SCHEDULER_HH__
+#define __SENSOR_SCHEDULER_HH__
+
+#include <gazebo/common/common.hh>
+#include <gazebo/physics/physics.hh>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gazebo
+{
+  /// \brief Calls the periodic updates of all sensor plugins of a world
+  /// from a single world update callback. Sensors are kept in a timing
+  /// wheel keyed by the simulation time they are due next, so a physics
+  /// step only costs work for the sensors that are due instead of one
+  /// callback per attached sensor.
+  class SensorScheduler
+  {
+    /// \brief Update function of a sensor
+    public: typedef std::function<void(const common::UpdateInfo&)> Callback;
+
+    /// \brief Returns the scheduler of the world, created on first use.
+    /// The scheduler lives as long as someone holds the pointer.
+    public: static std::shared_ptr<SensorScheduler> Get(
+      physics::WorldPtr _world);
+
+    /// \brief Class constructor for a scheduler that is not connected to a
+    /// world, e.g. in tests. Update() has to be called for every physics
+    /// step of _stepSize seconds after the simulation time _time.
+    public: SensorScheduler(double _stepSize, double _time);
+
+    /// \brief Class destructor
+    public: ~SensorScheduler();
+
+    /// \brief Calls _callback every _period seconds of simulation time,
+    /// the first time one period from now. A period shorter than a
+    /// physics step means every step. Returns an ID for Remove().
+    public: int Add(double _period, const Callback &_callback);
+
+    /// \brief Stops calling the callback added with this ID
+    public: void Remove(int _id);
+
+    /// \brief Number of scheduled callbacks
+    public: size_t Size();
+
+    /// \brief Runs the sensors that are due at the time of _info. Called by
+    /// the world update event if the scheduler was created by Get().
+    public: void Update(const common::UpdateInfo &_info);
+
+    /// \brief Class constructor, use Get()
+    private: explicit SensorScheduler(physics::WorldPtr _world);
+
+    /// \brief Sets the step size and the time of the last update
+    private: void Init(double _stepSize, double _time);
+
+    /// \brief Index of the first physics step at or after a time
+    private: int64_t DueTick(double _time) const;
+
+    /// \brief Index of the physics step of the current time
+    private: int64_t NowTick(double _time) const;
+
+    /// \brief Puts an entry into the slot of its due time, or of the next
+    /// step if that slot was already visited
+    private: void Insert(int _id, double _due);
+
+    /// \brief Puts all entries back into the wheel, after a world reset
+    private: void Rebuild(double _now);
+
+    /// \brief A scheduled callback
+    private: struct Entry
+    {
+      /// \brief Simulation time of the next call
+      double due;
+
+      /// \brief Seconds between calls
+      double period;
+
+      /// \brief Update function
+      Callback callback;
+    };
+
+    /// \brief Pointer to the world
+    private: physics::WorldPtr world;
+
+    /// \brief Width of a wheel slot in seconds, the physics step size
+    private: double tick;
+
+    /// \brief Slots of the timing wheel. Each holds the IDs of the entries
+    /// due in it, in this or a later turn of the wheel. Removed IDs are
+    /// dropped when their slot comes up.
+    private: std::vector<std::vector<int>> wheel;
+
+    /// \brief Scheduled callbacks by ID
+    private: std::unordered_map<int, Entry> entries;
+
+    /// \brief ID of the next added entry
+    private: int nextId;
+
+    /// \brief Simulation time of the last update
+    private: double lastTime;
+
+    /// \brief Step index of the last update, all slots up to it are visited
+    private: int64_t lastTick;
+
+    /// \brief Entries run in the current update, reused between updates
+    private: std::vector<int> dueIds;
+
+    /// \brief Recursive so that callbacks may add or remove entries
+    private: std::recursive_mutex mutex;
+
+    /// \brief Connection to the world update event
+    private: event::ConnectionPtr updateConnection;
+
+    /// \brief Schedulers by world name
+    private: static std::map<std::string, std::weak_ptr<SensorScheduler>>
+      schedulers;
+
+    /// \brief Protects schedulers
+    private: static std::mutex schedulersMutex;
+  };
+}
+
+#endif // __SENSOR_SCHEDULER_HH__
@@ -0,0 +1,156 @@
+// Copyright (c) 2016 The UUV Simulator Authors.
+// All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __STATIC_TRANSFORM_CACHE_HH__
+#define __STATIC_TRANSFORM_CACHE_HH__
+
+#include <gazebo/common/common.hh>
+#include <gazebo/physics/physics.hh>
+#include <ignition/math/Pose3.hh>
+#include <ros/ros.h>
+#include <tf/tfMessage.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+namespace gazebo
+{
+  /// \brief Poses of the fixed frames of a world, shared by the sensor
+  /// plugins running in it. The frames are filled in once from the link
+  /// poses of the models the sensors are attached to, so a sensor can
+  /// resolve its mounting transforms without listening to TF. For each
+  /// link frame X the frame X_ned, rotated by 180 degrees around X's x
+  /// axis, is known as well, as published by the sensor plugins. All other
+  /// frames, e.g. world_ned, are taken from /tf_static through a single
+  /// subscription for all sensors.
+  class StaticTransformCache
+  {
+    /// \brief Function called with the world pose of a frame
+    public: typedef std::function<void(const ignition::math::Pose3d&)>
+      Callback;
+
+    /// \brief Returns the cache of the world, created on first use.
+    /// The cache lives as long as someone holds the pointer.
+    public: static std::shared_ptr<StaticTransformCache> Get(
+      physics::WorldPtr _world);
+
+    /// \brief Class destructor
+    public: ~StaticTransformCache();
+
+    /// \brief Stores the current world poses of all links of a model, by
+    /// their names and scoped names. Models that were added before are
+    /// skipped, their frames are not updated.
+    public: void AddModel(physics::ModelPtr _model);
+
+    /// \brief Stores the world pose of a frame, replacing a previous one
+    public: void Set(const std::string &_frame,
+      const ignition::math::Pose3d &_pose);
+
+    /// \brief Reads the world pose of a frame. Returns false if the frame
+    /// is unknown.
+    public: bool Lookup(const std::string &_frame,
+      ignition::math::Pose3d &_pose);
+
+    /// \brief Reads the pose of frame _source wrt frame _target, as
+    /// tf2_ros::Buffer::lookupTransform() would. Only meaningful for frames
+    /// that are rigidly attached to each other. Returns false if any of the
+    /// frames is unknown.
+    public: bool Relative(const std::string &_target,
+      const std::string &_source, ignition::math::Pose3d &_pose);
+
+    /// \brief Calls _callback with the world pose of _frame as soon as it is
+    /// known, right away if it already is. In the latter case -1 is
+    /// returned, otherwise an ID for Unwatch(). Unknown frames are looked
+    /// for in /tf_static, the callback is then run from the ROS callback
+    /// queue with the cache locked and must not call into the cache. Once
+    /// Unwatch() returns the callback is not running and won't be called.
+    public: int Watch(const std::string &_frame, const Callback &_callback);
+
+    /// \brief Drops the callback added with this ID if it was not called
+    public: void Unwatch(int _id);
+
+    /// \brief Class constructor, use Get()
+    private: StaticTransformCache();
+
+    /// \brief World pose of a frame, the mutex must be held
+    private: bool Find(const std::string &_frame,
+      ignition::math::Pose3d &_pose) const;
+
+    /// \brief Callback of the /tf_static subscription, chains the received
+    /// transforms to frames with known world poses
+    private: void OnTFStatic(const tf::tfMessage::ConstPtr &_msg);
+
+    /// \brief A callback waiting for a frame
+    private: struct Watcher
+    {
+      /// \brief Frame waited for
+      std::string frame;
+
+      /// \brief Function to call
+      Callback callback;
+    };
+
+    /// \brief A transform received on /tf_static whose parent is unknown
+    private: struct PendingTransform
+    {
+      /// \brief Parent frame
+      std::string parent;
+
+      /// \brief Pose of the child frame wrt the parent frame
+      ignition::math::Pose3d pose;
+    };
+
+    /// \brief World poses by frame ID
+    private: std::map<std::string, ignition::math::Pose3d> frames;
+
+    /// \brief Frame IDs stored by AddModel(), only these have a derived
+    /// NED frame and are not overridden by /tf_static
+    private: std::set<std::string> linkFrames;
+
+    /// \brief Scoped names of the models whose links were added
+    private: std::set<std::string> models;
+
+    /// \brief Transforms from /tf_static not chained to the world yet, by
+    /// child frame ID
+    private: std::map<std::string, PendingTransform> pending;
+
+    /// \brief Callbacks waiting for frames, by ID
+    private: std::map<int, Watcher> watchers;
+
+    /// \brief ID of the next watcher
+    private: int nextId;
+
+    /// \brief Protects the frames, models, pending transforms and watchers
+    private: std::mutex mutex;
+
+    /// \brief ROS node handle for the /tf_static subscription
+    private: std::unique_ptr<ros::NodeHandle> rosNode;
+
+    /// \brief Subscriber to /tf_static, created for the first watcher
+    private: ros::Subscriber tfStaticSub;
+
+    /// \brief Caches by world name
+    private: static std::map<std::string,
+      std::weak_ptr<StaticTransformCache>> caches;
+
+    /// \brief Protects caches
+    private: static std::mutex cachesMutex;
+  };
+}
+
+#endif // __STATIC_TRANSFORM_CACHE_HH__
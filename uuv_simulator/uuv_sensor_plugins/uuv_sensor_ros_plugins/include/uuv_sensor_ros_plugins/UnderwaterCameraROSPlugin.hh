@@ -20,9 +20,13 @@
 #include <ros/ros.h>
 #include <gazebo/common/Plugin.hh>
 #include <gazebo/plugins/DepthCameraPlugin.hh>
+#include <gazebo/rendering/Scene.hh>
 #include <gazebo_plugins/gazebo_ros_camera_utils.h>
 #include <uuv_sensor_ros_plugins/Common.hh>
 #include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <mutex>
+#include <vector>
 
 namespace gazebo
 {
@@ -56,8 +60,37 @@ namespace gazebo
      const cv::Mat& _inputImage, const cv::Mat& _inputDepth,
      cv::Mat& _outputImage);
 
-    /// \brief Temporarily store pointer to previous depth image.
-    protected: const float * lastDepth;
+    /// \brief Fills the transmittance LUT from the attenuation constants
+    protected: void UpdateTransmittanceLUT();
+
+    /// \brief Background color at the camera's current depth
+    protected: void UpdateBackground();
+
+    /// \brief Simulation time of the scene being rendered
+    protected: common::Time RenderTime() const;
+
+    /// \brief Depth image and the simulation time it was rendered at
+    protected: struct DepthFrame
+    {
+      /// \brief Depth per pixel
+      std::vector<float> data;
+
+      /// \brief Simulation time of the rendered scene
+      common::Time stamp;
+    };
+
+    /// \brief Double buffer of depth images. The depth callback fills the
+    /// back buffer while the image callback may read the front one.
+    protected: DepthFrame depthFrames[2];
+
+    /// \brief Index of the latest complete depth frame, -1 if none
+    protected: int frontDepth;
+
+    /// \brief Time between the last two depth frames [s]
+    protected: double depthPeriod;
+
+    /// \brief Guards the swap of the depth buffers against readers
+    protected: std::mutex depthMutex;
 
     /// \brief Latest simulated image.
     protected: unsigned char * lastImage;
@@ -70,6 +103,30 @@ namespace gazebo
 
     /// \brief Background constants per channel (RGB)
     protected: unsigned char background[3];
+
+    /// \brief Attenuation of the background (veiling light) with the
+    /// camera's depth below the surface, per channel (RGB) [1/m]
+    protected: float backgroundDepthAttenuation[3];
+
+    /// \brief Background of the current frame, per channel (RGB)
+    protected: int frameBackground[3];
+
+    /// \brief Forward scattering coefficient [1/m], zero to disable
+    protected: float forwardScatter;
+
+    /// \brief Standard deviation of the forward scattering blur [pixels]
+    protected: float forwardScatterSigma;
+
+    /// \brief Blurred input image for forward scattering
+    protected: cv::Mat scatteredImage;
+
+    /// \brief Transmittance per channel (RGB) and forward scattered
+    /// fraction in fixed point, for ranges quantized in steps of
+    /// 1/rangeLUTScale
+    protected: std::vector<uint16_t> transmittanceLUT;
+
+    /// \brief Number of LUT entries per meter of range
+    protected: float rangeLUTScale;
   };
 }
 
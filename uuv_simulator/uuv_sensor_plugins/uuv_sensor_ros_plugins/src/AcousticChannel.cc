@@ -0,0 +1,181 @@
+// Copyright (c) 2016 The UUV Simulator Authors.
+// All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <uuv_sensor_ros_plugins/AcousticChannel.hh>
+
+namespace gazebo
+{
+/// \brief Default speed of sound in sea water [m/s]
+static const double kDefaultSoundSpeed = 1500.0;
+
+/// \brief Tolerance on arrival times, so a message due at the time of a
+/// physics step is not delayed to the next one by rounding
+static const double kArrivalSlack = 1e-9;
+
+std::map<std::string, std::weak_ptr<AcousticChannel>>
+  AcousticChannel::channels;
+
+std::mutex AcousticChannel::channelsMutex;
+
+/////////////////////////////////////////////////
+std::shared_ptr<AcousticChannel> AcousticChannel::Get(
+  physics::WorldPtr _world)
+{
+  GZ_ASSERT(_world != NULL, "World object not available");
+#if GAZEBO_MAJOR_VERSION >= 8
+  std::string worldName = _world->Name();
+#else
+  std::string worldName = _world->GetName();
+#endif
+
+  std::lock_guard<std::mutex> lock(channelsMutex);
+  std::shared_ptr<AcousticChannel> channel = channels[worldName].lock();
+  if (!channel)
+  {
+    channel.reset(new AcousticChannel(SensorScheduler::Get(_world)));
+    channels[worldName] = channel;
+  }
+  return channel;
+}
+
+/////////////////////////////////////////////////
+AcousticChannel::AcousticChannel(std::shared_ptr<SensorScheduler> _scheduler)
+  : nextSender(0), sequence(0), soundSpeed(kDefaultSoundSpeed),
+    surfaceHeight(0.0), lastTime(0.0), scheduler(_scheduler)
+{
+  // Messages can arrive at any step, the queue is checked on every one
+  this->schedulerId = this->scheduler->Add(0.0,
+    std::bind(&AcousticChannel::OnUpdate, this, std::placeholders::_1));
+}
+
+/////////////////////////////////////////////////
+AcousticChannel::~AcousticChannel()
+{
+  this->scheduler->Remove(this->schedulerId);
+}
+
+/////////////////////////////////////////////////
+double AcousticChannel::SoundSpeed()
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  return this->soundSpeed;
+}
+
+/////////////////////////////////////////////////
+void AcousticChannel::SetSoundSpeed(double _speed)
+{
+  GZ_ASSERT(_speed > 0.0, "Speed of sound must be greater than zero");
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  this->soundSpeed = _speed;
+}
+
+/////////////////////////////////////////////////
+double AcousticChannel::SurfaceHeight()
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  return this->surfaceHeight;
+}
+
+/////////////////////////////////////////////////
+void AcousticChannel::SetSurfaceHeight(double _height)
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  this->surfaceHeight = _height;
+}
+
+/////////////////////////////////////////////////
+double AcousticChannel::DirectPath(const ignition::math::Vector3d &_from,
+  const ignition::math::Vector3d &_to)
+{
+  return (_to - _from).Length();
+}
+
+/////////////////////////////////////////////////
+double AcousticChannel::SurfacePath(const ignition::math::Vector3d &_from,
+  const ignition::math::Vector3d &_to)
+{
+  // The reflected path is as long as the direct path to the mirror image of
+  // the source above the surface
+  ignition::math::Vector3d mirrored = _from;
+  mirrored.Z() = 2.0 * this->SurfaceHeight() - _from.Z();
+  return (_to - mirrored).Length();
+}
+
+/////////////////////////////////////////////////
+double AcousticChannel::TravelTime(double _length)
+{
+  return _length / this->SoundSpeed();
+}
+
+/////////////////////////////////////////////////
+int AcousticChannel::AddSender()
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  int id = this->nextSender++;
+  this->senders.insert(id);
+  return id;
+}
+
+/////////////////////////////////////////////////
+void AcousticChannel::RemoveSender(int _sender)
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  // The sender's messages are dropped when they come up in the queue
+  this->senders.erase(_sender);
+}
+
+/////////////////////////////////////////////////
+void AcousticChannel::Send(int _sender, double _arrival,
+  const Callback &_callback)
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  GZ_ASSERT(this->senders.count(_sender), "Unknown sender");
+  Message message;
+  message.arrival = _arrival;
+  message.sequence = this->sequence++;
+  message.sender = _sender;
+  message.callback = _callback;
+  this->messages.push(message);
+}
+
+/////////////////////////////////////////////////
+size_t AcousticChannel::Pending()
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  return this->messages.size();
+}
+
+/////////////////////////////////////////////////
+void AcousticChannel::OnUpdate(const common::UpdateInfo &_info)
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  double now = _info.simTime.Double();
+
+  // After a world reset the messages in flight belong to the old timeline
+  if (now < this->lastTime)
+    this->messages = std::priority_queue<Message>();
+  this->lastTime = now;
+
+  while (!this->messages.empty() &&
+    this->messages.top().arrival <= now + kArrivalSlack)
+  {
+    Message message = this->messages.top();
+    this->messages.pop();
+    if (this->senders.count(message.sender))
+      message.callback();
+  }
+}
+}
@@ -19,7 +19,9 @@ namespace gazebo
 {
 /////////////////////////////////////////////////
 CPCROSPlugin::CPCROSPlugin() : ROSBaseModelPlugin()
-{ }
+{
+  this->updatingCloud = false;
+}
 
 /////////////////////////////////////////////////
 CPCROSPlugin::~CPCROSPlugin()
@@ -84,6 +86,10 @@ void CPCROSPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
   GZ_ASSERT(this->plumeSalinityValue < this->waterSalinityValue,
     "Plume salinity value must be lower than the water salinity value");
 
+  this->plumeIndex = PlumeParticleIndex::Get(
+    this->rosNode->resolveName(inputTopic), this->smoothingLength,
+    this->gamma);
+
   this->particlesSub = this->rosNode->subscribe<sensor_msgs::PointCloud>(
     inputTopic, 1,
     boost::bind(&CPCROSPlugin::OnPlumeParticlesUpdate,
@@ -116,9 +122,6 @@ void CPCROSPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
 /////////////////////////////////////////////////
 bool CPCROSPlugin::OnUpdate(const common::UpdateInfo& _info)
 {
-  // Publish sensor state
-  this->PublishState();
-
   if (!this->EnableMeasurement(_info) || this->updatingCloud)
     return false;
 
@@ -164,11 +167,6 @@ void CPCROSPlugin::OnPlumeParticlesUpdate(
   {
     this->updatingCloud = true;
 
-    double totalParticleConc = 0.0;
-    double smoothingParam;
-    double particleConc;
-    double distToParticle;
-
     ignition::math::Vector3d linkPos, linkPosRef;
 #if GAZEBO_MAJOR_VERSION >= 8
     linkPos = this->link->WorldPose().Pos();
@@ -205,32 +203,8 @@ void CPCROSPlugin::OnPlumeParticlesUpdate(
     // Store this measurement's time stamp
     this->lastUpdateTimestamp = _msg->header.stamp;
 
-    double currentTime = _msg->header.stamp.toSec();
-
-    double initSmoothingLength = std::pow(this->smoothingLength, 2.0 / 3);
-    ignition::math::Vector3d particle;
-    for (int i = 0; i < _msg->points.size(); i++)
-    {
-      particle = ignition::math::Vector3d(_msg->points[i].x, _msg->points[i].y,
-        _msg->points[i].z);
-
-      smoothingParam = std::pow(initSmoothingLength +
-        this->gamma * (currentTime - _msg->channels[0].values[i]), 1.5);
-      distToParticle = linkPos.Distance(particle);
-
-      // Compute particle concentration
-      if (distToParticle >= 0 && distToParticle < smoothingParam)
-        particleConc = 4.0 -
-          6.0 * std::pow(distToParticle / smoothingParam, 2) +
-          3.0 * std::pow(distToParticle / smoothingParam, 3);
-      else if (distToParticle >= smoothingParam && distToParticle < 2 * smoothingParam)
-        particleConc = std::pow(2 - distToParticle / smoothingParam, 3);
-      else
-        particleConc = 0.0;
-
-      particleConc *= 1 / (4 * M_PI * std::pow(smoothingParam, 3));
-      totalParticleConc += particleConc;
-    }
+    // Only the particles whose kernel reaches the sensor contribute
+    double totalParticleConc = this->plumeIndex->Concentration(_msg, linkPos);
 
     this->outputMsg.concentration = this->gain * totalParticleConc;
     this->updatingCloud = false;
@@ -14,13 +14,74 @@
 // limitations under the License.
 
 #include <uuv_sensor_ros_plugins/DVLROSPlugin.hh>
+#include <gazebo/physics/PhysicsEngine.hh>
 
 namespace gazebo
 {
+/////////////////////////////////////////////////
+bool DVLROSPlugin::InvertMatrix3(const double _m[3][3], double _inv[3][3])
+{
+  double c00 = _m[1][1] * _m[2][2] - _m[1][2] * _m[2][1];
+  double c01 = _m[1][2] * _m[2][0] - _m[1][0] * _m[2][2];
+  double c02 = _m[1][0] * _m[2][1] - _m[1][1] * _m[2][0];
+  double det = _m[0][0] * c00 + _m[0][1] * c01 + _m[0][2] * c02;
+  if (std::fabs(det) < 1e-6)
+    return false;
+
+  _inv[0][0] = c00 / det;
+  _inv[1][0] = c01 / det;
+  _inv[2][0] = c02 / det;
+  _inv[0][1] = (_m[0][2] * _m[2][1] - _m[0][1] * _m[2][2]) / det;
+  _inv[1][1] = (_m[0][0] * _m[2][2] - _m[0][2] * _m[2][0]) / det;
+  _inv[2][1] = (_m[0][1] * _m[2][0] - _m[0][0] * _m[2][1]) / det;
+  _inv[0][2] = (_m[0][1] * _m[1][2] - _m[0][2] * _m[1][1]) / det;
+  _inv[1][2] = (_m[0][2] * _m[1][0] - _m[0][0] * _m[1][2]) / det;
+  _inv[2][2] = (_m[0][0] * _m[1][1] - _m[0][1] * _m[1][0]) / det;
+  return true;
+}
+
+/////////////////////////////////////////////////
+bool DVLROSPlugin::SolveBeamVelocity(
+  const std::vector<ignition::math::Vector3d> &_dirs,
+  const std::vector<double> &_beamVel, double _sigma,
+  ignition::math::Vector3d &_vel, double _cov[3][3])
+{
+  if (_dirs.size() < 3 || _dirs.size() != _beamVel.size())
+    return false;
+
+  // Normal equations D^T D v = D^T m
+  double normal[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+  double rhs[3] = {0, 0, 0};
+  for (size_t i = 0; i < _dirs.size(); i++)
+  {
+    double d[3] = {_dirs[i].X(), _dirs[i].Y(), _dirs[i].Z()};
+    for (int r = 0; r < 3; r++)
+    {
+      rhs[r] += d[r] * _beamVel[i];
+      for (int c = 0; c < 3; c++)
+        normal[r][c] += d[r] * d[c];
+    }
+  }
+
+  double inv[3][3];
+  if (!InvertMatrix3(normal, inv))
+    return false;
+
+  _vel.Set(
+    inv[0][0] * rhs[0] + inv[0][1] * rhs[1] + inv[0][2] * rhs[2],
+    inv[1][0] * rhs[0] + inv[1][1] * rhs[1] + inv[1][2] * rhs[2],
+    inv[2][0] * rhs[0] + inv[2][1] * rhs[1] + inv[2][2] * rhs[2]);
+  for (int r = 0; r < 3; r++)
+    for (int c = 0; c < 3; c++)
+      _cov[r][c] = _sigma * _sigma * inv[r][c];
+  return true;
+}
+
 /////////////////////////////////////////////////
 DVLROSPlugin::DVLROSPlugin() : ROSBaseModelPlugin()
 {
-  this->beamTransformsInitialized = false;
+  this->altitude = ALTITUDE_OUT_OF_RANGE;
+  this->bottomLock = false;
 }
 
 /////////////////////////////////////////////////
@@ -34,63 +95,90 @@ void DVLROSPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
 
   // Load the link names for all the beams
   std::string beamLinkName;
-  GetSDFParam<std::string>(_sdf, "beam_link_name_0", beamLinkName, "");
-  GZ_ASSERT(!beamLinkName.empty(), "Beam 0 link name empty");
-  this->beamsLinkNames.push_back(beamLinkName);
+  while (GetSDFParam<std::string>(_sdf, "beam_link_name_" +
+    std::to_string(this->beamsLinkNames.size()), beamLinkName, ""))
+  {
+    GZ_ASSERT(!beamLinkName.empty(), "Beam link name empty");
+    this->beamsLinkNames.push_back(beamLinkName);
+  }
+  GZ_ASSERT(this->beamsLinkNames.size() >= 3,
+    "DVL needs at least three beams");
+
+  // Load the optional beam output topic names
+  std::string beamTopic;
+  for (size_t i = 0; i < this->beamsLinkNames.size(); i++)
+  {
+    GetSDFParam<std::string>(_sdf, "beam_topic_" + std::to_string(i),
+      beamTopic, "");
+    this->beamTopics.push_back(beamTopic);
+    if (!beamTopic.empty())
+      this->beamRangePubs.push_back(
+        this->rosNode->advertise<sensor_msgs::Range>(beamTopic, 1));
+    else
+      this->beamRangePubs.push_back(ros::Publisher());
+  }
 
-  GetSDFParam<std::string>(_sdf, "beam_link_name_1", beamLinkName, "");
-  GZ_ASSERT(!beamLinkName.empty(), "Beam 1 link name empty");
-  this->beamsLinkNames.push_back(beamLinkName);
+  GetSDFParam<double>(_sdf, "beam_min_range", this->beamMinRange, 0.55);
+  GetSDFParam<double>(_sdf, "beam_max_range", this->beamMaxRange, 81.0);
+  GZ_ASSERT(this->beamMinRange >= 0.0 &&
+    this->beamMaxRange > this->beamMinRange, "Invalid beam range limits");
+
+  // Noise on the range of each beam, as the ray sensors used for the beams
+  // before had
+  GetSDFParam<double>(_sdf, "beam_range_noise_sigma",
+    this->beamRangeNoiseSigma, 0.005);
+  GZ_ASSERT(this->beamRangeNoiseSigma >= 0.0,
+    "Beam range noise sigma must be non-negative");
+  this->beamRangeNoise = this->noise.AddWhite(this->beamRangeNoiseSigma);
+
+  // The beams are rigidly attached to the DVL, their poses are resolved
+  // once from the model instead of looking up their transforms
+  std::shared_ptr<StaticTransformCache> transforms =
+    StaticTransformCache::Get(this->world);
+#if GAZEBO_MAJOR_VERSION >= 8
+  physics::PhysicsEnginePtr physicsEngine = this->world->Physics();
+#else
+  physics::PhysicsEnginePtr physicsEngine = this->world->GetPhysicsEngine();
+#endif
 
-  GetSDFParam<std::string>(_sdf, "beam_link_name_2", beamLinkName, "");
-  GZ_ASSERT(!beamLinkName.empty(), "Beam 2 link name empty");
-  this->beamsLinkNames.push_back(beamLinkName);
+  for (size_t i = 0; i < this->beamsLinkNames.size(); i++)
+  {
+    physics::LinkPtr beamLink = this->model->GetLink(this->beamsLinkNames[i]);
+    GZ_ASSERT(beamLink != NULL, "Beam link does not exist");
 
-  GetSDFParam<std::string>(_sdf, "beam_link_name_3", beamLinkName, "");
-  GZ_ASSERT(!beamLinkName.empty(), "Beam 3 link name empty");
-  this->beamsLinkNames.push_back(beamLinkName);
+    ignition::math::Pose3d pose;
+    bool found = transforms->Relative(this->link->GetScopedName(),
+      beamLink->GetScopedName(), pose);
+    GZ_ASSERT(found, "Beam link pose is not available");
+    this->beamPoses.push_back(pose);
+    // Beams point along the X axis of their links
+    this->beamDirections.push_back(
+      pose.Rot().RotateVector(ignition::math::Vector3d::UnitX));
+    this->beamRanges.push_back(ALTITUDE_OUT_OF_RANGE);
+
+    physics::RayShapePtr ray = boost::dynamic_pointer_cast<physics::RayShape>(
+      physicsEngine->CreateShape("ray", physics::CollisionPtr()));
+    GZ_ASSERT(ray != NULL, "Failed to create the beam ray");
+    this->beamRays.push_back(ray);
+
+    // Beam poses are reported in the output frame of the DVL
+    if (this->enableLocalNEDFrame)
+    {
+      pose.Pos() = this->localNEDFrame.Rot().RotateVector(pose.Pos());
+      pose.Rot() = this->localNEDFrame.Rot() * pose.Rot();
+    }
 
-  // Load the beam output topic names
-  std::string beamTopic;
-  GetSDFParam<std::string>(_sdf, "beam_topic_0", beamTopic, "");
-  GZ_ASSERT(!beamTopic.empty(), "Beam 0 topic name empty");
-  this->beamTopics.push_back(beamTopic);
-
-  GetSDFParam<std::string>(_sdf, "beam_topic_1", beamTopic, "");
-  GZ_ASSERT(!beamTopic.empty(), "Beam 1 topic name empty");
-  this->beamTopics.push_back(beamTopic);
-
-  GetSDFParam<std::string>(_sdf, "beam_topic_2", beamTopic, "");
-  GZ_ASSERT(!beamTopic.empty(), "Beam 2 topic name empty");
-  this->beamTopics.push_back(beamTopic);
-
-  GetSDFParam<std::string>(_sdf, "beam_topic_3", beamTopic, "");
-  GZ_ASSERT(!beamTopic.empty(), "Beam 3 topic name empty");
-  this->beamTopics.push_back(beamTopic);
-
-  // Create beam subscribers
-  this->beamSub0.reset(new message_filters::Subscriber<sensor_msgs::Range>(
-    *this->rosNode.get(), this->beamTopics[0], 1));
-  this->beamSub1.reset(new message_filters::Subscriber<sensor_msgs::Range>(
-    *this->rosNode.get(), this->beamTopics[1], 1));
-  this->beamSub2.reset(new message_filters::Subscriber<sensor_msgs::Range>(
-    *this->rosNode.get(), this->beamTopics[2], 1));
-  this->beamSub3.reset(new message_filters::Subscriber<sensor_msgs::Range>(
-    *this->rosNode.get(), this->beamTopics[3], 1));
-
-  for (int i = 0; i < 4; i++)
-    this->dvlBeamMsgs.push_back(uuv_sensor_ros_plugins_msgs::DVLBeam());
-
-  // Synchronize the beam topics
-  this->syncBeamMessages.reset(new message_filters::TimeSynchronizer<
-    sensor_msgs::Range, sensor_msgs::Range,
-    sensor_msgs::Range, sensor_msgs::Range>(
-      *this->beamSub0.get(), *this->beamSub1.get(), *this->beamSub2.get(),
-      *this->beamSub3.get(), 10));
-
-  // Set synchronized callback function for the DVL beams
-  this->syncBeamMessages->registerCallback(
-    boost::bind(&DVLROSPlugin::OnBeamCallback, this, _1, _2, _3, _4));
+    uuv_sensor_ros_plugins_msgs::DVLBeam beamMsg;
+    beamMsg.pose.header.frame_id = this->beamsLinkNames[i];
+    beamMsg.pose.pose.position.x = pose.Pos().X();
+    beamMsg.pose.pose.position.y = pose.Pos().Y();
+    beamMsg.pose.pose.position.z = pose.Pos().Z();
+    beamMsg.pose.pose.orientation.x = pose.Rot().X();
+    beamMsg.pose.pose.orientation.y = pose.Rot().Y();
+    beamMsg.pose.pose.orientation.z = pose.Rot().Z();
+    beamMsg.pose.pose.orientation.w = pose.Rot().W();
+    this->dvlBeamMsgs.push_back(beamMsg);
+  }
 
   // Initialize the default DVL output
   this->rosSensorOutputPub =
@@ -115,22 +203,14 @@ void DVLROSPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
     this->twistROSMsg.header.frame_id = this->link->GetName();
   }
 
-  double variance = this->noiseSigma * this->noiseSigma;
-
-  // Set covariance
+  // The covariance depends on the beams with a bottom return and is set
+  // on every update
   for (int i = 0; i < 9; i++)
       this->dvlROSMsg.velocity_covariance[i] = 0.0;
 
-  this->dvlROSMsg.velocity_covariance[0] = variance;
-  this->dvlROSMsg.velocity_covariance[4] = variance;
-  this->dvlROSMsg.velocity_covariance[8] = variance;
-
   for (int i = 0; i < 36; i++)
     this->twistROSMsg.twist.covariance[i] = 0.0;
 
-  this->twistROSMsg.twist.covariance[0] = variance;
-  this->twistROSMsg.twist.covariance[7] = variance;
-  this->twistROSMsg.twist.covariance[14] = variance;
   this->twistROSMsg.twist.covariance[21] = -1;  // not available
   this->twistROSMsg.twist.covariance[28] = -1;  // not available
   this->twistROSMsg.twist.covariance[35] = -1;  // not available
@@ -146,48 +226,99 @@ void DVLROSPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
 /////////////////////////////////////////////////
 bool DVLROSPlugin::OnUpdate(const common::UpdateInfo& _info)
 {
-  // Publish sensor state
-  this->PublishState();
-
   if (!this->EnableMeasurement(_info))
     return false;
 
   if (this->enableLocalNEDFrame)
     this->SendLocalNEDTransform();
 
-  ignition::math::Vector3d bodyVel;
-
-  if (!this->UpdateBeamTransforms())
-    return false;
-
-  // Read true body velocity
-  // TODO Temporary solution to generate DVL message, use beams in the future
-  // instead
+  ignition::math::Pose3d pose;
+  ignition::math::Vector3d linVel, angVel;
 #if GAZEBO_MAJOR_VERSION >= 8
-  bodyVel = this->link->RelativeLinearVel();
+  pose = this->link->WorldPose();
+  linVel = this->link->RelativeLinearVel();
+  angVel = this->link->RelativeAngularVel();
 #else
-  bodyVel = this->link->GetRelativeLinearVel().Ign();
+  pose = this->link->GetWorldPose().Ign();
+  linVel = this->link->GetRelativeLinearVel().Ign();
+  angVel = this->link->GetRelativeAngularVel().Ign();
 #endif
 
-  bodyVel.X() += this->GetGaussianNoise(this->noiseAmp);
-  bodyVel.Y() += this->GetGaussianNoise(this->noiseAmp);
-  bodyVel.Z() += this->GetGaussianNoise(this->noiseAmp);
+  int numReturns = this->CastBeams(pose);
+
+  // Each beam measures the velocity of its origin relative to the (static)
+  // bottom, projected on the beam axis, with its own noise. The velocity of
+  // the DVL is the least squares solution over all beams with a bottom
+  // return.
+  double variance = this->noiseSigma * this->noiseSigma;
+  ignition::math::Vector3d down =
+    pose.Rot().RotateVectorReverse(-ignition::math::Vector3d::UnitZ);
+  double altitudeSum = 0.0;
+  this->returnDirections.clear();
+  this->returnVelocities.clear();
+
+  for (size_t i = 0; i < this->beamRanges.size(); i++)
+  {
+    uuv_sensor_ros_plugins_msgs::DVLBeam &beamMsg = this->dvlBeamMsgs[i];
+    beamMsg.range = this->beamRanges[i];
+    if (this->beamRanges[i] < 0.0)
+    {
+      beamMsg.range_covariance = -1;
+      beamMsg.velocity = 0.0;
+      beamMsg.velocity_covariance = -1;
+      continue;
+    }
+
+    const ignition::math::Vector3d &dir = this->beamDirections[i];
+    double beamVel = dir.Dot(linVel + angVel.Cross(this->beamPoses[i].Pos())) +
+      this->GetGaussianNoise(this->noiseAmp);
+    beamMsg.range_covariance =
+      this->beamRangeNoiseSigma * this->beamRangeNoiseSigma;
+    beamMsg.velocity = beamVel;
+    beamMsg.velocity_covariance = variance;
+    this->returnDirections.push_back(dir);
+    this->returnVelocities.push_back(beamVel);
+
+    // Vertical distance to the bottom along this beam
+    altitudeSum += this->beamRanges[i] * dir.Dot(down);
+  }
+
+  ignition::math::Vector3d bodyVel;
+  double cov[3][3];
+  this->bottomLock = SolveBeamVelocity(this->returnDirections,
+    this->returnVelocities, this->noiseSigma, bodyVel, cov);
+  if (this->bottomLock)
+  {
+    this->altitude = altitudeSum / numReturns;
+  }
+  else
+  {
+    // Bottom lock lost, flag the velocity as invalid
+    for (int r = 0; r < 3; r++)
+      for (int c = 0; c < 3; c++)
+        cov[r][c] = (r == c ? -1.0 : 0.0);
+    this->altitude = ALTITUDE_OUT_OF_RANGE;
+  }
 
   if (this->enableLocalNEDFrame)
+  {
+    // The NED frame is a rotation of pi around X, flipping the Y and Z axes
     bodyVel = this->localNEDFrame.Rot().RotateVector(bodyVel);
+    if (this->bottomLock)
+    {
+      const double sign[3] = {1.0, -1.0, -1.0};
+      for (int r = 0; r < 3; r++)
+        for (int c = 0; c < 3; c++)
+          cov[r][c] *= sign[r] * sign[c];
+    }
+  }
 
   if (this->gazeboMsgEnabled)
   {
     sensor_msgs::msgs::Dvl dvlGazeboMsg;
-    double variance = this->noiseSigma * this->noiseSigma;
 
     for (int i = 0; i < 9; i++)
-    {
-      if (i == 0 || i == 4 || i == 8)
-        dvlGazeboMsg.add_linear_velocity_covariance(variance);
-      else
-        dvlGazeboMsg.add_linear_velocity_covariance(0.0);
-    }
+      dvlGazeboMsg.add_linear_velocity_covariance(cov[i / 3][i % 3]);
 
     // Publish simulated measurement
     gazebo::msgs::Vector3d* v = new gazebo::msgs::Vector3d();
@@ -204,8 +335,13 @@ bool DVLROSPlugin::OnUpdate(const common::UpdateInfo& _info)
 
   this->dvlROSMsg.altitude = this->altitude;
 
+  for (size_t i = 0; i < this->dvlBeamMsgs.size(); i++)
+    this->dvlBeamMsgs[i].pose.header.stamp = this->dvlROSMsg.header.stamp;
   this->dvlROSMsg.beams = this->dvlBeamMsgs;
 
+  for (int i = 0; i < 9; i++)
+    this->dvlROSMsg.velocity_covariance[i] = cov[i / 3][i % 3];
+
   this->dvlROSMsg.velocity.x = bodyVel.X();
   this->dvlROSMsg.velocity.y = bodyVel.Y();
   this->dvlROSMsg.velocity.z = bodyVel.Z();
@@ -213,12 +349,18 @@ bool DVLROSPlugin::OnUpdate(const common::UpdateInfo& _info)
 
   this->twistROSMsg.header.stamp = this->dvlROSMsg.header.stamp;
 
+  for (int r = 0; r < 3; r++)
+    for (int c = 0; c < 3; c++)
+      this->twistROSMsg.twist.covariance[r * 6 + c] = cov[r][c];
+
   this->twistROSMsg.twist.twist.linear.x = bodyVel.X();
   this->twistROSMsg.twist.twist.linear.y = bodyVel.Y();
   this->twistROSMsg.twist.twist.linear.z = bodyVel.Z();
 
   this->twistPub.publish(this->twistROSMsg);
 
+  this->PublishBeamRanges(_info.simTime);
+
   // Read the current simulation time
   #if GAZEBO_MAJOR_VERSION >= 8
     this->lastMeasurementTime = this->world->SimTime();
@@ -229,97 +371,81 @@ bool DVLROSPlugin::OnUpdate(const common::UpdateInfo& _info)
 }
 
 /////////////////////////////////////////////////
-void DVLROSPlugin::OnBeamCallback(const sensor_msgs::RangeConstPtr& _range0,
-  const sensor_msgs::RangeConstPtr& _range1,
-  const sensor_msgs::RangeConstPtr& _range2,
-  const sensor_msgs::RangeConstPtr& _range3)
+int DVLROSPlugin::CastBeams(const ignition::math::Pose3d &_pose)
 {
-  if (_range0->range == _range0->min_range &&
-      _range1->range == _range1->min_range &&
-      _range2->range == _range2->min_range &&
-      _range3->range == _range3->min_range)
-  {
-    this->altitude = ALTITUDE_OUT_OF_RANGE;
-    return;
-  }
+#if GAZEBO_MAJOR_VERSION >= 8
+  physics::PhysicsEnginePtr physicsEngine = this->world->Physics();
+#else
+  physics::PhysicsEnginePtr physicsEngine = this->world->GetPhysicsEngine();
+#endif
+  std::string ownPrefix = this->model->GetScopedName() + "::";
+  double dist;
+  std::string entity;
+  int numReturns = 0;
 
+  // All beams are cast in one pass while holding the physics lock, the
+  // per-ray lock taken by the engine is then uncontended
+  boost::recursive_mutex::scoped_lock lock(
+    *physicsEngine->GetPhysicsUpdateMutex());
 
-  if (_range0->range == _range0->max_range &&
-      _range1->range == _range1->max_range &&
-      _range2->range == _range2->max_range &&
-      _range3->range == _range3->max_range)
+  for (size_t i = 0; i < this->beamRays.size(); i++)
   {
-    this->altitude = ALTITUDE_OUT_OF_RANGE;
-    return;
-  }
-
-  // TODO Compute the altitude taking into account the vehicle's orientation
-  this->altitude =
-    0.25 * (_range0->range + _range1->range + _range2->range + _range3->range);
+    ignition::math::Vector3d origin = _pose.CoordPositionAdd(
+      this->beamPoses[i].Pos());
+    ignition::math::Vector3d dir = _pose.Rot().RotateVector(
+      this->beamDirections[i]);
 
-  this->dvlBeamMsgs[0].range = _range0->range;
-  this->dvlBeamMsgs[1].range = _range1->range;
-  this->dvlBeamMsgs[2].range = _range2->range;
-  this->dvlBeamMsgs[3].range = _range3->range;
-}
-
-/////////////////////////////////////////////////
-bool DVLROSPlugin::UpdateBeamTransforms()
-{
-  if (this->beamPoses.size() == 4)
-    return true;
-
-  tf::StampedTransform beamTransform;
-  std::string targetFrame, sourceFrame;
-  bool success = true;
+    // Start at the minimum range, which also keeps the rays clear of the
+    // vehicle's own collision geometries
+#if GAZEBO_MAJOR_VERSION >= 8
+    this->beamRays[i]->SetPoints(origin + this->beamMinRange * dir,
+      origin + this->beamMaxRange * dir);
+#else
+    this->beamRays[i]->SetPoints(
+      math::Vector3(origin + this->beamMinRange * dir),
+      math::Vector3(origin + this->beamMaxRange * dir));
+#endif
+    this->beamRays[i]->GetIntersection(dist, entity);
 
-  for (int i = 0; i < this->beamsLinkNames.size(); i++)
-  {
-    sourceFrame = this->beamsLinkNames[i];
-    if (!this->enableLocalNEDFrame)
-      targetFrame = this->link->GetName();
-    else
-      targetFrame = tfLocalNEDFrame.child_frame_id_;
-    try
+    double range = this->beamMinRange + dist;
+    if (entity.empty() || range > this->beamMaxRange ||
+        entity.compare(0, ownPrefix.size(), ownPrefix) == 0)
     {
-      ros::Time now = ros::Time::now();
-      this->transformListener.lookupTransform(
-        targetFrame, sourceFrame, ros::Time(0),
-        beamTransform);
+      this->beamRanges[i] = ALTITUDE_OUT_OF_RANGE;
     }
-    catch(tf::TransformException &ex)
+    else
     {
-      success = false;
-      break;
+      // Range noise of the beam, added before the ranges are used for the
+      // altitude and the velocity solution
+      this->beamRanges[i] = range +
+        this->noise.Sample(this->beamRangeNoise, 1.0);
+      numReturns++;
     }
+  }
+  return numReturns;
+}
 
-    ignition::math::Pose3d pose;
-    pose.Pos() = ignition::math::Vector3d(
-      beamTransform.getOrigin().x(),
-      beamTransform.getOrigin().y(),
-      beamTransform.getOrigin().z());
-    pose.Rot() = ignition::math::Quaterniond(
-      beamTransform.getRotation().getW(),
-      beamTransform.getRotation().getAxis().x(),
-      beamTransform.getRotation().getAxis().y(),
-      beamTransform.getRotation().getAxis().z());
-
-    this->dvlBeamMsgs[i].pose = geometry_msgs::PoseStamped();
-    this->dvlBeamMsgs[i].pose.header.stamp = ros::Time::now();
-    this->dvlBeamMsgs[i].pose.header.frame_id = sourceFrame;
-
-    this->dvlBeamMsgs[i].pose.pose.position.x = beamTransform.getOrigin().x();
-    this->dvlBeamMsgs[i].pose.pose.position.y = beamTransform.getOrigin().y();
-    this->dvlBeamMsgs[i].pose.pose.position.z = beamTransform.getOrigin().z();
-
-    this->dvlBeamMsgs[i].pose.pose.orientation.x = beamTransform.getRotation().getAxis().x();
-    this->dvlBeamMsgs[i].pose.pose.orientation.y = beamTransform.getRotation().getAxis().y();
-    this->dvlBeamMsgs[i].pose.pose.orientation.z = beamTransform.getRotation().getAxis().z();
-    this->dvlBeamMsgs[i].pose.pose.orientation.w = beamTransform.getRotation().getW();
-
-    this->beamPoses.push_back(pose);
+/////////////////////////////////////////////////
+void DVLROSPlugin::PublishBeamRanges(const common::Time &_time)
+{
+  sensor_msgs::Range rangeMsg;
+  rangeMsg.header.stamp.sec = _time.sec;
+  rangeMsg.header.stamp.nsec = _time.nsec;
+  rangeMsg.radiation_type = sensor_msgs::Range::ULTRASOUND;
+  rangeMsg.field_of_view = 0.06;
+  rangeMsg.min_range = this->beamMinRange;
+  rangeMsg.max_range = this->beamMaxRange;
+
+  for (size_t i = 0; i < this->beamRangePubs.size(); i++)
+  {
+    if (this->beamTopics[i].empty())
+      continue;
+    rangeMsg.header.frame_id = this->beamsLinkNames[i];
+    // Beams without a return report the maximum range
+    rangeMsg.range = this->beamRanges[i] < 0.0 ?
+      this->beamMaxRange : this->beamRanges[i];
+    this->beamRangePubs[i].publish(rangeMsg);
   }
-  return success;
 }
 
 /////////////////////////////////////////////////
@@ -33,7 +33,10 @@ namespace gazebo
 {
 /////////////////////////////////////////////////
 IMUROSPlugin::IMUROSPlugin() : ROSBaseModelPlugin()
-{ }
+{
+  this->referenceRotInverse = ignition::math::Quaterniond::Identity;
+  this->isReferenceRotInit = false;
+}
 
 /////////////////////////////////////////////////
 IMUROSPlugin::~IMUROSPlugin()
@@ -78,13 +81,39 @@ void IMUROSPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
                       this->imuParameters.orientationNoise);
 
   this->imuROSMessage.header.frame_id = this->link->GetName();
+
+  // Store the acc. gravity vector
+#if GAZEBO_MAJOR_VERSION >= 8
+  this->gravityWorld = this->world->Gravity();
+#else
+  this->gravityWorld = this->world->GetPhysicsEngine()->GetGravity().Ign();
+#endif
+
+  this->InitNoiseModels();
+
+  this->rosSensorOutputPub =
+    this->rosNode->advertise<sensor_msgs::Imu>(this->sensorOutputTopic, 1);
+
+  if (this->gazeboMsgEnabled)
+  {
+    this->gazeboSensorOutputPub =
+      this->gazeboNode->Advertise<sensor_msgs::msgs::Imu>(
+        this->robotNamespace + "/" + this->sensorOutputTopic, 1);
+    this->InitGazeboMessage();
+  }
+}
+
+/////////////////////////////////////////////////
+void IMUROSPlugin::InitNoiseModels()
+{
   // Fill IMU message.
   // We assume uncorrelated noise on the 3 channels -> only set diagonal
   // elements. Only the broadband noise component is considered, specified as
   // a continuous-time density (two-sided spectrum); not the true covariance
   // of the measurements.
   // Angular velocity measurement covariance.
-  this->AddNoiseModel("gyro_noise_density", this->imuParameters.gyroscopeNoiseDensity);
+  this->gyroNoise = this->noise.AddWhiteDensity(
+    this->imuParameters.gyroscopeNoiseDensity);
   double gyroVar = this->imuParameters.gyroscopeNoiseDensity *
     this->imuParameters.gyroscopeNoiseDensity;
   this->imuROSMessage.angular_velocity_covariance[0] = gyroVar;
@@ -92,7 +121,8 @@ void IMUROSPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
   this->imuROSMessage.angular_velocity_covariance[8] = gyroVar;
 
   // Linear acceleration measurement covariance.
-  this->AddNoiseModel("acc_noise_density", this->imuParameters.accelerometerNoiseDensity);
+  this->accNoise = this->noise.AddWhiteDensity(
+    this->imuParameters.accelerometerNoiseDensity);
   double accelVar = this->imuParameters.accelerometerNoiseDensity *
     this->imuParameters.accelerometerNoiseDensity;
   this->imuROSMessage.linear_acceleration_covariance[0] = accelVar;
@@ -100,58 +130,63 @@ void IMUROSPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
   this->imuROSMessage.linear_acceleration_covariance[8] = accelVar;
 
   // Orientation estimate covariance
-  this->AddNoiseModel("orientation_noise_density", this->imuParameters.orientationNoise);
+  this->orientationNoise = this->noise.AddWhite(
+    this->imuParameters.orientationNoise);
   double orientationVar = this->imuParameters.orientationNoise *
     this->imuParameters.orientationNoise;
   this->imuROSMessage.orientation_covariance[0] = orientationVar;
   this->imuROSMessage.orientation_covariance[4] = orientationVar;
   this->imuROSMessage.orientation_covariance[8] = orientationVar;
 
-  // Store the acc. gravity vector
-#if GAZEBO_MAJOR_VERSION >= 8
-  this->gravityWorld = this->world->Gravity();
-#else
-  this->gravityWorld = this->world->GetPhysicsEngine()->GetGravity().Ign();
-#endif
-
-  double sigmaBonG = this->imuParameters.gyroscopeTurnOnBiasSigma;
-  double sigmaBonA = this->imuParameters.accelerometerTurnOnBiasSigma;
-
-  this->AddNoiseModel("gyro_turn_on_bias", sigmaBonG);
-  this->AddNoiseModel("acc_turn_on_bias", sigmaBonA);
+  NoiseGenerator::Model gyroTurnOn = this->noise.AddWhite(
+    this->imuParameters.gyroscopeTurnOnBiasSigma);
+  NoiseGenerator::Model accTurnOn = this->noise.AddWhite(
+    this->imuParameters.accelerometerTurnOnBiasSigma);
 
   // FIXME Add the noise amplitude input for gyroscope
-  this->gyroscopeTurnOnBias = ignition::math::Vector3d(
-    this->GetGaussianNoise("gyro_turn_on_bias", this->noiseAmp),
-    this->GetGaussianNoise("gyro_turn_on_bias", this->noiseAmp),
-    this->GetGaussianNoise("gyro_turn_on_bias", this->noiseAmp));
+  this->gyroscopeTurnOnBias = this->noise.Sample3(gyroTurnOn, this->noiseAmp);
   // FIXME Add the noise amplitude input for accelerometer
-  this->accelerometerTurnOnBias = ignition::math::Vector3d(
-    this->GetGaussianNoise("acc_turn_on_bias", this->noiseAmp),
-    this->GetGaussianNoise("acc_turn_on_bias", this->noiseAmp),
-    this->GetGaussianNoise("acc_turn_on_bias", this->noiseAmp));
+  this->accelerometerTurnOnBias = this->noise.Sample3(accTurnOn,
+    this->noiseAmp);
+
+  // Drifting biases, simulated as first order Gauss-Markov processes
+  this->gyroBiasNoise = this->noise.AddGaussMarkov(
+    this->imuParameters.gyroscopeRandomWalk,
+    this->imuParameters.gyroscopeBiasCorrelationTime);
+  this->accBiasNoise = this->noise.AddGaussMarkov(
+    this->imuParameters.accelerometerRandomWalk,
+    this->imuParameters.accelerometerBiasCorrelationTime);
 
   // TODO(nikolicj) incorporate steady-state covariance of bias process
   this->gyroscopeBias = ignition::math::Vector3d::Zero;
   this->accelerometerBias = ignition::math::Vector3d::Zero;
+}
 
-  this->rosSensorOutputPub =
-    this->rosNode->advertise<sensor_msgs::Imu>(this->sensorOutputTopic, 1);
+/////////////////////////////////////////////////
+void IMUROSPlugin::InitGazeboMessage()
+{
+  double gyroVar = this->imuParameters.gyroscopeNoiseDensity *
+    this->imuParameters.gyroscopeNoiseDensity;
+  double accelVar = this->imuParameters.accelerometerNoiseDensity *
+    this->imuParameters.accelerometerNoiseDensity;
 
-  if (this->gazeboMsgEnabled)
+  // The covariances are constant, only the measurements are written on
+  // each update
+  this->imuGazeboMessage.Clear();
+  for (int i = 0; i < 9; i++)
   {
-    this->gazeboSensorOutputPub =
-      this->gazeboNode->Advertise<sensor_msgs::msgs::Imu>(
-        this->robotNamespace + "/" + this->sensorOutputTopic, 1);
+    bool diagonal = i % 4 == 0;
+    this->imuGazeboMessage.add_angular_velocity_covariance(
+      diagonal ? gyroVar : 0.0);
+    this->imuGazeboMessage.add_orientation_covariance(-1.0);
+    this->imuGazeboMessage.add_linear_acceleration_covariance(
+      diagonal ? accelVar : 0.0);
   }
 }
 
 /////////////////////////////////////////////////
 bool IMUROSPlugin::OnUpdate(const common::UpdateInfo& _info)
 {
-  // Publish sensor state
-  this->PublishState();
-
   if (!this->EnableMeasurement(_info))
     return false;
 
@@ -167,62 +202,56 @@ bool IMUROSPlugin::OnUpdate(const common::UpdateInfo& _info)
 
   double dt = curTime.Double() - this->lastMeasurementTime.Double();
 
-  ignition::math::Pose3d worldLinkPose;
-  ignition::math::Vector3d refLinVel;
-  ignition::math::Vector3d bodyAngVel;
-  ignition::math::Vector3d bodyLinAcc, worldLinAcc;
-  ignition::math::Vector3d refGravityWorld;
+  ignition::math::Quaterniond linkRot;
+  ignition::math::Vector3d bodyAngVel, bodyLinAcc;
 
-  // Read sensor link's current pose and velocity
+  // Read sensor link's current orientation, velocity and acceleration
 #if GAZEBO_MAJOR_VERSION >= 8
   bodyAngVel = this->link->RelativeAngularVel();
   bodyLinAcc = this->link->RelativeLinearAccel();
-  worldLinkPose = this->link->WorldPose();
+  linkRot = this->link->WorldPose().Rot();
 #else
   bodyAngVel = this->link->GetRelativeAngularVel().Ign();
   bodyLinAcc = this->link->GetRelativeLinearAccel().Ign();
-  worldLinkPose = this->link->GetWorldPose().Ign();
+  linkRot = this->link->GetWorldPose().Ign().Rot();
 #endif
 
-  this->UpdateReferenceFramePose();
-  if (this->referenceLink)
+  // A static reference frame is final once measurements are enabled, so
+  // its inverse rotation is only computed for the first measurement
+  if (this->referenceLink || !this->isReferenceRotInit)
   {
-#if GAZEBO_MAJOR_VERSION >= 8
-    this->referenceFrame = this->referenceLink->WorldPose();
-#else
-    this->referenceFrame = this->referenceLink->GetWorldPose().Ign();
-#endif
+    this->UpdateReferenceFramePose();
+    this->referenceRotInverse = this->referenceFrame.Rot().Inverse();
+    this->isReferenceRotInit = true;
   }
 
-  // Transform pose and velocity vectors to be represented wrt the
-  // reference link provided
-  worldLinkPose.Pos() = worldLinkPose.Pos() - this->referenceFrame.Pos();
-  worldLinkPose.Pos() = this->referenceFrame.Rot().RotateVectorReverse(
-    worldLinkPose.Pos());
-  worldLinkPose.Rot() *= this->referenceFrame.Rot().Inverse();
+  this->UpdateMeasurement(linkRot, bodyAngVel, bodyLinAcc, dt,
+    _info.simTime);
 
-  ignition::math::Vector3d gravityBody =
-    worldLinkPose.Rot().RotateVectorReverse(this->gravityWorld);
+  this->rosSensorOutputPub.publish(this->imuROSMessage);
+  if (this->gazeboMsgEnabled)
+    this->gazeboSensorOutputPub->Publish(this->imuGazeboMessage);
 
-  if (this->enableLocalNEDFrame)
-  {
-    bodyAngVel = this->localNEDFrame.Rot().RotateVector(bodyAngVel);
-    bodyLinAcc = this->localNEDFrame.Rot().RotateVector(bodyLinAcc);
-    gravityBody = this->localNEDFrame.Rot().RotateVector(gravityBody);
-  }
+  this->lastMeasurementTime = curTime;
+  return true;
+}
 
-  // Compute the simulated measurements wrt the default world ENU frame
-  this->measLinearAcc = bodyLinAcc - gravityBody;
-  this->measAngularVel = bodyAngVel;
-  this->measOrientation = worldLinkPose.Rot();
+/////////////////////////////////////////////////
+void IMUROSPlugin::UpdateMeasurement(
+  const ignition::math::Quaterniond& _linkRot,
+  const ignition::math::Vector3d& _bodyAngVel,
+  const ignition::math::Vector3d& _bodyLinAcc, double _dt,
+  const common::Time& _simTime)
+{
+  this->ComputeMeasurement(_linkRot, _bodyAngVel, _bodyLinAcc);
 
   // Add noise and bias to the simulated data
   this->AddNoise(this->measLinearAcc, this->measAngularVel,
-    this->measOrientation, dt);
+    this->measOrientation, _dt);
 
-  // Fill the ROS IMU message
-  this->imuROSMessage.header.stamp.sec = _info.simTime.sec;
-  this->imuROSMessage.header.stamp.nsec = _info.simTime.nsec;
+  // Fill the ROS IMU message, allocated once and only overwritten here
+  this->imuROSMessage.header.stamp.sec = _simTime.sec;
+  this->imuROSMessage.header.stamp.nsec = _simTime.nsec;
 
   this->imuROSMessage.orientation.x = this->measOrientation.X();
   this->imuROSMessage.orientation.y = this->measOrientation.Y();
@@ -237,86 +266,58 @@ bool IMUROSPlugin::OnUpdate(const common::UpdateInfo& _info)
   this->imuROSMessage.angular_velocity.y = this->measAngularVel.Y();
   this->imuROSMessage.angular_velocity.z = this->measAngularVel.Z();
 
-  this->rosSensorOutputPub.publish(this->imuROSMessage);
-
   if (this->gazeboMsgEnabled)
+    this->FillGazeboMessage();
+}
+
+/////////////////////////////////////////////////
+void IMUROSPlugin::ComputeMeasurement(
+  const ignition::math::Quaterniond& _linkRot,
+  const ignition::math::Vector3d& _bodyAngVel,
+  const ignition::math::Vector3d& _bodyLinAcc)
+{
+  // Represent the orientation wrt the reference frame provided, the
+  // position is not part of the measurement
+  ignition::math::Quaterniond linkRot = _linkRot * this->referenceRotInverse;
+
+  // Compute the simulated measurements wrt the default world ENU frame, the
+  // rotation into the local NED frame is applied to the specific force as
+  // a whole
+  this->measLinearAcc = _bodyLinAcc -
+    linkRot.RotateVectorReverse(this->gravityWorld);
+  this->measAngularVel = _bodyAngVel;
+  this->measOrientation = linkRot;
+
+  if (this->enableLocalNEDFrame)
   {
-    sensor_msgs::msgs::Imu imuGazeboMessage;
-    // Fill the Gazebo IMU message
-    for (int i = 0; i < 9; i++)
-    {
-      switch (i)
-      {
-        case 0:
-          imuGazeboMessage.add_angular_velocity_covariance(
-                      this->imuParameters.gyroscopeNoiseDensity *
-                      this->imuParameters.gyroscopeNoiseDensity);
-          imuGazeboMessage.add_orientation_covariance(-1.0);
-          imuGazeboMessage.add_linear_acceleration_covariance(
-                      this->imuParameters.accelerometerNoiseDensity *
-                      this->imuParameters.accelerometerNoiseDensity);
-          break;
-        case 1:
-        case 2:
-        case 3:
-          imuGazeboMessage.add_angular_velocity_covariance(0.0);
-          imuGazeboMessage.add_orientation_covariance(-1.0);
-          imuGazeboMessage.add_linear_acceleration_covariance(0.0);
-          break;
-        case 4:
-          imuGazeboMessage.add_angular_velocity_covariance(
-                      this->imuParameters.gyroscopeNoiseDensity *
-                      this->imuParameters.gyroscopeNoiseDensity);
-          imuGazeboMessage.add_orientation_covariance(-1.0);
-          imuGazeboMessage.add_linear_acceleration_covariance(
-                      this->imuParameters.accelerometerNoiseDensity *
-                      this->imuParameters.accelerometerNoiseDensity);
-          break;
-        case 5:
-        case 6:
-        case 7:
-          imuGazeboMessage.add_angular_velocity_covariance(0.0);
-          imuGazeboMessage.add_orientation_covariance(-1.0);
-          imuGazeboMessage.add_linear_acceleration_covariance(0.0);
-          break;
-        case 8:
-          imuGazeboMessage.add_angular_velocity_covariance(
-                      this->imuParameters.gyroscopeNoiseDensity *
-                      this->imuParameters.gyroscopeNoiseDensity);
-          imuGazeboMessage.add_orientation_covariance(-1.0);
-          imuGazeboMessage.add_linear_acceleration_covariance(
-                      this->imuParameters.accelerometerNoiseDensity *
-                      this->imuParameters.accelerometerNoiseDensity);
-          break;
-      }
-    }
-    // Copy math::Quaternion to gazebo::msgs::Quaternion
-    gazebo::msgs::Quaternion * orientation = new gazebo::msgs::Quaternion();
-    orientation->set_x(this->measOrientation.X());
-    orientation->set_y(this->measOrientation.Y());
-    orientation->set_z(this->measOrientation.Z());
-    orientation->set_w(this->measOrientation.W());
-
-    // Copy Eigen::Vector3d to gazebo::msgs::Vector3d
-     gazebo::msgs::Vector3d * linAcc = new gazebo::msgs::Vector3d();
-    linAcc->set_x(this->measLinearAcc.X());
-    linAcc->set_y(this->measLinearAcc.Y());
-    linAcc->set_z(this->measLinearAcc.Z());
-
-    // Copy Eigen::Vector3d to gazebo::msgs::Vector3d
-    gazebo::msgs::Vector3d * angVel = new gazebo::msgs::Vector3d();
-    angVel->set_x(this->measAngularVel.X());
-    angVel->set_y(this->measAngularVel.Y());
-    angVel->set_z(this->measAngularVel.Z());
-
-    imuGazeboMessage.set_allocated_orientation(orientation);
-    imuGazeboMessage.set_allocated_linear_acceleration(linAcc);
-    imuGazeboMessage.set_allocated_angular_velocity(angVel);
-    this->gazeboSensorOutputPub->Publish(imuGazeboMessage);
+    this->measAngularVel =
+      this->localNEDFrame.Rot().RotateVector(this->measAngularVel);
+    this->measLinearAcc =
+      this->localNEDFrame.Rot().RotateVector(this->measLinearAcc);
   }
+}
 
-  this->lastMeasurementTime = curTime;
-  return true;
+/////////////////////////////////////////////////
+void IMUROSPlugin::FillGazeboMessage()
+{
+  gazebo::msgs::Quaternion *orientation =
+    this->imuGazeboMessage.mutable_orientation();
+  orientation->set_x(this->measOrientation.X());
+  orientation->set_y(this->measOrientation.Y());
+  orientation->set_z(this->measOrientation.Z());
+  orientation->set_w(this->measOrientation.W());
+
+  gazebo::msgs::Vector3d *linAcc =
+    this->imuGazeboMessage.mutable_linear_acceleration();
+  linAcc->set_x(this->measLinearAcc.X());
+  linAcc->set_y(this->measLinearAcc.Y());
+  linAcc->set_z(this->measLinearAcc.Z());
+
+  gazebo::msgs::Vector3d *angVel =
+    this->imuGazeboMessage.mutable_angular_velocity();
+  angVel->set_x(this->measAngularVel.X());
+  angVel->set_y(this->measAngularVel.Y());
+  angVel->set_z(this->measAngularVel.Z());
 }
 
 /////////////////////////////////////////////////
@@ -326,74 +327,30 @@ void IMUROSPlugin::AddNoise(ignition::math::Vector3d& _linAcc,
 {
   GZ_ASSERT(_dt > 0.0, "Invalid time step");
 
-  /// Gyroscope
-  double tauG = this->imuParameters.gyroscopeBiasCorrelationTime;
-  // Discrete-time standard deviation equivalent to an "integrating" sampler
-  // with integration time dt.
-  double sigmaGD = 1 / sqrt(_dt) * this->imuParameters.gyroscopeNoiseDensity;
-  double sigmaBG = this->imuParameters.gyroscopeRandomWalk;
-  // Compute exact covariance of the process after dt [Maybeck 4-114].
-  double sigmaBGD = sqrt(- sigmaBG * sigmaBG * tauG / 2.0 *
-    (exp(-2.0 * _dt / tauG) - 1.0));
-  // Compute state-transition.
-  double phiGD = exp(-1.0 / tauG * _dt);
-
-  // FIXME Add the noise amplitude input for BGD
-  this->AddNoiseModel("bgd", sigmaBGD);
-  // FIXME Add the noise amplitude input for GD
-  this->AddNoiseModel("gd", sigmaGD);
-
-  // Simulate gyroscope noise processes and add them to the true angular rate.
-  this->gyroscopeBias = phiGD * this->gyroscopeBias +
-    ignition::math::Vector3d(
-      this->GetGaussianNoise("bgd", this->noiseAmp),
-      this->GetGaussianNoise("bgd", this->noiseAmp),
-      this->GetGaussianNoise("bgd", this->noiseAmp));
+  // The white noise is scaled to an "integrating" sampler with integration
+  // time dt, the bias processes are propagated exactly over dt
+  // [Maybeck 4-114].
+  // FIXME Add the noise amplitude input for the gyroscope
+  this->gyroscopeBias = this->noise.Sample3(this->gyroBiasNoise,
+    this->noiseAmp, _dt);
   _angVel = _angVel + this->gyroscopeBias + this->gyroscopeTurnOnBias +
-    ignition::math::Vector3d(
-      this->GetGaussianNoise("gd", this->noiseAmp),
-      this->GetGaussianNoise("gd", this->noiseAmp),
-      this->GetGaussianNoise("gd", this->noiseAmp));
-
-  /// Accelerometer
-  double tauA = this->imuParameters.accelerometerBiasCorrelationTime;
-  // Discrete-time standard deviation equivalent to an "integrating" sampler
-  // with integration time dt.
-  double sigmaAD = 1. / sqrt(_dt) * this->imuParameters.accelerometerNoiseDensity;
-  double sigmaBA = this->imuParameters.accelerometerRandomWalk;
-  // Compute exact covariance of the process after dt [Maybeck 4-114].
-  double sigmaBAD = sqrt(- sigmaBA * sigmaBA * tauA / 2.0 *
-    (exp(-2.0 * _dt / tauA) - 1.0));
-  // Compute state-transition.
-  double phiAD = exp(-1.0 / tauA * _dt);
-
-  // FIXME Add the noise amplitude input for BAD
-  this->AddNoiseModel("bad", sigmaBAD);
-  // FIXME Add the noise amplitude input for BAD
-  this->AddNoiseModel("ad", sigmaAD);
-
-  // Simulate accelerometer noise processes and add them to the true linear
-  // acceleration.
-  this->accelerometerBias = phiAD * this->accelerometerBias +
-    ignition::math::Vector3d(
-      this->GetGaussianNoise("bad", this->noiseAmp),
-      this->GetGaussianNoise("bad", this->noiseAmp),
-      this->GetGaussianNoise("bad", this->noiseAmp));
+    this->noise.Sample3(this->gyroNoise, this->noiseAmp, _dt);
+
+  // FIXME Add the noise amplitude input for the accelerometer
+  this->accelerometerBias = this->noise.Sample3(this->accBiasNoise,
+    this->noiseAmp, _dt);
   _linAcc = _linAcc + this->accelerometerBias + this->accelerometerTurnOnBias +
-    ignition::math::Vector3d(
-      this->GetGaussianNoise("ad", this->noiseAmp),
-      this->GetGaussianNoise("ad", this->noiseAmp),
-      this->GetGaussianNoise("ad", this->noiseAmp));
+    this->noise.Sample3(this->accNoise, this->noiseAmp, _dt);
 
   /// Orientation
   // Construct error quaterion using small-angle approximation.
   double scale = 0.5 * this->imuParameters.orientationNoise;
+  ignition::math::Vector3d angleError =
+    this->noise.Sample3(this->orientationNoise, scale);
 
   // Attention: w-xyz
   ignition::math::Quaterniond error(1.0,
-    this->GetGaussianNoise("orientation_noise_density", scale),
-    this->GetGaussianNoise("orientation_noise_density", scale),
-    this->GetGaussianNoise("orientation_noise_density", scale));
+    angleError.X(), angleError.Y(), angleError.Z());
 
   error.Normalize();
   _orientation = _orientation * error;
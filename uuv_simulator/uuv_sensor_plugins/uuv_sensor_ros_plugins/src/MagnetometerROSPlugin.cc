@@ -60,15 +60,11 @@ void MagnetometerROSPlugin::Load(physics::ModelPtr _model,
   this->magneticFieldWorld.Z() = this->parameters.intensity *
     -1 * sin(this->parameters.inclination);
 
-  this->AddNoiseModel("turn_on_bias", this->parameters.turnOnBias);
+  NoiseGenerator::Model turnOnBiasNoise =
+    this->noise.AddWhite(this->parameters.turnOnBias);
 
   // FIXME Add different options for noise amplitude for each noise model
-  this->turnOnBias.X() = this->GetGaussianNoise("turn_on_bias",
-    this->noiseAmp);
-  this->turnOnBias.Y() = this->GetGaussianNoise("turn_on_bias",
-    this->noiseAmp);
-  this->turnOnBias.Z() = this->GetGaussianNoise("turn_on_bias",
-    this->noiseAmp);
+  this->turnOnBias = this->noise.Sample3(turnOnBiasNoise, this->noiseAmp);
 
   // Initialize ROS message
   if (this->enableLocalNEDFrame)
@@ -76,8 +72,8 @@ void MagnetometerROSPlugin::Load(physics::ModelPtr _model,
   else
     this->rosMsg.header.frame_id = this->link->GetName();
 
-  this->AddNoiseModel("noise_xy", this->parameters.noiseXY);
-  this->AddNoiseModel("noise_z", this->parameters.noiseZ);
+  this->noiseXY = this->noise.AddWhite(this->parameters.noiseXY);
+  this->noiseZ = this->noise.AddWhite(this->parameters.noiseZ);
 
   this->rosMsg.magnetic_field_covariance[0] =
     this->parameters.noiseXY * this->parameters.noiseXY;
@@ -116,15 +112,15 @@ bool MagnetometerROSPlugin::OnUpdate(const common::UpdateInfo& _info)
   pose = this->link->GetWorldPose().Ign();
 #endif
 
-  ignition::math::Vector3d noise(
-    this->GetGaussianNoise("noise_xy", this->noiseAmp),
-    this->GetGaussianNoise("noise_xy", this->noiseAmp),
-    this->GetGaussianNoise("noise_z", this->noiseAmp));
+  ignition::math::Vector3d measNoise(
+    this->noise.Sample(this->noiseXY, this->noiseAmp),
+    this->noise.Sample(this->noiseXY, this->noiseAmp),
+    this->noise.Sample(this->noiseZ, this->noiseAmp));
 
   this->measMagneticField =
     pose.Rot().RotateVectorReverse(this->magneticFieldWorld) +
     this->turnOnBias +
-    noise;
+    measNoise;
 
   if (this->enableLocalNEDFrame)
     this->measMagneticField = this->localNEDFrame.Rot().RotateVector(
@@ -0,0 +1,178 @@
+// Copyright (c) 2016 The UUV Simulator Authors.
+// All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <uuv_sensor_ros_plugins/NoiseGenerator.hh>
+#include <cmath>
+
+namespace gazebo
+{
+/// \brief SplitMix64 step, used to expand seeds
+static uint64_t SplitMix64(uint64_t &_state)
+{
+  uint64_t z = (_state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+/// \brief Bit rotation
+static inline uint64_t Rotl(uint64_t _x, int _k)
+{
+  return (_x << _k) | (_x >> (64 - _k));
+}
+
+const size_t NoiseGenerator::kBlockSize;
+
+/////////////////////////////////////////////////
+NoiseGenerator::NoiseGenerator(uint64_t _seed)
+{
+  this->Seed(_seed);
+}
+
+/////////////////////////////////////////////////
+void NoiseGenerator::Seed(uint64_t _seed)
+{
+  uint64_t state = _seed;
+  for (int i = 0; i < 4; ++i)
+    this->rng[i] = SplitMix64(state);
+  // Force a refill on the next sample
+  this->next = kBlockSize;
+}
+
+/////////////////////////////////////////////////
+uint64_t NoiseGenerator::StreamSeed(uint64_t _worldSeed,
+  const std::string &_name)
+{
+  // FNV-1a of the name, mixed with the world seed
+  uint64_t hash = 0xCBF29CE484222325ULL;
+  for (char c : _name)
+  {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001B3ULL;
+  }
+  uint64_t state = _worldSeed ^ hash;
+  return SplitMix64(state);
+}
+
+/////////////////////////////////////////////////
+NoiseGenerator::Model NoiseGenerator::AddWhite(double _sigma)
+{
+  this->models.push_back(ModelData{WHITE, _sigma, 0.0,
+    ignition::math::Vector3d::Zero});
+  return this->models.size() - 1;
+}
+
+/////////////////////////////////////////////////
+NoiseGenerator::Model NoiseGenerator::AddWhiteDensity(double _density)
+{
+  this->models.push_back(ModelData{WHITE_DENSITY, _density, 0.0,
+    ignition::math::Vector3d::Zero});
+  return this->models.size() - 1;
+}
+
+/////////////////////////////////////////////////
+NoiseGenerator::Model NoiseGenerator::AddGaussMarkov(double _sigma,
+  double _tau)
+{
+  this->models.push_back(ModelData{GAUSS_MARKOV, _sigma, _tau,
+    ignition::math::Vector3d::Zero});
+  return this->models.size() - 1;
+}
+
+/////////////////////////////////////////////////
+double NoiseGenerator::Sample(Model _model, double _amp, double _dt)
+{
+  const ModelData &model = this->models[_model];
+  double sigma = model.sigma;
+  if (model.type == WHITE_DENSITY)
+    sigma /= std::sqrt(_dt);
+  return _amp * sigma * this->Normal();
+}
+
+/////////////////////////////////////////////////
+ignition::math::Vector3d NoiseGenerator::Sample3(Model _model, double _amp,
+  double _dt)
+{
+  ModelData &model = this->models[_model];
+  ignition::math::Vector3d n(this->Normal(), this->Normal(), this->Normal());
+
+  if (model.type != GAUSS_MARKOV)
+  {
+    double sigma = model.sigma;
+    if (model.type == WHITE_DENSITY)
+      sigma /= std::sqrt(_dt);
+    return _amp * sigma * n;
+  }
+
+  // Exact discretization of the process over dt [Maybeck 4-114]
+  double phi = 1.0;
+  double sigmaD = model.sigma * std::sqrt(_dt);
+  if (model.tau > 0.0)
+  {
+    phi = std::exp(-_dt / model.tau);
+    sigmaD = std::sqrt(model.sigma * model.sigma * model.tau / 2.0 *
+      (1.0 - phi * phi));
+  }
+  model.state = phi * model.state + _amp * sigmaD * n;
+  return model.state;
+}
+
+/////////////////////////////////////////////////
+double NoiseGenerator::Uniform()
+{
+  // The upper 53 bits fill the mantissa of a double exactly
+  return (this->NextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/////////////////////////////////////////////////
+uint64_t NoiseGenerator::NextRandom()
+{
+  uint64_t *s = this->rng;
+  uint64_t result = Rotl(s[1] * 5, 7) * 9;
+  uint64_t t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = Rotl(s[3], 45);
+  return result;
+}
+
+/////////////////////////////////////////////////
+void NoiseGenerator::Refill()
+{
+  // Box-Muller on a whole block. The loops do not vectorize: the generator
+  // is sequential and, without -ffast-math, log, sin and cos stay scalar
+  // libm calls. Generating a block keeps the per-sample cost at an array
+  // read, and each log and sqrt serves two samples.
+  const size_t half = kBlockSize / 2;
+  double u1[half], u2[half];
+  for (size_t i = 0; i < half; ++i)
+  {
+    // 53 random bits, offset to stay out of log(0)
+    u1[i] = ((this->NextRandom() >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+    u2[i] = (this->NextRandom() >> 11) * (2.0 * M_PI / 9007199254740992.0);
+  }
+  for (size_t i = 0; i < half; ++i)
+    u1[i] = std::sqrt(-2.0 * std::log(u1[i]));
+  for (size_t i = 0; i < half; ++i)
+  {
+    this->block[i] = u1[i] * std::cos(u2[i]);
+    this->block[half + i] = u1[i] * std::sin(u2[i]);
+  }
+  this->next = 0;
+}
+}
@@ -0,0 +1,246 @@
+// Copyright (c) 2016 The UUV Simulator Authors.
+// All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <uuv_sensor_ros_plugins/PlumeParticleIndex.hh>
+#include <algorithm>
+#include <cmath>
+
+namespace gazebo
+{
+std::map<std::tuple<std::string, double, double>,
+  std::weak_ptr<PlumeParticleIndex>> PlumeParticleIndex::indices;
+
+std::mutex PlumeParticleIndex::indicesMutex;
+
+/////////////////////////////////////////////////
+std::shared_ptr<PlumeParticleIndex> PlumeParticleIndex::Get(
+  const std::string &_topic, double _smoothingLength, double _gamma)
+{
+  std::lock_guard<std::mutex> lock(indicesMutex);
+  std::weak_ptr<PlumeParticleIndex> &entry =
+    indices[std::make_tuple(_topic, _smoothingLength, _gamma)];
+  std::shared_ptr<PlumeParticleIndex> index = entry.lock();
+  if (!index)
+  {
+    index.reset(new PlumeParticleIndex(_smoothingLength, _gamma));
+    entry = index;
+  }
+  return index;
+}
+
+/////////////////////////////////////////////////
+PlumeParticleIndex::PlumeParticleIndex(double _smoothingLength,
+  double _gamma) : smoothingLength(_smoothingLength), gamma(_gamma),
+  cellSize(1.0)
+{
+  for (int i = 0; i < 3; i++)
+  {
+    this->origin[i] = 0.0;
+    this->dims[i] = 1;
+  }
+  this->cellStart.assign(2, 0);
+}
+
+/////////////////////////////////////////////////
+size_t PlumeParticleIndex::Size()
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->particles.size();
+}
+
+/////////////////////////////////////////////////
+int64_t PlumeParticleIndex::CellCoord(double _pos, int _axis) const
+{
+  double c = std::floor((_pos - this->origin[_axis]) / this->cellSize);
+  return std::min(std::max(static_cast<int64_t>(c), int64_t(0)),
+    this->dims[_axis] - 1);
+}
+
+/////////////////////////////////////////////////
+bool PlumeParticleIndex::IsIndexed(
+  const sensor_msgs::PointCloud::ConstPtr &_cloud) const
+{
+  if (!this->cloud)
+    return false;
+  if (this->cloud == _cloud)
+    return true;
+  // Subscribers in one process usually share the message instance, compare
+  // the contents in case a cloud was delivered as a separate copy
+  return this->cloud->header.seq == _cloud->header.seq &&
+    this->cloud->header.stamp == _cloud->header.stamp &&
+    this->cloud->points.size() == _cloud->points.size();
+}
+
+/////////////////////////////////////////////////
+void PlumeParticleIndex::Build(
+  const sensor_msgs::PointCloud::ConstPtr &_cloud)
+{
+  this->cloud = _cloud;
+
+  const size_t numPoints = _cloud->points.size();
+  double currentTime = _cloud->header.stamp.toSec();
+  // The first channel holds the time each particle was created
+  bool hasTime = !_cloud->channels.empty() &&
+    _cloud->channels[0].values.size() == numPoints;
+  double initSmoothingLength = std::pow(this->smoothingLength, 2.0 / 3);
+
+  std::vector<Particle> unsorted(numPoints);
+  double maxSupport = 0.0;
+  double lower[3] = {0.0, 0.0, 0.0};
+  double upper[3] = {0.0, 0.0, 0.0};
+  for (size_t i = 0; i < numPoints; i++)
+  {
+    double age = hasTime ? currentTime - _cloud->channels[0].values[i] : 0.0;
+    double base = initSmoothingLength + this->gamma * age;
+    double h = base * std::sqrt(base);
+
+    Particle &p = unsorted[i];
+    p.x = _cloud->points[i].x;
+    p.y = _cloud->points[i].y;
+    p.z = _cloud->points[i].z;
+    p.index = i;
+    p.invH = 1.0 / h;
+    p.supportSq = 4.0 * h * h;
+    p.norm = 1.0 / (4.0 * M_PI * h * h * h);
+    maxSupport = std::max(maxSupport, 2.0 * h);
+
+    const double pos[3] = {p.x, p.y, p.z};
+    for (int k = 0; k < 3; k++)
+    {
+      lower[k] = (i == 0 ? pos[k] : std::min(lower[k], pos[k]));
+      upper[k] = (i == 0 ? pos[k] : std::max(upper[k], pos[k]));
+    }
+  }
+
+  // Cells must be at least as large as the largest kernel support so that
+  // a query only visits the neighboring cells, and are made larger if
+  // needed to keep the grid at about one cell per particle
+  double volume = 1.0;
+  for (int k = 0; k < 3; k++)
+    volume *= std::max(upper[k] - lower[k], maxSupport);
+  this->cellSize = std::max(maxSupport,
+    std::cbrt(volume / std::max(numPoints, size_t(1))));
+  if (this->cellSize <= 0.0)
+    this->cellSize = 1.0;
+
+  size_t numCells = 1;
+  for (int k = 0; k < 3; k++)
+  {
+    this->origin[k] = lower[k];
+    this->dims[k] = static_cast<int64_t>(
+      std::floor((upper[k] - lower[k]) / this->cellSize)) + 1;
+    numCells *= this->dims[k];
+  }
+
+  // Counting sort of the particles by cell, each cell is then a contiguous
+  // range of particles
+  std::vector<uint32_t> cellOf(numPoints);
+  this->cellStart.assign(numCells + 1, 0);
+  for (size_t i = 0; i < numPoints; i++)
+  {
+    cellOf[i] = (this->CellCoord(unsorted[i].x, 0) * this->dims[1] +
+      this->CellCoord(unsorted[i].y, 1)) * this->dims[2] +
+      this->CellCoord(unsorted[i].z, 2);
+    this->cellStart[cellOf[i] + 1]++;
+  }
+  for (size_t c = 0; c < numCells; c++)
+    this->cellStart[c + 1] += this->cellStart[c];
+
+  std::vector<uint32_t> next(this->cellStart.begin(),
+    this->cellStart.end() - 1);
+  this->particles.resize(numPoints);
+  for (size_t i = 0; i < numPoints; i++)
+    this->particles[next[cellOf[i]]++] = unsorted[i];
+}
+
+/////////////////////////////////////////////////
+template<typename Fn>
+void PlumeParticleIndex::ForEachNeighbor(
+  const ignition::math::Vector3d &_pos, Fn _fn) const
+{
+  // Every particle reaching _pos lies in one of the cells around it. The
+  // clamping keeps positions outside of the grid on its border cells.
+  const double pos[3] = {_pos.X(), _pos.Y(), _pos.Z()};
+  int64_t from[3], to[3];
+  for (int k = 0; k < 3; k++)
+  {
+    from[k] = this->CellCoord(pos[k] - this->cellSize, k);
+    to[k] = this->CellCoord(pos[k] + this->cellSize, k);
+  }
+
+  for (int64_t x = from[0]; x <= to[0]; x++)
+    for (int64_t y = from[1]; y <= to[1]; y++)
+    {
+      // Cells along Z are contiguous
+      int64_t row = (x * this->dims[1] + y) * this->dims[2];
+      uint32_t begin = this->cellStart[row + from[2]];
+      uint32_t end = this->cellStart[row + to[2] + 1];
+
+      for (uint32_t i = begin; i < end; i++)
+      {
+        const Particle &p = this->particles[i];
+        double dx = pos[0] - p.x;
+        double dy = pos[1] - p.y;
+        double dz = pos[2] - p.z;
+        double distSq = dx * dx + dy * dy + dz * dz;
+        if (distSq < p.supportSq)
+          _fn(p, distSq);
+      }
+    }
+}
+
+/////////////////////////////////////////////////
+double PlumeParticleIndex::Concentration(
+  const sensor_msgs::PointCloud::ConstPtr &_cloud,
+  const ignition::math::Vector3d &_pos)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  if (!this->IsIndexed(_cloud))
+    this->Build(_cloud);
+
+  double total = 0.0;
+  this->ForEachNeighbor(_pos, [&total](const Particle &_p, double _distSq)
+  {
+    // Cubic spline kernel with q = distance / smoothing parameter
+    double q = std::sqrt(_distSq) * _p.invH;
+    double w;
+    if (q < 1.0)
+      w = 4.0 - 6.0 * q * q + 3.0 * q * q * q;
+    else
+    {
+      double r = 2.0 - q;
+      w = r * r * r;
+    }
+    total += w * _p.norm;
+  });
+  return total;
+}
+
+/////////////////////////////////////////////////
+void PlumeParticleIndex::Neighbors(
+  const sensor_msgs::PointCloud::ConstPtr &_cloud,
+  const ignition::math::Vector3d &_pos, std::vector<size_t> &_indices)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  if (!this->IsIndexed(_cloud))
+    this->Build(_cloud);
+
+  _indices.clear();
+  this->ForEachNeighbor(_pos, [&_indices](const Particle &_p, double)
+  {
+    _indices.push_back(_p.index);
+  });
+}
+}
@@ -86,8 +86,6 @@ void PoseGTROSPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
 #endif
   }
 
-  this->tfListener.reset(new tf2_ros::TransformListener(this->tfBuffer));
-
   this->rosSensorOutputPub = this->rosNode->advertise<nav_msgs::Odometry>(
       this->sensorOutputTopic, 1);
 }
@@ -316,32 +314,16 @@ void PoseGTROSPlugin::UpdateNEDTransform()
   if (this->nedTransformIsInit)
     return;
 
-  geometry_msgs::TransformStamped childTransform;
   std::string targetFrame = this->nedFrameID;
   std::string sourceFrame = this->link->GetName();
-  try
-  {
-    childTransform = this->tfBuffer.lookupTransform(
-      targetFrame, sourceFrame, ros::Time(0));
-  }
-  catch(tf2::TransformException &ex)
+  if (!StaticTransformCache::Get(this->world)->Relative(
+    targetFrame, sourceFrame, this->nedTransform))
   {
     gzmsg << "Transform between " << targetFrame << " and " << sourceFrame
-      << std::endl;
-    gzmsg << ex.what() << std::endl;
+      << " is not available" << std::endl;
     return;
   }
 
-  this->nedTransform.Pos() = ignition::math::Vector3d(
-    childTransform.transform.translation.x,
-    childTransform.transform.translation.y,
-    childTransform.transform.translation.z);
-  this->nedTransform.Rot() = ignition::math::Quaterniond(
-    childTransform.transform.rotation.w,
-    childTransform.transform.rotation.x,
-    childTransform.transform.rotation.y,
-    childTransform.transform.rotation.z);
-
   this->nedTransformIsInit = true;
 }
 
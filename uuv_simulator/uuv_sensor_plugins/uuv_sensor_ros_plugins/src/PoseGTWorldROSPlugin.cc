@@ -0,0 +1,308 @@
+// Copyright (c) 2016 The UUV Simulator Authors.
+// All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <uuv_sensor_ros_plugins/PoseGTWorldROSPlugin.hh>
+#include <boost/bind.hpp>
+
+namespace gazebo
+{
+/////////////////////////////////////////////////
+PoseGTWorldROSPlugin::PoseGTWorldROSPlugin()
+{
+  this->world = NULL;
+  this->trackAllModels = false;
+  this->isNEDReferenceInit = false;
+  this->nedWatchId = -1;
+  this->publishArray = true;
+  this->publishPerVehicle = false;
+  this->publishNEDOdom = false;
+  this->schedulerId = -1;
+}
+
+/////////////////////////////////////////////////
+PoseGTWorldROSPlugin::~PoseGTWorldROSPlugin()
+{
+  if (this->scheduler)
+    this->scheduler->Remove(this->schedulerId);
+  if (this->transformCache)
+    this->transformCache->Unwatch(this->nedWatchId);
+  if (this->rosNode)
+    this->rosNode->shutdown();
+}
+
+/////////////////////////////////////////////////
+void PoseGTWorldROSPlugin::Load(physics::WorldPtr _world,
+  sdf::ElementPtr _sdf)
+{
+  GZ_ASSERT(_world != NULL, "World object not available");
+  this->world = _world;
+
+  if (!ros::isInitialized())
+  {
+    gzerr << "Not loading plugin since ROS has not been properly "
+          << "initialized." << std::endl;
+    return;
+  }
+
+  double updateRate;
+  GetSDFParam<double>(_sdf, "update_rate", updateRate, 50.0);
+  GZ_ASSERT(updateRate > 0.0, "Update rate must be greater than zero");
+
+  std::string arrayTopic;
+  GetSDFParam<std::string>(_sdf, "array_topic", arrayTopic, "ground_truth");
+  GetSDFParam<bool>(_sdf, "publish_array", this->publishArray, true);
+  GetSDFParam<bool>(_sdf, "publish_per_vehicle", this->publishPerVehicle,
+    false);
+  GetSDFParam<bool>(_sdf, "publish_ned_odom", this->publishNEDOdom, false);
+  // The NED odometry is not part of the array message
+  this->publishNEDOdom = this->publishNEDOdom && this->publishPerVehicle;
+
+  this->rosNode.reset(new ros::NodeHandle());
+  this->arrayMsg.header.frame_id = "world";
+
+  if (this->publishArray)
+    this->arrayPub =
+      this->rosNode->advertise<uuv_sensor_ros_plugins_msgs::OdometryArray>(
+        arrayTopic, 1);
+
+  this->trackAllModels = !_sdf->HasElement("vehicle");
+  if (!this->trackAllModels)
+  {
+    sdf::ElementPtr vehicleElem = _sdf->GetElement("vehicle");
+    while (vehicleElem)
+    {
+      Vehicle vehicle;
+      vehicle.index = -1;
+      GetSDFParam<std::string>(vehicleElem, "model_name", vehicle.modelName,
+        "");
+      GZ_ASSERT(!vehicle.modelName.empty(), "Vehicle model name is empty");
+      GetSDFParam<std::string>(vehicleElem, "link_name", vehicle.linkName,
+        "");
+
+      std::string topic;
+      GetSDFParam<std::string>(vehicleElem, "topic", topic,
+        vehicle.modelName + "/pose_gt");
+      if (this->publishPerVehicle)
+      {
+        vehicle.odomPub = this->rosNode->advertise<nav_msgs::Odometry>(
+          topic, 1);
+        if (this->publishNEDOdom)
+          vehicle.nedOdomPub = this->rosNode->advertise<nav_msgs::Odometry>(
+            topic + "_ned", 1);
+      }
+      this->vehicles.push_back(vehicle);
+      vehicleElem = vehicleElem->GetNextElement("vehicle");
+    }
+  }
+
+  // world_ned is published on /tf_static, the NED odometry is only
+  // published once it arrived
+  if (this->publishNEDOdom)
+  {
+    this->transformCache = StaticTransformCache::Get(this->world);
+    this->nedWatchId = this->transformCache->Watch("world_ned",
+      [this](const ignition::math::Pose3d &_pose)
+      {
+        std::lock_guard<std::mutex> lock(this->nedMutex);
+        this->nedReference = _pose;
+        this->isNEDReferenceInit = true;
+      });
+  }
+
+  this->scheduler = SensorScheduler::Get(this->world);
+  this->schedulerId = this->scheduler->Add(1.0 / updateRate,
+    boost::bind(&PoseGTWorldROSPlugin::OnUpdate, this, _1));
+}
+
+/////////////////////////////////////////////////
+void PoseGTWorldROSPlugin::ResolveVehicles()
+{
+#if GAZEBO_MAJOR_VERSION >= 8
+  physics::Model_V models = this->world->Models();
+#else
+  physics::Model_V models = this->world->GetModels();
+#endif
+  // The vehicles only need to be looked up again if models were spawned or
+  // removed
+  if (models == this->models)
+    return;
+  this->models = models;
+
+  if (this->trackAllModels)
+  {
+    for (physics::ModelPtr model : models)
+    {
+      if (model->IsStatic())
+        continue;
+      bool known = false;
+      for (const Vehicle &vehicle : this->vehicles)
+        known = known || vehicle.modelName == model->GetName();
+      if (known)
+        continue;
+
+      Vehicle vehicle;
+      vehicle.index = -1;
+      vehicle.modelName = model->GetName();
+      if (this->publishPerVehicle)
+      {
+        vehicle.odomPub = this->rosNode->advertise<nav_msgs::Odometry>(
+          vehicle.modelName + "/pose_gt", 1);
+        if (this->publishNEDOdom)
+          vehicle.nedOdomPub = this->rosNode->advertise<nav_msgs::Odometry>(
+            vehicle.modelName + "/pose_gt_ned", 1);
+      }
+      this->vehicles.push_back(vehicle);
+    }
+  }
+
+  // Rebuild the array message with an entry per vehicle present in the
+  // world, the updates then only overwrite the entries
+  this->arrayMsg.odometry.clear();
+  for (Vehicle &vehicle : this->vehicles)
+  {
+#if GAZEBO_MAJOR_VERSION >= 8
+    physics::ModelPtr model = this->world->ModelByName(vehicle.modelName);
+#else
+    physics::ModelPtr model = this->world->GetModel(vehicle.modelName);
+#endif
+    vehicle.link = NULL;
+    vehicle.index = -1;
+    if (!model)
+      continue;
+
+    if (vehicle.linkName.empty())
+      vehicle.link = model->GetLink();
+    else
+      vehicle.link = model->GetLink(vehicle.linkName);
+    if (!vehicle.link)
+    {
+      gzerr << "Link " << vehicle.linkName << " not found in model "
+        << vehicle.modelName << std::endl;
+      continue;
+    }
+
+    vehicle.index = this->arrayMsg.odometry.size();
+    nav_msgs::Odometry odomMsg;
+    odomMsg.header.frame_id = "world";
+    odomMsg.child_frame_id = vehicle.link->GetName();
+    this->arrayMsg.odometry.push_back(odomMsg);
+
+    vehicle.nedOdomMsg.header.frame_id = "world_ned";
+    vehicle.nedOdomMsg.child_frame_id = vehicle.link->GetName() + "_ned";
+  }
+}
+
+/////////////////////////////////////////////////
+void PoseGTWorldROSPlugin::FillOdometry(nav_msgs::Odometry &_msg,
+  const ignition::math::Pose3d &_pose,
+  const ignition::math::Vector3d &_linVel,
+  const ignition::math::Vector3d &_angVel)
+{
+  _msg.pose.pose.position.x = _pose.Pos().X();
+  _msg.pose.pose.position.y = _pose.Pos().Y();
+  _msg.pose.pose.position.z = _pose.Pos().Z();
+
+  _msg.pose.pose.orientation.x = _pose.Rot().X();
+  _msg.pose.pose.orientation.y = _pose.Rot().Y();
+  _msg.pose.pose.orientation.z = _pose.Rot().Z();
+  _msg.pose.pose.orientation.w = _pose.Rot().W();
+
+  _msg.twist.twist.linear.x = _linVel.X();
+  _msg.twist.twist.linear.y = _linVel.Y();
+  _msg.twist.twist.linear.z = _linVel.Z();
+
+  _msg.twist.twist.angular.x = _angVel.X();
+  _msg.twist.twist.angular.y = _angVel.Y();
+  _msg.twist.twist.angular.z = _angVel.Z();
+}
+
+/////////////////////////////////////////////////
+void PoseGTWorldROSPlugin::OnUpdate(const common::UpdateInfo &_info)
+{
+  this->ResolveVehicles();
+
+  ros::Time stamp(_info.simTime.sec, _info.simTime.nsec);
+
+  bool publishNED = false;
+  ignition::math::Pose3d nedRef;
+  if (this->publishNEDOdom)
+  {
+    std::lock_guard<std::mutex> lock(this->nedMutex);
+    publishNED = this->isNEDReferenceInit;
+    nedRef = this->nedReference;
+  }
+  // Orientation of a link's NED frame wrt the link
+  const ignition::math::Quaterniond localNED(M_PI, 0, 0);
+
+  // All links are read in this one pass between two physics steps, so the
+  // odometry of all vehicles refers to the same simulation time
+  for (Vehicle &vehicle : this->vehicles)
+  {
+    if (!vehicle.link)
+      continue;
+
+#if GAZEBO_MAJOR_VERSION >= 8
+    ignition::math::Pose3d pose = vehicle.link->WorldPose();
+    ignition::math::Vector3d linVel = vehicle.link->WorldLinearVel();
+    ignition::math::Vector3d angVel = vehicle.link->WorldAngularVel();
+#else
+    ignition::math::Pose3d pose = vehicle.link->GetWorldPose().Ign();
+    ignition::math::Vector3d linVel =
+      vehicle.link->GetWorldLinearVel().Ign();
+    ignition::math::Vector3d angVel =
+      vehicle.link->GetWorldAngularVel().Ign();
+#endif
+
+    nav_msgs::Odometry &odomMsg = this->arrayMsg.odometry[vehicle.index];
+    odomMsg.header.stamp = stamp;
+    FillOdometry(odomMsg, pose, linVel, angVel);
+
+    if (publishNED)
+    {
+      // Same convention as the NED odometry of PoseGTROSPlugin
+      const ignition::math::Quaterniond &refRot = nedRef.Rot();
+      ignition::math::Pose3d nedPose;
+      nedPose.Pos() = refRot.RotateVectorReverse(pose.Pos() - nedRef.Pos());
+      nedPose.Rot() = refRot * (pose.Rot() * localNED);
+
+      vehicle.nedOdomMsg.header.stamp = stamp;
+      FillOdometry(vehicle.nedOdomMsg, nedPose, refRot.RotateVector(linVel),
+        refRot.RotateVector(angVel));
+    }
+  }
+
+  if (this->publishPerVehicle)
+  {
+    for (const Vehicle &vehicle : this->vehicles)
+    {
+      if (!vehicle.link)
+        continue;
+      vehicle.odomPub.publish(this->arrayMsg.odometry[vehicle.index]);
+      if (publishNED)
+        vehicle.nedOdomPub.publish(vehicle.nedOdomMsg);
+    }
+  }
+
+  if (this->publishArray)
+  {
+    this->arrayMsg.header.stamp = stamp;
+    this->arrayPub.publish(this->arrayMsg);
+  }
+}
+
+/////////////////////////////////////////////////
+GZ_REGISTER_WORLD_PLUGIN(PoseGTWorldROSPlugin)
+}
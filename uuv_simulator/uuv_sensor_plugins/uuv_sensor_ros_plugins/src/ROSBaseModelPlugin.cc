@@ -31,11 +31,14 @@ ROSBaseModelPlugin::ROSBaseModelPlugin()
     tf::createQuaternionFromRPY(M_PI, 0.0, 0.0));
   // Initialize TF broadcaster
   this->tfBroadcaster = new tf::TransformBroadcaster();
+  this->schedulerId = -1;
 }
 
 /////////////////////////////////////////////////
 ROSBaseModelPlugin::~ROSBaseModelPlugin()
 {
+  if (this->scheduler)
+    this->scheduler->Remove(this->schedulerId);
   if (this->tfBroadcaster)
     delete this->tfBroadcaster;
 }
@@ -78,11 +81,18 @@ void ROSBaseModelPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
   this->tfLocalNEDFrame.frame_id_ = this->link->GetName();
   this->tfLocalNEDFrame.child_frame_id_ = this->link->GetName() + "_ned";
 
+  // The mounting poses of the model's links are stored once so that the
+  // sensors can resolve them without a TF listener
+  StaticTransformCache::Get(this->world)->AddModel(this->model);
+
   this->InitBasePlugin(_sdf);
 
-  // Bind the sensor update callback function to the world update event
-  this->updateConnection = event::Events::ConnectWorldUpdateBegin(
-      boost::bind(&ROSBasePlugin::OnUpdate, this, _1));
+  // Instead of a world update callback per sensor, the sensors of the world
+  // share one that only calls the sensors which are due
+  this->scheduler = SensorScheduler::Get(this->world);
+  this->schedulerId = this->scheduler->Add(
+    this->updateRate > 0 ? 1.0 / this->updateRate : 0.0,
+    boost::bind(&ROSBasePlugin::OnUpdate, this, _1));
 }
 
 /////////////////////////////////////////////////
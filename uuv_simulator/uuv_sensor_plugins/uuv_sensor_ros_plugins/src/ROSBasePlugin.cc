@@ -14,6 +14,7 @@
 // limitations under the License.
 
 #include <uuv_sensor_ros_plugins/ROSBasePlugin.hh>
+#include <ignition/math/Rand.hh>
 
 namespace gazebo
 {
@@ -25,17 +26,18 @@ ROSBasePlugin::ROSBasePlugin()
   this->referenceFrameID = "world";
   this->isReferenceInit = false;
   this->isOn.data = true;
+  this->publishedState = -1;
   this->world = NULL;
   this->referenceLink = NULL;
-
-  // Set seed for the noise generator
-  unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
-  this->rndGen = std::default_random_engine(seed);
+  this->defaultNoiseModel = -1;
+  this->referenceWatchId = -1;
 }
 
 /////////////////////////////////////////////////
 ROSBasePlugin::~ROSBasePlugin()
 {
+  if (this->transformCache)
+    this->transformCache->Unwatch(this->referenceWatchId);
   if (this->rosNode)
     this->rosNode->shutdown();
   if (this->updateConnection)
@@ -86,17 +88,17 @@ bool ROSBasePlugin::InitBasePlugin(sdf::ElementPtr _sdf)
       this->referenceFrameID, "world");
     gzmsg << "Static reference frame=" << this->referenceFrameID << std::endl;
     this->referenceLink = NULL;
-    // In case the reference frame provide is different from world, then
-    // subscribe to the tf_static topic to acquire the pose of the reference
-    // frame.
-    if (this->referenceFrameID.compare("world") != 0)
-    {
-      this->tfStaticSub = this->rosNode->subscribe<tf::tfMessage>(
-        "/tf_static", 1,
-        boost::bind(&ROSBasePlugin::GetTFMessage, this, _1));
-    }
-    else
-      this->isReferenceInit = true;
+    // The pose of the reference frame is taken from the fixed frames known
+    // to the simulation, the cache only falls back to /tf_static for frames
+    // it does not know
+    this->transformCache = StaticTransformCache::Get(this->world);
+    this->referenceWatchId = this->transformCache->Watch(
+      this->referenceFrameID,
+      [this](const ignition::math::Pose3d &_pose)
+      {
+        this->referenceFrame = _pose;
+        this->isReferenceInit = true;
+      });
   }
   else if (_sdf->HasElement("reference_link_name"))
   {
@@ -129,7 +131,8 @@ bool ROSBasePlugin::InitBasePlugin(sdf::ElementPtr _sdf)
     &ROSBasePlugin::ChangeSensorState, this);
 
   this->pluginStatePub = this->rosNode->advertise<std_msgs::Bool>(
-    this->sensorOutputTopic + "/state", 1);
+    this->sensorOutputTopic + "/state", 1, true);
+  this->PublishState();
 
   GetSDFParam<double>(_sdf, "noise_sigma", this->noiseSigma, 0.0);
   GZ_ASSERT(this->noiseSigma >= 0.0,
@@ -139,37 +142,21 @@ bool ROSBasePlugin::InitBasePlugin(sdf::ElementPtr _sdf)
   GZ_ASSERT(this->noiseAmp >= 0.0,
     "Signal noise amplitude must be greater or equal to zero");
 
+  // Each plugin draws from its own stream. Unless set explicitly, the seed
+  // is derived from the world seed (gzserver --seed) and the sensor's topic,
+  // so runs can be reproduced without the sensors' noise being correlated.
+  int noiseSeed;
+  if (GetSDFParam<int>(_sdf, "noise_seed", noiseSeed, 0))
+    this->noise.Seed(noiseSeed);
+  else
+    this->noise.Seed(NoiseGenerator::StreamSeed(
+      ignition::math::Rand::Seed(),
+      this->robotNamespace + "/" + this->sensorOutputTopic));
+
   // Add a default Gaussian noise model
   this->AddNoiseModel("default", this->noiseSigma);
-}
-
-/////////////////////////////////////////////////
-void ROSBasePlugin::GetTFMessage(const tf::tfMessage::ConstPtr &_msg)
-{
-  if (this->isReferenceInit)
-    return;
-
-  if (_msg->transforms.size() > 0)
-  {
-    for (auto t : _msg->transforms)
-    {
-      if (!t.header.frame_id.compare("world") &&
-        !t.child_frame_id.compare(this->referenceFrameID))
-      {
-        this->referenceFrame.Pos() = ignition::math::Vector3d(
-          t.transform.translation.x,
-          t.transform.translation.y,
-          t.transform.translation.z);
-
-        this->referenceFrame.Rot() = ignition::math::Quaterniond(
-          t.transform.rotation.w,
-          t.transform.rotation.x,
-          t.transform.rotation.y,
-          t.transform.rotation.z);
-        this->isReferenceInit = true;
-      }
-    }
-  }
+  this->defaultNoiseModel = this->noiseModels["default"];
+  return true;
 }
 
 /////////////////////////////////////////////////
@@ -187,19 +174,23 @@ bool ROSBasePlugin::ChangeSensorState(
     message += " OFF";
   _res.message = message;
   gzmsg << message << std::endl;
+  this->PublishState();
   return true;
 }
 
 /////////////////////////////////////////////////
 void ROSBasePlugin::PublishState()
 {
+  if (this->publishedState == static_cast<int>(this->isOn.data))
+    return;
+  this->publishedState = this->isOn.data;
   this->pluginStatePub.publish(this->isOn);
 }
 
 /////////////////////////////////////////////////
 double ROSBasePlugin::GetGaussianNoise(double _amp)
 {
-  return _amp * this->noiseModels["default"](this->rndGen);
+  return this->noise.Sample(this->defaultNoiseModel, _amp);
 }
 
 /////////////////////////////////////////////////
@@ -207,7 +198,7 @@ double ROSBasePlugin::GetGaussianNoise(std::string _name, double _amp)
 {
   GZ_ASSERT(this->noiseModels.count(_name),
     "Gaussian noise model does not exist");
-  return _amp * this->noiseModels[_name](this->rndGen);
+  return this->noise.Sample(this->noiseModels[_name], _amp);
 }
 
 /////////////////////////////////////////////////
@@ -217,7 +208,7 @@ bool ROSBasePlugin::AddNoiseModel(std::string _name, double _sigma)
   if (this->noiseModels.count(_name))
     return false;
 
-  this->noiseModels[_name] = std::normal_distribution<double>(0.0, _sigma);
+  this->noiseModels[_name] = this->noise.AddWhite(_sigma);
   return true;
 }
 
@@ -232,7 +223,9 @@ bool ROSBasePlugin::EnableMeasurement(const common::UpdateInfo& _info) const
 {
     common::Time current_time  = _info.simTime;
     double dt = (current_time - this->lastMeasurementTime).Double();
-    return dt >= 1.0 / this->updateRate && this->isReferenceInit &&
+    // The tolerance keeps a sensor called exactly one period after its last
+    // measurement, as the scheduler does, from skipping a period to rounding
+    return dt >= 1.0 / this->updateRate - 1e-6 && this->isReferenceInit &&
       this->isOn.data;
 }
 
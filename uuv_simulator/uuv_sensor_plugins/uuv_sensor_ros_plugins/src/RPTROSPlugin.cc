@@ -19,11 +19,21 @@ namespace gazebo
 {
 /////////////////////////////////////////////////
 RPTROSPlugin::RPTROSPlugin() : ROSBaseModelPlugin()
-{ }
+{
+  this->channelSender = -1;
+  this->processingDelay = 0.0;
+  this->dropoutProbability = 0.0;
+  this->multipathProbability = 0.0;
+  this->maxRange = 0.0;
+}
 
 /////////////////////////////////////////////////
 RPTROSPlugin::~RPTROSPlugin()
-{ }
+{
+  // Fixes still travelling are not delivered to a removed sensor
+  if (this->channel)
+    this->channel->RemoveSender(this->channelSender);
+}
 
 /////////////////////////////////////////////////
 void RPTROSPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
@@ -36,6 +46,37 @@ void RPTROSPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
 
   this->rosMessage.pos.covariance[0] = this->rosMessage.pos.covariance[4] =
       this->rosMessage.pos.covariance[8] = variance;
+  this->rosMessage.header.frame_id = this->referenceFrameID;
+
+  // The fixes travel through the acoustic channel shared by all acoustic
+  // sensors of the world. The speed of sound and the surface height are
+  // properties of the world, they are only changed if given.
+  this->channel = AcousticChannel::Get(this->world);
+  this->channelSender = this->channel->AddSender();
+
+  double soundSpeed;
+  if (GetSDFParam<double>(_sdf, "sound_speed", soundSpeed, 1500.0))
+    this->channel->SetSoundSpeed(soundSpeed);
+  double surfaceHeight;
+  if (GetSDFParam<double>(_sdf, "surface_height", surfaceHeight, 0.0))
+    this->channel->SetSurfaceHeight(surfaceHeight);
+
+  GetSDFParam<ignition::math::Vector3d>(_sdf, "beacon_position",
+    this->beaconPosition, ignition::math::Vector3d::Zero);
+  GetSDFParam<double>(_sdf, "processing_delay", this->processingDelay, 0.0);
+  GZ_ASSERT(this->processingDelay >= 0.0,
+    "Processing delay must be greater or equal to zero");
+  GetSDFParam<double>(_sdf, "dropout_probability", this->dropoutProbability,
+    0.0);
+  GZ_ASSERT(this->dropoutProbability >= 0.0 &&
+    this->dropoutProbability <= 1.0, "Invalid dropout probability");
+  GetSDFParam<double>(_sdf, "multipath_probability",
+    this->multipathProbability, 0.0);
+  GZ_ASSERT(this->multipathProbability >= 0.0 &&
+    this->multipathProbability <= 1.0, "Invalid multipath probability");
+  GetSDFParam<double>(_sdf, "max_range", this->maxRange, 0.0);
+  GZ_ASSERT(this->maxRange >= 0.0,
+    "Maximum range must be greater or equal to zero");
 
   // Initialize the default RPT output
   this->rosSensorOutputPub =
@@ -48,73 +89,126 @@ void RPTROSPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
     this->gazeboSensorOutputPub =
       this->gazeboNode->Advertise<sensor_msgs::msgs::Rpt>(
         this->robotNamespace + "/" + this->sensorOutputTopic, 1);
+
+    // Prepare constant covariance part of message
+    for (int i = 0 ; i < 9; i++)
+    {
+      if (i == 0 || i == 4 || i == 8)
+        this->gazeboMessage.add_position_covariance(variance);
+      else
+        this->gazeboMessage.add_position_covariance(0.0);
+    }
   }
 }
 
 /////////////////////////////////////////////////
 bool RPTROSPlugin::OnUpdate(const common::UpdateInfo& _info)
 {
-  // Publish sensor state
-  this->PublishState();
-
   if (!this->EnableMeasurement(_info))
     return false;
 
-  // True position
-  // TODO This is a temporary implementation, next step includes making
-  // plugins for acoustic channels and beacons
+  // The beacon pings at the update rate and the transponder replies when
+  // the ping reaches it. The transponder moves little while the ping is
+  // travelling, so its current position gives the travel time.
+  double pingTime = _info.simTime.Double();
+  this->lastMeasurementTime = _info.simTime;
+
+  ignition::math::Vector3d transponder;
 #if GAZEBO_MAJOR_VERSION >= 8
-  this->position = this->link->WorldPose().Pos();
+  transponder = this->link->WorldPose().Pos();
 #else
-  this->position = this->link->GetWorldPose().Ign().Pos();
+  transponder = this->link->GetWorldPose().Ign().Pos();
 #endif
-
   this->UpdateReferenceFramePose();
-  if (this->referenceLink)
-  {
+  ignition::math::Vector3d beacon =
+    this->referenceFrame.CoordPositionAdd(this->beaconPosition);
+
+  double replyTime = pingTime + this->channel->TravelTime(
+    AcousticChannel::DirectPath(beacon, transponder));
+  this->channel->Send(this->channelSender, replyTime,
+    [this, replyTime]()
+    {
+      this->Reply(replyTime);
+    });
+  return true;
+}
+
+/////////////////////////////////////////////////
+void RPTROSPlugin::Reply(double _replyTime)
+{
+  // The fix is the position of the transponder when it replies
+  ignition::math::Vector3d transponder;
 #if GAZEBO_MAJOR_VERSION >= 8
-    this->referenceFrame = this->referenceLink->WorldPose();
+  transponder = this->link->WorldPose().Pos();
 #else
-    this->referenceFrame = this->referenceLink->GetWorldPose().Ign();
+  transponder = this->link->GetWorldPose().Ign().Pos();
 #endif
+  this->UpdateReferenceFramePose();
+  ignition::math::Vector3d beacon =
+    this->referenceFrame.CoordPositionAdd(this->beaconPosition);
+
+  double direct = AcousticChannel::DirectPath(beacon, transponder);
+  if (this->maxRange > 0.0 && direct > this->maxRange)
+    return;
+  if (this->dropoutProbability > 0.0 &&
+    this->noise.Uniform() < this->dropoutProbability)
+    return;
+
+  // Position wrt the beacon, in the axes of the reference frame
+  ignition::math::Vector3d offset =
+    this->referenceFrame.Rot().RotateVectorReverse(
+      transponder - this->referenceFrame.Pos()) - this->beaconPosition;
+
+  // A reply over the surface reflected path keeps the bearing but gives
+  // the range of the longer path
+  double reply = direct;
+  if (this->multipathProbability > 0.0 &&
+    this->noise.Uniform() < this->multipathProbability)
+  {
+    reply = this->channel->SurfacePath(transponder, beacon);
+    if (direct > 0.0)
+      offset *= reply / direct;
   }
 
-  this->position = this->position - this->referenceFrame.Pos();
-  this->position = this->referenceFrame.Rot().RotateVectorReverse(
-    this->position);
-
+  this->position = this->beaconPosition + offset;
   this->position.X() += this->GetGaussianNoise(this->noiseAmp);
   this->position.Y() += this->GetGaussianNoise(this->noiseAmp);
   this->position.Z() += this->GetGaussianNoise(this->noiseAmp);
 
-  this->rosMessage.header.stamp = ros::Time::now();
-  this->rosMessage.header.frame_id = this->referenceFrameID;
-  this->rosMessage.pos.pos.x = this->position.X();
-  this->rosMessage.pos.pos.y = this->position.Y();
-  this->rosMessage.pos.pos.z = this->position.Z();
+  // The fix is available once the reply reached the beacon and was
+  // processed
+  double arrival = _replyTime + this->channel->TravelTime(reply) +
+    this->processingDelay;
+  ignition::math::Vector3d fix = this->position;
+  this->channel->Send(this->channelSender, arrival,
+    [this, _replyTime, fix]()
+    {
+      this->PublishFix(_replyTime, fix);
+    });
+}
+
+/////////////////////////////////////////////////
+void RPTROSPlugin::PublishFix(double _stamp,
+  const ignition::math::Vector3d &_position)
+{
+  if (!this->IsOn())
+    return;
+
+  this->rosMessage.header.stamp = ros::Time(_stamp);
+  this->rosMessage.pos.pos.x = _position.X();
+  this->rosMessage.pos.pos.y = _position.Y();
+  this->rosMessage.pos.pos.z = _position.Z();
 
   this->rosSensorOutputPub.publish(this->rosMessage);
 
   if (this->gazeboMsgEnabled)
   {
-    sensor_msgs::msgs::Rpt gazeboMessage;
-    double variance = this->noiseSigma * this->noiseSigma;
-    // Prepare constant covariance part of message
-    for (int i = 0 ; i < 9; i++)
-    {
-      if (i == 0 || i == 4 || i == 8)
-        gazeboMessage.add_position_covariance(variance);
-      else
-        gazeboMessage.add_position_covariance(0.0);
-    }
     // Publish simulated measurement
-    gazebo::msgs::Vector3d * p = new gazebo::msgs::Vector3d();
-    p->set_x(this->position.X());
-    p->set_y(this->position.Y());
-    p->set_z(this->position.Z());
-
-    gazeboMessage.set_allocated_position(p);
-    this->gazeboSensorOutputPub->Publish(gazeboMessage);
+    gazebo::msgs::Vector3d *p = this->gazeboMessage.mutable_position();
+    p->set_x(_position.X());
+    p->set_y(_position.Y());
+    p->set_z(_position.Z());
+    this->gazeboSensorOutputPub->Publish(this->gazeboMessage);
   }
 }
 
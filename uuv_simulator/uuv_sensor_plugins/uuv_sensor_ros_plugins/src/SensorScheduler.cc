@@ -0,0 +1,203 @@
+// Copyright (c) 2016 The UUV Simulator Authors.
+// All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <uuv_sensor_ros_plugins/SensorScheduler.hh>
+#include <algorithm>
+#include <cmath>
+
+namespace gazebo
+{
+/// \brief Number of slots of the timing wheel
+static const size_t kWheelSize = 1024;
+
+/// \brief Fraction of a step by which times may be off the step grid due
+/// to rounding
+static const double kTickSlack = 1e-3;
+
+std::map<std::string, std::weak_ptr<SensorScheduler>>
+  SensorScheduler::schedulers;
+
+std::mutex SensorScheduler::schedulersMutex;
+
+/////////////////////////////////////////////////
+std::shared_ptr<SensorScheduler> SensorScheduler::Get(
+  physics::WorldPtr _world)
+{
+  GZ_ASSERT(_world != NULL, "World object not available");
+#if GAZEBO_MAJOR_VERSION >= 8
+  std::string worldName = _world->Name();
+#else
+  std::string worldName = _world->GetName();
+#endif
+
+  std::lock_guard<std::mutex> lock(schedulersMutex);
+  std::shared_ptr<SensorScheduler> scheduler =
+    schedulers[worldName].lock();
+  if (!scheduler)
+  {
+    scheduler.reset(new SensorScheduler(_world));
+    schedulers[worldName] = scheduler;
+  }
+  return scheduler;
+}
+
+/////////////////////////////////////////////////
+SensorScheduler::SensorScheduler(physics::WorldPtr _world)
+  : world(_world), wheel(kWheelSize), nextId(0)
+{
+#if GAZEBO_MAJOR_VERSION >= 8
+  this->Init(this->world->Physics()->GetMaxStepSize(),
+    this->world->SimTime().Double());
+#else
+  this->Init(this->world->GetPhysicsEngine()->GetMaxStepSize(),
+    this->world->GetSimTime().Double());
+#endif
+
+  this->updateConnection = event::Events::ConnectWorldUpdateBegin(
+    std::bind(&SensorScheduler::Update, this, std::placeholders::_1));
+}
+
+/////////////////////////////////////////////////
+SensorScheduler::SensorScheduler(double _stepSize, double _time)
+  : wheel(kWheelSize), nextId(0)
+{
+  this->Init(_stepSize, _time);
+}
+
+/////////////////////////////////////////////////
+void SensorScheduler::Init(double _stepSize, double _time)
+{
+  this->tick = _stepSize > 0.0 ? _stepSize : 0.001;
+  this->lastTime = _time;
+  this->lastTick = this->NowTick(this->lastTime);
+}
+
+/////////////////////////////////////////////////
+SensorScheduler::~SensorScheduler()
+{
+  this->updateConnection.reset();
+}
+
+/////////////////////////////////////////////////
+int SensorScheduler::Add(double _period, const Callback &_callback)
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  int id = this->nextId++;
+  Entry &entry = this->entries[id];
+  entry.period = std::max(_period, 0.0);
+  entry.callback = _callback;
+  this->Insert(id, this->lastTime + entry.period);
+  return id;
+}
+
+/////////////////////////////////////////////////
+void SensorScheduler::Remove(int _id)
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  this->entries.erase(_id);
+}
+
+/////////////////////////////////////////////////
+size_t SensorScheduler::Size()
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  return this->entries.size();
+}
+
+/////////////////////////////////////////////////
+int64_t SensorScheduler::DueTick(double _time) const
+{
+  return static_cast<int64_t>(std::ceil(_time / this->tick - kTickSlack));
+}
+
+/////////////////////////////////////////////////
+int64_t SensorScheduler::NowTick(double _time) const
+{
+  return static_cast<int64_t>(std::floor(_time / this->tick + kTickSlack));
+}
+
+/////////////////////////////////////////////////
+void SensorScheduler::Insert(int _id, double _due)
+{
+  this->entries[_id].due = _due;
+  int64_t tick = std::max(this->DueTick(_due), this->lastTick + 1);
+  this->wheel[static_cast<size_t>(tick) % kWheelSize].push_back(_id);
+}
+
+/////////////////////////////////////////////////
+void SensorScheduler::Rebuild(double _now)
+{
+  for (auto &slot : this->wheel)
+    slot.clear();
+  for (auto &entry : this->entries)
+    this->Insert(entry.first,
+      std::min(entry.second.due, _now + entry.second.period));
+}
+
+/////////////////////////////////////////////////
+void SensorScheduler::Update(const common::UpdateInfo &_info)
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  double now = _info.simTime.Double();
+  int64_t nowTick = this->NowTick(now);
+
+  // The world was reset, nothing may stay due in the old time line
+  if (now < this->lastTime)
+  {
+    this->lastTick = nowTick - 1;
+    this->Rebuild(now);
+  }
+
+  // Visit the slots of the steps since the last update, the whole wheel at
+  // most. After a time jump of a full turn or more every slot is visited
+  // once, so overdue entries run now instead of a turn later. Entries of a
+  // later turn of the wheel stay where they are.
+  int64_t first = std::max(this->lastTick + 1,
+    nowTick - static_cast<int64_t>(kWheelSize) + 1);
+  this->dueIds.clear();
+  for (int64_t t = first; t <= nowTick; ++t)
+  {
+    std::vector<int> &slot = this->wheel[static_cast<size_t>(t) % kWheelSize];
+    size_t kept = 0;
+    for (size_t k = 0; k < slot.size(); ++k)
+    {
+      auto entry = this->entries.find(slot[k]);
+      if (entry == this->entries.end())
+        continue;
+      if (this->DueTick(entry->second.due) <= nowTick)
+        this->dueIds.push_back(slot[k]);
+      else
+        slot[kept++] = slot[k];
+    }
+    slot.resize(kept);
+  }
+  this->lastTime = now;
+  this->lastTick = nowTick;
+
+  for (int id : this->dueIds)
+  {
+    auto entry = this->entries.find(id);
+    if (entry == this->entries.end())
+      continue;
+    // Counted from now, as EnableMeasurement() compares against the time
+    // of the last measurement
+    this->Insert(id, now + entry->second.period);
+
+    // A copy, the callback may remove its own entry
+    Callback callback = entry->second.callback;
+    callback(_info);
+  }
+}
+}
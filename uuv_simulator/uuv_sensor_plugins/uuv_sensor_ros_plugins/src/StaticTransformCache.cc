@@ -0,0 +1,248 @@
+// Copyright (c) 2016 The UUV Simulator Authors.
+// All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <uuv_sensor_ros_plugins/StaticTransformCache.hh>
+#include <boost/bind.hpp>
+#include <cmath>
+
+namespace gazebo
+{
+/// \brief Suffix of the NED frame IDs
+static const std::string kNEDSuffix = "_ned";
+
+/// \brief Strips the leading slash of old style TF frame IDs
+static std::string FrameKey(const std::string &_frame)
+{
+  if (!_frame.empty() && _frame[0] == '/')
+    return _frame.substr(1);
+  return _frame;
+}
+
+std::map<std::string, std::weak_ptr<StaticTransformCache>>
+  StaticTransformCache::caches;
+
+std::mutex StaticTransformCache::cachesMutex;
+
+/////////////////////////////////////////////////
+std::shared_ptr<StaticTransformCache> StaticTransformCache::Get(
+  physics::WorldPtr _world)
+{
+  GZ_ASSERT(_world != NULL, "World object not available");
+#if GAZEBO_MAJOR_VERSION >= 8
+  std::string worldName = _world->Name();
+#else
+  std::string worldName = _world->GetName();
+#endif
+
+  std::lock_guard<std::mutex> lock(cachesMutex);
+  std::shared_ptr<StaticTransformCache> cache = caches[worldName].lock();
+  if (!cache)
+  {
+    cache.reset(new StaticTransformCache());
+    caches[worldName] = cache;
+  }
+  return cache;
+}
+
+/////////////////////////////////////////////////
+StaticTransformCache::StaticTransformCache() : nextId(0)
+{
+}
+
+/////////////////////////////////////////////////
+StaticTransformCache::~StaticTransformCache()
+{
+  this->tfStaticSub.shutdown();
+  this->rosNode.reset();
+}
+
+/////////////////////////////////////////////////
+void StaticTransformCache::AddModel(physics::ModelPtr _model)
+{
+  GZ_ASSERT(_model != NULL, "Model object not available");
+  std::lock_guard<std::mutex> lock(this->mutex);
+  if (!this->models.insert(_model->GetScopedName()).second)
+    return;
+
+  for (physics::LinkPtr link : _model->GetLinks())
+  {
+#if GAZEBO_MAJOR_VERSION >= 8
+    ignition::math::Pose3d pose = link->WorldPose();
+#else
+    ignition::math::Pose3d pose = link->GetWorldPose().Ign();
+#endif
+    this->frames[link->GetName()] = pose;
+    this->frames[link->GetScopedName()] = pose;
+    this->linkFrames.insert(link->GetName());
+    this->linkFrames.insert(link->GetScopedName());
+  }
+}
+
+/////////////////////////////////////////////////
+void StaticTransformCache::Set(const std::string &_frame,
+  const ignition::math::Pose3d &_pose)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->frames[FrameKey(_frame)] = _pose;
+}
+
+/////////////////////////////////////////////////
+bool StaticTransformCache::Lookup(const std::string &_frame,
+  ignition::math::Pose3d &_pose)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->Find(FrameKey(_frame), _pose);
+}
+
+/////////////////////////////////////////////////
+bool StaticTransformCache::Relative(const std::string &_target,
+  const std::string &_source, ignition::math::Pose3d &_pose)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  ignition::math::Pose3d target, source;
+  if (!this->Find(FrameKey(_target), target) ||
+    !this->Find(FrameKey(_source), source))
+    return false;
+  _pose = source - target;
+  return true;
+}
+
+/////////////////////////////////////////////////
+int StaticTransformCache::Watch(const std::string &_frame,
+  const Callback &_callback)
+{
+  ignition::math::Pose3d pose;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (!this->Find(FrameKey(_frame), pose))
+    {
+      int id = this->nextId++;
+      this->watchers[id].frame = FrameKey(_frame);
+      this->watchers[id].callback = _callback;
+
+      // Transforms are only needed from /tf_static if the simulation does
+      // not know a frame, so the subscription is made on demand
+      if (!this->rosNode && ros::isInitialized())
+      {
+        this->rosNode.reset(new ros::NodeHandle());
+        this->tfStaticSub = this->rosNode->subscribe<tf::tfMessage>(
+          "/tf_static", 10,
+          boost::bind(&StaticTransformCache::OnTFStatic, this, _1));
+      }
+      return id;
+    }
+  }
+  _callback(pose);
+  return -1;
+}
+
+/////////////////////////////////////////////////
+void StaticTransformCache::Unwatch(int _id)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->watchers.erase(_id);
+}
+
+/////////////////////////////////////////////////
+bool StaticTransformCache::Find(const std::string &_frame,
+  ignition::math::Pose3d &_pose) const
+{
+  auto it = this->frames.find(_frame);
+  if (it != this->frames.end())
+  {
+    _pose = it->second;
+    return true;
+  }
+
+  if (_frame == "world")
+  {
+    _pose = ignition::math::Pose3d::Zero;
+    return true;
+  }
+
+  // The local NED frame of a link is the link turned upside down around its
+  // x axis, see ROSBaseModelPlugin. Other NED frames such as world_ned are
+  // not derived, they are defined by whoever publishes them.
+  if (_frame.size() > kNEDSuffix.size() &&
+    _frame.compare(_frame.size() - kNEDSuffix.size(), kNEDSuffix.size(),
+      kNEDSuffix) == 0)
+  {
+    std::string base = _frame.substr(0, _frame.size() - kNEDSuffix.size());
+    if (!this->linkFrames.count(base))
+      return false;
+    _pose = ignition::math::Pose3d(0, 0, 0, M_PI, 0, 0) +
+      this->frames.at(base);
+    return true;
+  }
+  return false;
+}
+
+/////////////////////////////////////////////////
+void StaticTransformCache::OnTFStatic(const tf::tfMessage::ConstPtr &_msg)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  ignition::math::Pose3d pose;
+  for (const geometry_msgs::TransformStamped &t : _msg->transforms)
+  {
+    std::string child = FrameKey(t.child_frame_id);
+    // The links of the simulation take precedence over published frames,
+    // published frames replace derived ones
+    if (this->linkFrames.count(child))
+      continue;
+
+    PendingTransform &transform = this->pending[child];
+    transform.parent = FrameKey(t.header.frame_id);
+    transform.pose.Pos() = ignition::math::Vector3d(
+      t.transform.translation.x,
+      t.transform.translation.y,
+      t.transform.translation.z);
+    transform.pose.Rot() = ignition::math::Quaterniond(
+      t.transform.rotation.w,
+      t.transform.rotation.x,
+      t.transform.rotation.y,
+      t.transform.rotation.z);
+  }
+
+  // Chain the transforms to the known frames until no more can be resolved,
+  // the messages do not need to be ordered from the root down
+  bool resolved = true;
+  while (resolved)
+  {
+    resolved = false;
+    for (auto it = this->pending.begin(); it != this->pending.end();)
+    {
+      if (this->Find(it->second.parent, pose))
+      {
+        this->frames[it->first] = it->second.pose + pose;
+        it = this->pending.erase(it);
+        resolved = true;
+      }
+      else
+        ++it;
+    }
+  }
+
+  for (auto it = this->watchers.begin(); it != this->watchers.end();)
+  {
+    if (this->Find(it->second.frame, pose))
+    {
+      it->second.callback(pose);
+      it = this->watchers.erase(it);
+    }
+    else
+      ++it;
+  }
+}
+}
@@ -52,9 +52,6 @@ void SubseaPressureROSPlugin::Load(physics::ModelPtr _model,
 /////////////////////////////////////////////////
 bool SubseaPressureROSPlugin::OnUpdate(const common::UpdateInfo& _info)
 {
-  // Publish sensor state
-  this->PublishState();
-
   if (!this->EnableMeasurement(_info))
     return false;
 
@@ -14,12 +14,108 @@
 // limitations under the License.
 
 #include <uuv_sensor_ros_plugins/UnderwaterCameraROSPlugin.hh>
+#include <algorithm>
+#include <cmath>
 
 namespace gazebo
 {
+/// \brief Number of entries of the transmittance LUT
+static const int kRangeLUTSize = 16384;
+
+/// \brief Transmittance below which a channel shows only the background,
+/// smaller than half an intensity level
+static const float kMinTransmittance = 1.f / 512.f;
+
+/// \brief Fixed point precision of the LUT entries [bits]
+static const int kLUTBits = 15;
+
+/// \brief Blends the rows of an image with the background according to the
+/// range of each pixel, run in parallel over blocks of rows
+class UnderwaterImageBody : public cv::ParallelLoopBody
+{
+  /// \brief Class constructor
+  public: UnderwaterImageBody(const cv::Mat &_input, const cv::Mat &_depth,
+    const cv::Mat &_scattered, cv::Mat &_output, const float *_depth2range,
+    const uint16_t *_lut, float _lutScale, const int *_background)
+    : input(_input), depth(_depth), scattered(_scattered), output(_output),
+      depth2range(_depth2range), lut(_lut), lutScale(_lutScale),
+      background(_background)
+  { }
+
+  /// \brief Processes the rows in _range
+  public: virtual void operator()(const cv::Range &_range) const
+  {
+    const int width = this->input.cols;
+    const bool scatter = !this->scattered.empty();
+    std::vector<int> index(width);
+
+    for (int row = _range.start; row < _range.end; row++)
+    {
+      const uint8_t *in = this->input.ptr<uint8_t>(row);
+      const uint8_t *blur = scatter ? this->scattered.ptr<uint8_t>(row) : in;
+      const float *depthRow = this->depth.ptr<float>(row);
+      const float *factorRow = this->depth2range + row * width;
+      uint8_t *out = this->output.ptr<uint8_t>(row);
+
+      // Quantize the ranges first, this loop vectorizes. Invalid depths
+      // (r < 1e-3) are infinitely far and map to the last entry.
+      for (int col = 0; col < width; col++)
+      {
+        float r = factorRow[col] * depthRow[col] * this->lutScale;
+        r = !(r >= 1e-3f * this->lutScale) ? kRangeLUTSize - 1.f : r;
+        index[col] = static_cast<int>(std::min(r, kRangeLUTSize - 1.f));
+      }
+
+      for (int col = 0; col < width; col++)
+      {
+        // Simplifying assumption: intensity ~ irradiance.
+        // This is not really the case but a good enough approximation
+        // for now (it would be better to use a proper Radiometric
+        // Response Function).
+        const uint16_t *t = this->lut + 4 * index[col];
+        for (int c = 0; c < 3; c++)
+        {
+          int v = in[3 * col + c];
+          // Forward scattered light replaces part of the direct light
+          v += ((blur[3 * col + c] - v) * t[3]) >> kLUTBits;
+          out[3 * col + c] = static_cast<uint8_t>((v * t[c] +
+            this->background[c] * ((1 << kLUTBits) - t[c]) +
+            (1 << (kLUTBits - 1))) >> kLUTBits);
+        }
+      }
+    }
+  }
+
+  /// \brief Input image (RGB)
+  private: const cv::Mat &input;
+
+  /// \brief Depth image
+  private: const cv::Mat &depth;
+
+  /// \brief Blurred input image, empty without forward scattering
+  private: const cv::Mat &scattered;
+
+  /// \brief Output image (RGB)
+  private: cv::Mat &output;
+
+  /// \brief Per pixel factor from depth to range
+  private: const float *depth2range;
+
+  /// \brief Transmittance LUT
+  private: const uint16_t *lut;
+
+  /// \brief Number of LUT entries per meter of range
+  private: float lutScale;
+
+  /// \brief Background color per channel (RGB)
+  private: const int *background;
+};
+
 /////////////////////////////////////////////////
 UnderwaterCameraROSPlugin::UnderwaterCameraROSPlugin()
-  : DepthCameraPlugin(), lastImage(NULL)
+  : DepthCameraPlugin(), lastImage(NULL), frontDepth(-1), depthPeriod(0.0),
+    depth2rangeLUT(NULL), forwardScatter(0.f), forwardScatterSigma(1.5f),
+    rangeLUTScale(1.f)
 { }
 
 /////////////////////////////////////////////////
@@ -83,6 +179,24 @@ void UnderwaterCameraROSPlugin::Load(sensors::SensorPtr _sensor,
   if (_sdf->HasElement("backgroundB"))
     this->background[2] = (unsigned char)_sdf->GetElement(
       "backgroundB")->Get<int>();
+
+  // Attenuation of the veiling light with depth, disabled by default
+  GetSDFParam<float>(_sdf, "backgroundDepthAttenuationR",
+    this->backgroundDepthAttenuation[0], 0.f);
+  GetSDFParam<float>(_sdf, "backgroundDepthAttenuationG",
+    this->backgroundDepthAttenuation[1], 0.f);
+  GetSDFParam<float>(_sdf, "backgroundDepthAttenuationB",
+    this->backgroundDepthAttenuation[2], 0.f);
+  for (int c = 0; c < 3; c++)
+    this->frameBackground[c] = this->background[c];
+
+  // Optional forward scattering, blurring the direct light with range
+  GetSDFParam<float>(_sdf, "forwardScatter", this->forwardScatter, 0.f);
+  GetSDFParam<float>(_sdf, "forwardScatterSigma", this->forwardScatterSigma,
+    1.5f);
+
+  this->UpdateTransmittanceLUT();
+
   // Compute camera intrinsics fx, fy from FOVs:
 #if GAZEBO_MAJOR_VERSION >= 7
   ignition::math::Angle hfov = ignition::math::Angle(this->depthCamera->HFOV().Radian());
@@ -122,8 +236,22 @@ void UnderwaterCameraROSPlugin::OnNewDepthFrame(const float *_image,
   unsigned int _width, unsigned int _height, unsigned int _depth,
   const std::string &_format)
 {
-    // TODO: Can we assume this pointer to always remain valid?
-    this->lastDepth = _image;
+  // The camera reuses its depth buffer for the next frame, keep a copy in
+  // the buffer the image callback is not reading
+  int back = this->frontDepth == 0 ? 1 : 0;
+  DepthFrame &frame = this->depthFrames[back];
+  frame.data.assign(_image, _image + _width * _height);
+  frame.stamp = this->RenderTime();
+
+  std::lock_guard<std::mutex> lock(this->depthMutex);
+  if (this->frontDepth >= 0)
+  {
+    double period =
+      (frame.stamp - this->depthFrames[this->frontDepth].stamp).Double();
+    if (period > 0.0)
+      this->depthPeriod = period;
+  }
+  this->frontDepth = back;
 }
 
 /////////////////////////////////////////////////
@@ -141,12 +269,28 @@ void UnderwaterCameraROSPlugin::OnNewImageFrame(const unsigned char *_image,
   // (neither allocates nor copies any images).
   const cv::Mat input(_height, _width, CV_8UC3,
     const_cast<unsigned char*>(_image));
-  const cv::Mat depth(_height, _width, CV_32FC1,
-    const_cast<float*>(lastDepth));
-
   cv::Mat output(_height, _width, CV_8UC3, lastImage);
 
-  this->SimulateUnderwater(input, depth, output);
+  {
+    // Holding the lock keeps the depth frame from being swapped out, the
+    // depth callback can still fill the back buffer meanwhile
+    std::lock_guard<std::mutex> lock(this->depthMutex);
+    if (this->frontDepth < 0)
+      return;
+
+    DepthFrame &frame = this->depthFrames[this->frontDepth];
+    if (frame.data.size() != _width * _height)
+      return;
+
+    // Drop the image if its depth is more than one frame off, rather than
+    // applying the effect with a stale depth map
+    double skew = std::fabs((this->RenderTime() - frame.stamp).Double());
+    if (skew > 1e-6 && skew > this->depthPeriod + 1e-6)
+      return;
+
+    const cv::Mat depth(_height, _width, CV_32FC1, frame.data.data());
+    this->SimulateUnderwater(input, depth, output);
+  }
 
   if (!this->initialized_ || this->height_ <= 0 || this->width_ <= 0)
     return;
@@ -173,39 +317,91 @@ void UnderwaterCameraROSPlugin::OnNewImageFrame(const unsigned char *_image,
 }
 
 /////////////////////////////////////////////////
-void UnderwaterCameraROSPlugin::SimulateUnderwater(const cv::Mat& _inputImage,
-  const cv::Mat& _inputDepth, cv::Mat& _outputImage)
+common::Time UnderwaterCameraROSPlugin::RenderTime() const
 {
-  const float * lutPtr = this->depth2rangeLUT;
-  for (unsigned int row = 0; row < this->height; row++)
-  {
-    const cv::Vec3b* inrow = _inputImage.ptr<cv::Vec3b>(row);
-    const float* depthrow = _inputDepth.ptr<float>(row);
-    cv::Vec3b* outrow = _outputImage.ptr<cv::Vec3b>(row);
+#if GAZEBO_MAJOR_VERSION >= 7
+  return this->depthCamera->GetScene()->SimTime();
+#else
+  return this->depthCamera->GetScene()->GetSimTime();
+#endif
+}
 
-    for (int col = 0; col < this->width; col++)
-    {
-      // Convert depth to range using the depth2range LUT
-      float r = *(lutPtr++)*depthrow[col];
-      const cv::Vec3b& in = inrow[col];
-      cv::Vec3b& out = outrow[col];
+/////////////////////////////////////////////////
+void UnderwaterCameraROSPlugin::UpdateTransmittanceLUT()
+{
+  // The table spans the ranges up to where every attenuated channel is
+  // below half an intensity level, the quantization error of the
+  // transmittance stays below an intensity level
+  float minAttenuation = 0.f;
+  for (int c = 0; c < 3; c++)
+    if (this->attenuation[c] > 0.f &&
+      (minAttenuation == 0.f || this->attenuation[c] < minAttenuation))
+      minAttenuation = this->attenuation[c];
 
-      if (r < 1e-3)
-        r = 1e10;
+  float maxRange = minAttenuation > 0.f ?
+    -std::log(kMinTransmittance) / minAttenuation : 1.f;
+  this->rangeLUTScale = (kRangeLUTSize - 1) / maxRange;
 
+  this->transmittanceLUT.resize(4 * kRangeLUTSize);
+  for (int i = 0; i < kRangeLUTSize; i++)
+  {
+    float r = i / this->rangeLUTScale;
+    for (int c = 0; c < 3; c++)
+      this->transmittanceLUT[4 * i + c] = static_cast<uint16_t>(
+        std::lround((1 << kLUTBits) * std::exp(-r * this->attenuation[c])));
+    // The last entry also stands for pixels without a valid depth
+    if (i == kRangeLUTSize - 1)
       for (int c = 0; c < 3; c++)
-      {
-        // Simplifying assumption: intensity ~ irradiance.
-        // This is not really the case but a good enough approximation
-        // for now (it would be better to use a proper Radiometric
-        // Response Function).
-        float e = std::exp(-r*attenuation[c]);
-        out[c] = e*in[c] + (1.0f-e)*background[c];
-      }
-    }
+        if (this->attenuation[c] > 0.f)
+          this->transmittanceLUT[4 * i + c] = 0;
+    this->transmittanceLUT[4 * i + 3] = static_cast<uint16_t>(
+      std::lround((1 << kLUTBits) *
+      (1.f - std::exp(-r * this->forwardScatter))));
   }
 }
 
+/////////////////////////////////////////////////
+void UnderwaterCameraROSPlugin::UpdateBackground()
+{
+  if (this->backgroundDepthAttenuation[0] == 0.f &&
+      this->backgroundDepthAttenuation[1] == 0.f &&
+      this->backgroundDepthAttenuation[2] == 0.f)
+    return;
+
+  // Less daylight reaches the water around the camera the deeper it is
+#if GAZEBO_MAJOR_VERSION >= 8
+  double z = this->depthCamera->WorldPosition().Z();
+#else
+  double z = this->depthCamera->GetWorldPosition().Ign().Z();
+#endif
+  double depth = std::max(0.0, -z);
+  for (int c = 0; c < 3; c++)
+    this->frameBackground[c] = static_cast<int>(std::lround(
+      this->background[c] *
+      std::exp(-depth * this->backgroundDepthAttenuation[c])));
+}
+
+/////////////////////////////////////////////////
+void UnderwaterCameraROSPlugin::SimulateUnderwater(const cv::Mat& _inputImage,
+  const cv::Mat& _inputDepth, cv::Mat& _outputImage)
+{
+  this->UpdateBackground();
+
+  if (this->forwardScatter > 0.f)
+    cv::GaussianBlur(_inputImage, this->scatteredImage, cv::Size(0, 0),
+      this->forwardScatterSigma);
+  else
+    this->scatteredImage.release();
+
+  // Per pixel, the range is quantized and the per-channel transmittance
+  // and scattered fraction are read from the LUT instead of calling
+  // std::exp, and the blending is done in fixed point
+  UnderwaterImageBody body(_inputImage, _inputDepth, this->scatteredImage,
+    _outputImage, this->depth2rangeLUT, this->transmittanceLUT.data(),
+    this->rangeLUTScale, this->frameBackground);
+  cv::parallel_for_(cv::Range(0, _inputImage.rows), body);
+}
+
 /////////////////////////////////////////////////
 GZ_REGISTER_SENSOR_PLUGIN(UnderwaterCameraROSPlugin)
 }
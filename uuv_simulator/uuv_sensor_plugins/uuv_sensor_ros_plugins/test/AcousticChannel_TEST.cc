@@ -0,0 +1,184 @@
+// Copyright (c) 2016 The UUV Simulator Authors.
+// All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+#include <uuv_sensor_ros_plugins/AcousticChannel.hh>
+
+/// \brief Physics step size of the tests [s]
+static const double kStep = 0.001;
+
+/// \brief Channel on a scheduler driven by the test instead of a world
+class AcousticChannelTest : public ::testing::Test
+{
+  protected: AcousticChannelTest()
+    : scheduler(std::make_shared<gazebo::SensorScheduler>(kStep, 0.0)),
+      channel(scheduler), now(0.0)
+  {}
+
+  /// \brief Runs the physics steps after the current time up to and
+  /// including _to
+  protected: void StepTo(double _to)
+  {
+    int steps = static_cast<int>(std::round((_to - this->now) / kStep));
+    double from = this->now;
+    for (int i = 1; i <= steps; i++)
+      this->UpdateAt(from + i * kStep);
+  }
+
+  /// \brief Runs a single update at _time
+  protected: void UpdateAt(double _time)
+  {
+    this->now = _time;
+    gazebo::common::UpdateInfo info;
+    info.simTime = gazebo::common::Time(_time);
+    this->scheduler->Update(info);
+  }
+
+  /// \brief Message recording its name and the time it was delivered at
+  protected: gazebo::AcousticChannel::Callback Record(
+    const std::string &_name)
+  {
+    return [this, _name]()
+    {
+      this->delivered.push_back(std::make_pair(_name, this->now));
+    };
+  }
+
+  /// \brief Checks the delivered messages and their delivery times
+  protected: void ExpectDelivered(
+    const std::vector<std::pair<std::string, double>> &_expected)
+  {
+    ASSERT_EQ(_expected.size(), this->delivered.size());
+    for (size_t i = 0; i < _expected.size(); i++)
+    {
+      EXPECT_EQ(_expected[i].first, this->delivered[i].first) << i;
+      EXPECT_NEAR(_expected[i].second, this->delivered[i].second, 1e-9)
+        << _expected[i].first;
+    }
+  }
+
+  protected: std::shared_ptr<gazebo::SensorScheduler> scheduler;
+  protected: gazebo::AcousticChannel channel;
+  protected: double now;
+  protected: std::vector<std::pair<std::string, double>> delivered;
+};
+
+TEST_F(AcousticChannelTest, DeliversInArrivalOrder)
+{
+  int a = this->channel.AddSender();
+  int b = this->channel.AddSender();
+
+  // Sent out of order, two arrive at the same time and one exactly at a
+  // physics step
+  this->channel.Send(a, 0.0105, this->Record("a1"));
+  this->channel.Send(b, 0.003, this->Record("b1"));
+  this->channel.Send(a, 0.020, this->Record("a2"));
+  this->channel.Send(a, 0.003, this->Record("a3"));
+  this->channel.Send(b, 0.0070001, this->Record("b2"));
+  // Due at the 10 ms step, but rounded to slightly after it
+  double rounded = 9 * kStep + this->channel.TravelTime(1.5);
+  ASSERT_GT(rounded, 10 * kStep);
+  this->channel.Send(b, rounded, this->Record("b3"));
+  EXPECT_EQ(6u, this->channel.Pending());
+
+  this->StepTo(0.005);
+  EXPECT_EQ(4u, this->channel.Pending());
+  this->StepTo(0.05);
+  EXPECT_EQ(0u, this->channel.Pending());
+
+  // Each message on the first step at or after its arrival, equal arrival
+  // times in the order of sending
+  this->ExpectDelivered({{"b1", 0.003}, {"a3", 0.003}, {"b2", 0.008},
+    {"b3", 0.010}, {"a1", 0.011}, {"a2", 0.020}});
+}
+
+TEST_F(AcousticChannelTest, MessagesSentOnDelivery)
+{
+  // A transponder replying to an interrogation: a reply already due is
+  // delivered in the same update, a later one when it arrives
+  int sender = this->channel.AddSender();
+  this->channel.Send(sender, 0.002, [this, sender]()
+  {
+    this->delivered.push_back(std::make_pair("ping", this->now));
+    this->channel.Send(sender, this->now, this->Record("echo"));
+    this->channel.Send(sender, this->now + 0.0045, this->Record("reply"));
+  });
+
+  this->StepTo(0.02);
+  this->ExpectDelivered({{"ping", 0.002}, {"echo", 0.002},
+    {"reply", 0.007}});
+}
+
+TEST_F(AcousticChannelTest, RemovedSenderDropsMessages)
+{
+  int a = this->channel.AddSender();
+  int b = this->channel.AddSender();
+  this->channel.Send(a, 0.004, this->Record("a1"));
+  this->channel.Send(b, 0.005, this->Record("b1"));
+  this->channel.Send(a, 0.006, this->Record("a2"));
+
+  this->StepTo(0.0045);
+  this->channel.RemoveSender(a);
+  this->StepTo(0.01);
+  this->ExpectDelivered({{"a1", 0.004}, {"b1", 0.005}});
+  EXPECT_EQ(0u, this->channel.Pending());
+
+  // IDs are not reused
+  EXPECT_NE(a, this->channel.AddSender());
+}
+
+TEST_F(AcousticChannelTest, WorldResetClearsQueue)
+{
+  int sender = this->channel.AddSender();
+  this->channel.Send(sender, 0.5, this->Record("before reset"));
+  this->StepTo(0.1);
+  EXPECT_EQ(1u, this->channel.Pending());
+
+  // Simulation time starts over, the message in flight is lost
+  this->UpdateAt(kStep);
+  EXPECT_EQ(0u, this->channel.Pending());
+
+  this->channel.Send(sender, 0.01, this->Record("after reset"));
+  this->StepTo(0.6);
+  this->ExpectDelivered({{"after reset", 0.01}});
+}
+
+TEST_F(AcousticChannelTest, Propagation)
+{
+  ignition::math::Vector3d from(0.0, 0.0, -30.0), to(40.0, 0.0, -60.0);
+  EXPECT_DOUBLE_EQ(50.0, gazebo::AcousticChannel::DirectPath(from, to));
+
+  // Mirror image of the source at +30 m, 40 m across and 90 m down
+  EXPECT_DOUBLE_EQ(std::sqrt(40.0 * 40.0 + 90.0 * 90.0),
+    this->channel.SurfacePath(from, to));
+  this->channel.SetSurfaceHeight(-10.0);
+  EXPECT_DOUBLE_EQ(std::sqrt(40.0 * 40.0 + 70.0 * 70.0),
+    this->channel.SurfacePath(from, to));
+
+  EXPECT_DOUBLE_EQ(0.1, this->channel.TravelTime(150.0));
+  this->channel.SetSoundSpeed(1450.0);
+  EXPECT_DOUBLE_EQ(0.1, this->channel.TravelTime(145.0));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
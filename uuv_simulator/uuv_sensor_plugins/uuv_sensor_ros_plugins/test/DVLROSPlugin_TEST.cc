@@ -0,0 +1,158 @@
+// Copyright (c) 2016 The UUV Simulator Authors.
+// All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+#include <uuv_sensor_ros_plugins/DVLROSPlugin.hh>
+
+/// \brief Unit vectors of a Janus DVL: four beams tilted by _tilt from the
+/// downward axis, 45 degrees off the vehicle axes
+std::vector<ignition::math::Vector3d> JanusBeams(double _tilt)
+{
+  std::vector<ignition::math::Vector3d> dirs;
+  for (int i = 0; i < 4; i++)
+  {
+    double azimuth = M_PI / 4.0 + i * M_PI / 2.0;
+    dirs.push_back(ignition::math::Vector3d(
+      std::sin(_tilt) * std::cos(azimuth),
+      std::sin(_tilt) * std::sin(azimuth),
+      -std::cos(_tilt)));
+  }
+  return dirs;
+}
+
+/// \brief Velocities measured along _dirs for a velocity _vel
+std::vector<double> Project(const std::vector<ignition::math::Vector3d> &_dirs,
+  const ignition::math::Vector3d &_vel)
+{
+  std::vector<double> beamVel;
+  for (const ignition::math::Vector3d &dir : _dirs)
+    beamVel.push_back(dir.Dot(_vel));
+  return beamVel;
+}
+
+TEST(DVLROSPlugin, InvertMatrix3)
+{
+  const double m[3][3] = {{4.0, 1.0, -2.0}, {0.5, 3.0, 1.0}, {-1.0, 2.0, 5.0}};
+  double inv[3][3];
+  ASSERT_TRUE(gazebo::DVLROSPlugin::InvertMatrix3(m, inv));
+  for (int r = 0; r < 3; r++)
+  {
+    for (int c = 0; c < 3; c++)
+    {
+      double product = 0.0;
+      for (int k = 0; k < 3; k++)
+        product += m[r][k] * inv[k][c];
+      EXPECT_NEAR(r == c ? 1.0 : 0.0, product, 1e-12) << r << ", " << c;
+    }
+  }
+
+  // Third row is the sum of the first two
+  const double singular[3][3] = {{1.0, 2.0, 3.0}, {0.0, 1.0, 4.0},
+    {1.0, 3.0, 7.0}};
+  EXPECT_FALSE(gazebo::DVLROSPlugin::InvertMatrix3(singular, inv));
+}
+
+TEST(DVLROSPlugin, SolveBeamVelocity)
+{
+  const double tilt = 30.0 * M_PI / 180.0;
+  const double sigma = 0.01;
+  std::vector<ignition::math::Vector3d> dirs = JanusBeams(tilt);
+  ignition::math::Vector3d vel(1.2, -0.3, 0.15);
+
+  // Consistent beams give back the velocity
+  ignition::math::Vector3d solved;
+  double cov[3][3];
+  ASSERT_TRUE(gazebo::DVLROSPlugin::SolveBeamVelocity(dirs,
+    Project(dirs, vel), sigma, solved, cov));
+  EXPECT_NEAR(vel.X(), solved.X(), 1e-12);
+  EXPECT_NEAR(vel.Y(), solved.Y(), 1e-12);
+  EXPECT_NEAR(vel.Z(), solved.Z(), 1e-12);
+
+  // sigma^2 (D^T D)^-1, diagonal for the Janus geometry
+  double s2 = sigma * sigma;
+  double sinT = std::sin(tilt), cosT = std::cos(tilt);
+  EXPECT_NEAR(s2 / (2.0 * sinT * sinT), cov[0][0], 1e-15);
+  EXPECT_NEAR(s2 / (2.0 * sinT * sinT), cov[1][1], 1e-15);
+  EXPECT_NEAR(s2 / (4.0 * cosT * cosT), cov[2][2], 1e-15);
+  EXPECT_NEAR(0.0, cov[0][1], 1e-15);
+  EXPECT_NEAR(0.0, cov[0][2], 1e-15);
+
+  // Inconsistent beams: the residual is orthogonal to all beam directions
+  std::vector<double> beamVel = Project(dirs, vel);
+  beamVel[0] += 0.05;
+  beamVel[3] -= 0.02;
+  ASSERT_TRUE(gazebo::DVLROSPlugin::SolveBeamVelocity(dirs, beamVel, sigma,
+    solved, cov));
+  ignition::math::Vector3d normalResidual;
+  for (size_t i = 0; i < dirs.size(); i++)
+    normalResidual += dirs[i] * (dirs[i].Dot(solved) - beamVel[i]);
+  EXPECT_NEAR(0.0, normalResidual.Length(), 1e-12);
+
+  // Three beams are enough, two or three in a plane are not
+  std::vector<ignition::math::Vector3d> three(dirs.begin(), dirs.begin() + 3);
+  EXPECT_TRUE(gazebo::DVLROSPlugin::SolveBeamVelocity(three,
+    Project(three, vel), sigma, solved, cov));
+  EXPECT_NEAR(vel.X(), solved.X(), 1e-12);
+  std::vector<ignition::math::Vector3d> two(dirs.begin(), dirs.begin() + 2);
+  EXPECT_FALSE(gazebo::DVLROSPlugin::SolveBeamVelocity(two,
+    Project(two, vel), sigma, solved, cov));
+  std::vector<ignition::math::Vector3d> planar = {
+    ignition::math::Vector3d::UnitX, ignition::math::Vector3d::UnitY,
+    ignition::math::Vector3d(std::sqrt(0.5), std::sqrt(0.5), 0.0)};
+  EXPECT_FALSE(gazebo::DVLROSPlugin::SolveBeamVelocity(planar,
+    Project(planar, vel), sigma, solved, cov));
+}
+
+TEST(DVLROSPlugin, BeamNoisePropagation)
+{
+  // Independent noise on every beam before the solution gives a velocity
+  // error with the reported covariance
+  const double sigma = 0.02;
+  const int n = 40000;
+  std::vector<ignition::math::Vector3d> dirs = JanusBeams(25.0 * M_PI / 180.0);
+  ignition::math::Vector3d vel(0.5, 0.1, -0.05);
+  std::mt19937 rng(5);
+  std::normal_distribution<double> normal(0.0, sigma);
+
+  ignition::math::Vector3d solved;
+  double cov[3][3], sum[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+  for (int k = 0; k < n; k++)
+  {
+    std::vector<double> beamVel = Project(dirs, vel);
+    for (double &v : beamVel)
+      v += normal(rng);
+    ASSERT_TRUE(gazebo::DVLROSPlugin::SolveBeamVelocity(dirs, beamVel,
+      sigma, solved, cov));
+    ignition::math::Vector3d err = solved - vel;
+    for (int r = 0; r < 3; r++)
+      for (int c = 0; c < 3; c++)
+        sum[r][c] += err[r] * err[c];
+  }
+  for (int r = 0; r < 3; r++)
+  {
+    // Variance estimate within about five standard errors
+    EXPECT_NEAR(cov[r][r], sum[r][r] / n, 5.0 * cov[r][r] * std::sqrt(2.0 / n))
+      << "axis " << r;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,441 @@
+// Copyright (c) 2016 The UUV Simulator Authors.
+// All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+#include <uuv_sensor_ros_plugins/IMUROSPlugin.hh>
+
+/// \brief Link state read by the IMU on one update
+struct LinkState
+{
+  ignition::math::Pose3d pose;
+  ignition::math::Vector3d angVel;
+  ignition::math::Vector3d linAcc;
+};
+
+/// \brief Noise of the IMU as the plugin added it on every update before,
+/// with the discretization recomputed and the models looked up by name
+class OldIMUNoise
+{
+  public: void Apply(ignition::math::Vector3d& _linAcc,
+                     ignition::math::Vector3d& _angVel,
+                     ignition::math::Quaterniond& _orientation, double _dt,
+                     const gazebo::IMUParameters& _params, double _noiseAmp)
+  {
+    double tauG = _params.gyroscopeBiasCorrelationTime;
+    double sigmaGD = 1 / sqrt(_dt) * _params.gyroscopeNoiseDensity;
+    double sigmaBG = _params.gyroscopeRandomWalk;
+    double sigmaBGD = sqrt(- sigmaBG * sigmaBG * tauG / 2.0 *
+      (exp(-2.0 * _dt / tauG) - 1.0));
+    double phiGD = exp(-1.0 / tauG * _dt);
+    this->AddNoiseModel("bgd", sigmaBGD);
+    this->AddNoiseModel("gd", sigmaGD);
+    this->gyroscopeBias = phiGD * this->gyroscopeBias +
+      ignition::math::Vector3d(this->Gaussian("bgd", _noiseAmp),
+        this->Gaussian("bgd", _noiseAmp), this->Gaussian("bgd", _noiseAmp));
+    _angVel = _angVel + this->gyroscopeBias +
+      ignition::math::Vector3d(this->Gaussian("gd", _noiseAmp),
+        this->Gaussian("gd", _noiseAmp), this->Gaussian("gd", _noiseAmp));
+
+    double tauA = _params.accelerometerBiasCorrelationTime;
+    double sigmaAD = 1. / sqrt(_dt) * _params.accelerometerNoiseDensity;
+    double sigmaBA = _params.accelerometerRandomWalk;
+    double sigmaBAD = sqrt(- sigmaBA * sigmaBA * tauA / 2.0 *
+      (exp(-2.0 * _dt / tauA) - 1.0));
+    double phiAD = exp(-1.0 / tauA * _dt);
+    this->AddNoiseModel("bad", sigmaBAD);
+    this->AddNoiseModel("ad", sigmaAD);
+    this->accelerometerBias = phiAD * this->accelerometerBias +
+      ignition::math::Vector3d(this->Gaussian("bad", _noiseAmp),
+        this->Gaussian("bad", _noiseAmp), this->Gaussian("bad", _noiseAmp));
+    _linAcc = _linAcc + this->accelerometerBias +
+      ignition::math::Vector3d(this->Gaussian("ad", _noiseAmp),
+        this->Gaussian("ad", _noiseAmp), this->Gaussian("ad", _noiseAmp));
+
+    double scale = 0.5 * _params.orientationNoise;
+    this->AddNoiseModel("orientation_noise_density", 1.0);
+    ignition::math::Quaterniond error(1.0,
+      this->Gaussian("orientation_noise_density", scale),
+      this->Gaussian("orientation_noise_density", scale),
+      this->Gaussian("orientation_noise_density", scale));
+    error.Normalize();
+    _orientation = _orientation * error;
+  }
+
+  private: void AddNoiseModel(const std::string& _name, double _sigma)
+  {
+    if (!this->noiseModels.count(_name))
+      this->noiseModels[_name] = std::normal_distribution<double>(0.0, _sigma);
+  }
+
+  private: double Gaussian(const std::string& _name, double _amp)
+  {
+    return _amp * this->noiseModels[_name](this->rndGen);
+  }
+
+  private: std::default_random_engine rndGen;
+  private: std::map<std::string, std::normal_distribution<double>>
+    noiseModels;
+  private: ignition::math::Vector3d gyroscopeBias;
+  private: ignition::math::Vector3d accelerometerBias;
+};
+
+/// \brief Reference implementation of the ideal measurements and the Gazebo
+/// message, as the IMU plugin computed them on every update before
+void OldIMUUpdate(const LinkState& _link,
+  const ignition::math::Pose3d& _referenceFrame,
+  const ignition::math::Vector3d& _gravityWorld, bool _enableLocalNEDFrame,
+  const ignition::math::Pose3d& _localNEDFrame,
+  const gazebo::IMUParameters& _params, sensor_msgs::msgs::Imu& _msg,
+  OldIMUNoise* _noise = nullptr, double _dt = 0.0,
+  sensor_msgs::Imu* _rosMsg = nullptr)
+{
+  ignition::math::Pose3d worldLinkPose = _link.pose;
+  ignition::math::Vector3d bodyAngVel = _link.angVel;
+  ignition::math::Vector3d bodyLinAcc = _link.linAcc;
+
+  worldLinkPose.Pos() = worldLinkPose.Pos() - _referenceFrame.Pos();
+  worldLinkPose.Pos() = _referenceFrame.Rot().RotateVectorReverse(
+    worldLinkPose.Pos());
+  worldLinkPose.Rot() *= _referenceFrame.Rot().Inverse();
+
+  ignition::math::Vector3d gravityBody =
+    worldLinkPose.Rot().RotateVectorReverse(_gravityWorld);
+
+  if (_enableLocalNEDFrame)
+  {
+    bodyAngVel = _localNEDFrame.Rot().RotateVector(bodyAngVel);
+    bodyLinAcc = _localNEDFrame.Rot().RotateVector(bodyLinAcc);
+    gravityBody = _localNEDFrame.Rot().RotateVector(gravityBody);
+  }
+
+  ignition::math::Vector3d measLinearAcc = bodyLinAcc - gravityBody;
+  ignition::math::Vector3d measAngularVel = bodyAngVel;
+  ignition::math::Quaterniond measOrientation = worldLinkPose.Rot();
+
+  if (_noise)
+  {
+    _noise->Apply(measLinearAcc, measAngularVel, measOrientation, _dt,
+                  _params, 1.0);
+  }
+  if (_rosMsg)
+  {
+    _rosMsg->orientation.x = measOrientation.X();
+    _rosMsg->orientation.y = measOrientation.Y();
+    _rosMsg->orientation.z = measOrientation.Z();
+    _rosMsg->orientation.w = measOrientation.W();
+    _rosMsg->linear_acceleration.x = measLinearAcc.X();
+    _rosMsg->linear_acceleration.y = measLinearAcc.Y();
+    _rosMsg->linear_acceleration.z = measLinearAcc.Z();
+    _rosMsg->angular_velocity.x = measAngularVel.X();
+    _rosMsg->angular_velocity.y = measAngularVel.Y();
+    _rosMsg->angular_velocity.z = measAngularVel.Z();
+  }
+
+  sensor_msgs::msgs::Imu imuGazeboMessage;
+  for (int i = 0; i < 9; i++)
+  {
+    if (i == 0 || i == 4 || i == 8)
+    {
+      imuGazeboMessage.add_angular_velocity_covariance(
+        _params.gyroscopeNoiseDensity * _params.gyroscopeNoiseDensity);
+      imuGazeboMessage.add_orientation_covariance(-1.0);
+      imuGazeboMessage.add_linear_acceleration_covariance(
+        _params.accelerometerNoiseDensity *
+        _params.accelerometerNoiseDensity);
+    }
+    else
+    {
+      imuGazeboMessage.add_angular_velocity_covariance(0.0);
+      imuGazeboMessage.add_orientation_covariance(-1.0);
+      imuGazeboMessage.add_linear_acceleration_covariance(0.0);
+    }
+  }
+
+  gazebo::msgs::Quaternion * orientation = new gazebo::msgs::Quaternion();
+  orientation->set_x(measOrientation.X());
+  orientation->set_y(measOrientation.Y());
+  orientation->set_z(measOrientation.Z());
+  orientation->set_w(measOrientation.W());
+
+  gazebo::msgs::Vector3d * linAcc = new gazebo::msgs::Vector3d();
+  linAcc->set_x(measLinearAcc.X());
+  linAcc->set_y(measLinearAcc.Y());
+  linAcc->set_z(measLinearAcc.Z());
+
+  gazebo::msgs::Vector3d * angVel = new gazebo::msgs::Vector3d();
+  angVel->set_x(measAngularVel.X());
+  angVel->set_y(measAngularVel.Y());
+  angVel->set_z(measAngularVel.Z());
+
+  imuGazeboMessage.set_allocated_orientation(orientation);
+  imuGazeboMessage.set_allocated_linear_acceleration(linAcc);
+  imuGazeboMessage.set_allocated_angular_velocity(angVel);
+
+  // The message used to go out of scope after being published
+  _msg.Swap(&imuGazeboMessage);
+}
+
+/// \brief Gives the test access to the update steps of the IMU plugin
+/// without loading a model
+class TestIMUROSPlugin : public gazebo::IMUROSPlugin
+{
+  public: void Configure(const ignition::math::Pose3d& _referenceFrame,
+                         const ignition::math::Vector3d& _gravityWorld,
+                         bool _enableLocalNEDFrame)
+  {
+    this->referenceRotInverse = _referenceFrame.Rot().Inverse();
+    this->isReferenceRotInit = true;
+    this->gravityWorld = _gravityWorld;
+    this->enableLocalNEDFrame = _enableLocalNEDFrame;
+    this->gazeboMsgEnabled = true;
+    this->noiseAmp = 1.0;
+    this->InitNoiseModels();
+    this->InitGazeboMessage();
+  }
+
+  /// \brief Everything OnUpdate does once the link state is read, except
+  /// publishing
+  public: void FullUpdate(const LinkState& _link, double _dt,
+                          const gazebo::common::Time& _simTime)
+  {
+    this->UpdateMeasurement(_link.pose.Rot(), _link.angVel, _link.linAcc,
+      _dt, _simTime);
+  }
+
+  public: const sensor_msgs::Imu& ROSMessage() const
+  {
+    return this->imuROSMessage;
+  }
+
+  public: void Update(const LinkState& _link)
+  {
+    this->ComputeMeasurement(_link.pose.Rot(), _link.angVel, _link.linAcc);
+    this->FillGazeboMessage();
+  }
+
+  public: const sensor_msgs::msgs::Imu& Message() const
+  {
+    return this->imuGazeboMessage;
+  }
+
+  public: const gazebo::IMUParameters& Parameters() const
+  {
+    return this->imuParameters;
+  }
+
+  public: const ignition::math::Pose3d& LocalNEDFrame() const
+  {
+    return this->localNEDFrame;
+  }
+};
+
+void ExpectSameMessage(const sensor_msgs::msgs::Imu& _expected,
+                       const sensor_msgs::msgs::Imu& _actual)
+{
+  EXPECT_NEAR(_expected.orientation().x(), _actual.orientation().x(), 1e-9);
+  EXPECT_NEAR(_expected.orientation().y(), _actual.orientation().y(), 1e-9);
+  EXPECT_NEAR(_expected.orientation().z(), _actual.orientation().z(), 1e-9);
+  EXPECT_NEAR(_expected.orientation().w(), _actual.orientation().w(), 1e-9);
+  EXPECT_NEAR(_expected.linear_acceleration().x(),
+              _actual.linear_acceleration().x(), 1e-9);
+  EXPECT_NEAR(_expected.linear_acceleration().y(),
+              _actual.linear_acceleration().y(), 1e-9);
+  EXPECT_NEAR(_expected.linear_acceleration().z(),
+              _actual.linear_acceleration().z(), 1e-9);
+  EXPECT_NEAR(_expected.angular_velocity().x(),
+              _actual.angular_velocity().x(), 1e-9);
+  EXPECT_NEAR(_expected.angular_velocity().y(),
+              _actual.angular_velocity().y(), 1e-9);
+  EXPECT_NEAR(_expected.angular_velocity().z(),
+              _actual.angular_velocity().z(), 1e-9);
+  ASSERT_EQ(9, _actual.angular_velocity_covariance_size());
+  ASSERT_EQ(9, _actual.orientation_covariance_size());
+  ASSERT_EQ(9, _actual.linear_acceleration_covariance_size());
+  for (int i = 0; i < 9; i++)
+  {
+    EXPECT_EQ(_expected.angular_velocity_covariance(i),
+              _actual.angular_velocity_covariance(i));
+    EXPECT_EQ(_expected.orientation_covariance(i),
+              _actual.orientation_covariance(i));
+    EXPECT_EQ(_expected.linear_acceleration_covariance(i),
+              _actual.linear_acceleration_covariance(i));
+  }
+}
+
+TEST(IMUROSPlugin, UpdateCost)
+{
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> angle(-M_PI, M_PI);
+  std::uniform_real_distribution<double> value(-5.0, 5.0);
+
+  std::vector<LinkState> states(1000);
+  for (LinkState& state : states)
+  {
+    state.pose = ignition::math::Pose3d(value(gen), value(gen), value(gen),
+      angle(gen), angle(gen) / 2, angle(gen));
+    state.angVel.Set(value(gen), value(gen), value(gen));
+    state.linAcc.Set(value(gen), value(gen), value(gen));
+  }
+  ignition::math::Vector3d gravity(0, 0, -9.81);
+  ignition::math::Pose3d referenceFrame(1, 2, 3, 0.1, -0.2, 0.3);
+
+  for (bool ned : {false, true})
+  {
+    TestIMUROSPlugin imu;
+    imu.Configure(referenceFrame, gravity, ned);
+
+    // The new update path must give the same message as the old one
+    sensor_msgs::msgs::Imu oldMsg;
+    for (const LinkState& state : states)
+    {
+      OldIMUUpdate(state, referenceFrame, gravity, ned, imu.LocalNEDFrame(),
+                   imu.Parameters(), oldMsg);
+      imu.Update(state);
+      ExpectSameMessage(oldMsg, imu.Message());
+    }
+
+    // Benchmark: ns per update of the old and the new path
+    const int reps = 200;
+    double sumOld = 0.0, sumNew = 0.0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; r++)
+    {
+      for (const LinkState& state : states)
+      {
+        OldIMUUpdate(state, referenceFrame, gravity, ned,
+                     imu.LocalNEDFrame(), imu.Parameters(), oldMsg);
+        sumOld += oldMsg.linear_acceleration().x();
+      }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; r++)
+    {
+      for (const LinkState& state : states)
+      {
+        imu.Update(state);
+        sumNew += imu.Message().linear_acceleration().x();
+      }
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    double n = static_cast<double>(reps * states.size());
+    std::cout << "IMU update (" << (ned ? "local NED" : "ENU")
+              << "): old "
+              << std::chrono::duration<double, std::nano>(t1 - t0).count() / n
+              << " ns/update, new "
+              << std::chrono::duration<double, std::nano>(t2 - t1).count() / n
+              << " ns/update" << std::endl;
+    EXPECT_NEAR(sumOld, sumNew, 1e-6 * std::abs(sumOld) + 1e-6);
+  }
+}
+
+TEST(IMUROSPlugin, FullUpdateCost)
+{
+  // Measurement, noise, bias drift and both messages, at a 200 Hz rate.
+  // Only reading the link state and publishing are left out, they need a
+  // world and a ROS master.
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<double> angle(-M_PI, M_PI);
+  std::uniform_real_distribution<double> value(-5.0, 5.0);
+
+  std::vector<LinkState> states(1000);
+  for (LinkState& state : states)
+  {
+    state.pose = ignition::math::Pose3d(value(gen), value(gen), value(gen),
+      angle(gen), angle(gen) / 2, angle(gen));
+    state.angVel.Set(value(gen), value(gen), value(gen));
+    state.linAcc.Set(value(gen), value(gen), value(gen));
+  }
+  ignition::math::Vector3d gravity(0, 0, -9.81);
+  ignition::math::Pose3d referenceFrame(1, 2, 3, 0.1, -0.2, 0.3);
+  const double dt = 0.005;
+  gazebo::common::Time simTime;
+
+  for (bool ned : {false, true})
+  {
+    TestIMUROSPlugin imu;
+    imu.Configure(referenceFrame, gravity, ned);
+    OldIMUNoise oldNoise;
+    sensor_msgs::msgs::Imu oldMsg;
+    sensor_msgs::Imu oldROSMsg;
+
+    // Noisy messages stay close to the ideal ones, and both messages of
+    // one update carry the same noisy sample
+    sensor_msgs::msgs::Imu idealMsg;
+    for (const LinkState& state : states)
+    {
+      OldIMUUpdate(state, referenceFrame, gravity, ned, imu.LocalNEDFrame(),
+                   imu.Parameters(), idealMsg);
+      imu.FullUpdate(state, dt, simTime);
+      EXPECT_NEAR(idealMsg.linear_acceleration().x(),
+                  imu.Message().linear_acceleration().x(), 1.0);
+      EXPECT_NEAR(idealMsg.angular_velocity().z(),
+                  imu.Message().angular_velocity().z(), 1.0);
+      EXPECT_EQ(imu.Message().linear_acceleration().x(),
+                imu.ROSMessage().linear_acceleration.x);
+      EXPECT_EQ(imu.Message().angular_velocity().z(),
+                imu.ROSMessage().angular_velocity.z);
+    }
+
+    // Benchmark: ns per full update of the old and the new path
+    const int reps = 200;
+    double sumOld = 0.0, sumNew = 0.0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; r++)
+    {
+      for (const LinkState& state : states)
+      {
+        OldIMUUpdate(state, referenceFrame, gravity, ned,
+                     imu.LocalNEDFrame(), imu.Parameters(), oldMsg,
+                     &oldNoise, dt, &oldROSMsg);
+        sumOld += oldROSMsg.linear_acceleration.x;
+      }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; r++)
+    {
+      for (const LinkState& state : states)
+      {
+        imu.FullUpdate(state, dt, simTime);
+        sumNew += imu.ROSMessage().linear_acceleration.x;
+      }
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    double n = static_cast<double>(reps * states.size());
+    std::cout << "IMU full update with noise ("
+              << (ned ? "local NED" : "ENU") << "): old "
+              << std::chrono::duration<double, std::nano>(t1 - t0).count() / n
+              << " ns/update, new "
+              << std::chrono::duration<double, std::nano>(t2 - t1).count() / n
+              << " ns/update" << std::endl;
+    EXPECT_FALSE(std::isnan(sumOld + sumNew));
+  }
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  // The plugin's TF broadcaster needs an initialized ROS node
+  ros::init(argc, argv, "test_imu_ros_plugin");
+  return RUN_ALL_TESTS();
+}
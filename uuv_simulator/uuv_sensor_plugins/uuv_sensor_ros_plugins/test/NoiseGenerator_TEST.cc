@@ -0,0 +1,183 @@
+// Copyright (c) 2016 The UUV Simulator Authors.
+// All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>
+#include <vector>
+#include <gtest/gtest.h>
+#include <uuv_sensor_ros_plugins/NoiseGenerator.hh>
+
+/// \brief Mean and variance of a set of samples
+void Moments(const std::vector<double> &_x, double &_mean, double &_var)
+{
+  _mean = 0.0;
+  for (double x : _x)
+    _mean += x;
+  _mean /= _x.size();
+  _var = 0.0;
+  for (double x : _x)
+    _var += (x - _mean) * (x - _mean);
+  _var /= _x.size() - 1;
+}
+
+TEST(NoiseGenerator, SameSeedSameStream)
+{
+  gazebo::NoiseGenerator a(42), b(42), c(43);
+  gazebo::NoiseGenerator::Model ma = a.AddGaussMarkov(0.1, 5.0);
+  gazebo::NoiseGenerator::Model mb = b.AddGaussMarkov(0.1, 5.0);
+  c.AddGaussMarkov(0.1, 5.0);
+
+  // Across several blocks and all kinds of samples
+  int differing = 0;
+  for (int i = 0; i < 1000; i++)
+  {
+    double x = a.Normal();
+    EXPECT_EQ(x, b.Normal());
+    if (x != c.Normal())
+      differing++;
+    EXPECT_EQ(a.Uniform(), b.Uniform());
+    ignition::math::Vector3d va = a.Sample3(ma, 1.0, 0.01);
+    ignition::math::Vector3d vb = b.Sample3(mb, 1.0, 0.01);
+    EXPECT_EQ(va, vb);
+  }
+  EXPECT_GT(differing, 990);
+
+  // Seed() restarts the stream
+  a.Seed(42);
+  gazebo::NoiseGenerator fresh(42);
+  for (int i = 0; i < 600; i++)
+    EXPECT_EQ(fresh.Normal(), a.Normal());
+
+  // Streams of plugins differ by name and are reproducible
+  EXPECT_EQ(gazebo::NoiseGenerator::StreamSeed(7, "/rexrov/imu"),
+            gazebo::NoiseGenerator::StreamSeed(7, "/rexrov/imu"));
+  EXPECT_NE(gazebo::NoiseGenerator::StreamSeed(7, "/rexrov/imu"),
+            gazebo::NoiseGenerator::StreamSeed(7, "/rexrov/dvl"));
+  EXPECT_NE(gazebo::NoiseGenerator::StreamSeed(7, "/rexrov/imu"),
+            gazebo::NoiseGenerator::StreamSeed(8, "/rexrov/imu"));
+}
+
+TEST(NoiseGenerator, WhiteNoiseMoments)
+{
+  const int n = 400000;
+  gazebo::NoiseGenerator noise(1);
+  gazebo::NoiseGenerator::Model white = noise.AddWhite(0.5);
+  gazebo::NoiseGenerator::Model density = noise.AddWhiteDensity(0.02);
+
+  std::vector<double> normal(n), scaled(n), fromDensity(n), uniform(n);
+  for (int i = 0; i < n; i++)
+  {
+    normal[i] = noise.Normal();
+    scaled[i] = noise.Sample(white, 2.0);
+    fromDensity[i] = noise.Sample(density, 1.0, 0.01);
+    uniform[i] = noise.Uniform();
+    ASSERT_GE(uniform[i], 0.0);
+    ASSERT_LT(uniform[i], 1.0);
+  }
+
+  // Tolerances of about five standard errors: sigma / sqrt(n) for the
+  // mean, sigma^2 * sqrt(2 / n) for the variance of a normal distribution
+  double mean, var;
+  Moments(normal, mean, var);
+  EXPECT_NEAR(0.0, mean, 0.008);
+  EXPECT_NEAR(1.0, var, 0.012);
+
+  // Sample() scales by amplitude and sigma
+  Moments(scaled, mean, var);
+  EXPECT_NEAR(0.0, mean, 0.008);
+  EXPECT_NEAR(1.0, var, 0.012);
+
+  // A density of 0.02 / sqrt(Hz) at 100 Hz is a sigma of 0.2
+  Moments(fromDensity, mean, var);
+  EXPECT_NEAR(0.0, mean, 0.0016);
+  EXPECT_NEAR(0.04, var, 0.0005);
+
+  Moments(uniform, mean, var);
+  EXPECT_NEAR(0.5, mean, 0.003);
+  EXPECT_NEAR(1.0 / 12.0, var, 0.001);
+}
+
+TEST(NoiseGenerator, GaussMarkovTimeConstant)
+{
+  const double sigma = 0.1;
+  const double tau = 2.0;
+  const double dt = 0.01;
+  gazebo::NoiseGenerator noise(3);
+  gazebo::NoiseGenerator::Model drift = noise.AddGaussMarkov(sigma, tau);
+
+  // Without driving noise the state decays by exp(-t / tau)
+  ignition::math::Vector3d start;
+  for (int i = 0; i < 1000; i++)
+    start = noise.Sample3(drift, 1.0, dt);
+  ignition::math::Vector3d state;
+  for (int i = 0; i < 200; i++)
+    state = noise.Sample3(drift, 0.0, dt);
+  for (int k = 0; k < 3; k++)
+    EXPECT_NEAR(start[k] * std::exp(-1.0), state[k], 1e-12) << "axis " << k;
+
+  // The stationary variance is sigma^2 * tau / 2 and the autocorrelation
+  // after tau is exp(-1), independent of the step size
+  for (double step : {0.01, 0.5})
+  {
+    gazebo::NoiseGenerator stream(4);
+    gazebo::NoiseGenerator::Model model = stream.AddGaussMarkov(sigma, tau);
+    int lag = static_cast<int>(std::round(tau / step));
+    // 4000 correlation times, after one to forget the zero start
+    int n = static_cast<int>(std::round(4000 * tau / step));
+    for (int i = 0; i < lag; i++)
+      stream.Sample3(model, 1.0, step);
+    std::vector<double> x;
+    for (int i = 0; i < n; i++)
+    {
+      ignition::math::Vector3d v = stream.Sample3(model, 1.0, step);
+      x.push_back(v.X());
+      x.push_back(v.Y());
+      x.push_back(v.Z());
+    }
+
+    double mean, var;
+    Moments(x, mean, var);
+    double cov = 0.0;
+    for (size_t i = 0; i + 3 * lag < x.size(); i++)
+      cov += (x[i] - mean) * (x[i + 3 * lag] - mean);
+    cov /= x.size() - 3 * lag;
+
+    EXPECT_NEAR(sigma * sigma * tau / 2.0, var, 0.1 * sigma * sigma * tau / 2.0)
+      << "dt=" << step;
+    EXPECT_NEAR(std::exp(-1.0), cov / var, 0.05) << "dt=" << step;
+  }
+
+  // tau <= 0 is a random walk, its variance grows as sigma^2 * t
+  std::vector<double> walk;
+  for (int run = 0; run < 2000; run++)
+  {
+    gazebo::NoiseGenerator stream(100 + run);
+    gazebo::NoiseGenerator::Model model = stream.AddGaussMarkov(sigma, 0.0);
+    ignition::math::Vector3d v;
+    for (int i = 0; i < 100; i++)
+      v = stream.Sample3(model, 1.0, dt);
+    walk.push_back(v.X());
+    walk.push_back(v.Y());
+    walk.push_back(v.Z());
+  }
+  double mean, var;
+  Moments(walk, mean, var);
+  EXPECT_NEAR(sigma * sigma * 1.0, var, 0.1 * sigma * sigma);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
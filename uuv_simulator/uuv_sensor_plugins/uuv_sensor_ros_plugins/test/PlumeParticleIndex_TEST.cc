@@ -0,0 +1,234 @@
+// Copyright (c) 2016 The UUV Simulator Authors.
+// All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+#include <uuv_sensor_ros_plugins/PlumeParticleIndex.hh>
+
+/// \brief Smoothing parameter of a particle, as the CPC sensor computes it
+double SmoothingParameter(const sensor_msgs::PointCloud &_cloud, size_t _i,
+  double _smoothingLength, double _gamma)
+{
+  double age = _cloud.channels.empty() ? 0.0 :
+    _cloud.header.stamp.toSec() - _cloud.channels[0].values[_i];
+  return std::pow(std::pow(_smoothingLength, 2.0 / 3) + _gamma * age, 1.5);
+}
+
+/// \brief Squared distance between a particle and a position
+double DistanceSq(const sensor_msgs::PointCloud &_cloud, size_t _i,
+  const ignition::math::Vector3d &_pos)
+{
+  double dx = _pos.X() - _cloud.points[_i].x;
+  double dy = _pos.Y() - _cloud.points[_i].y;
+  double dz = _pos.Z() - _cloud.points[_i].z;
+  return dx * dx + dy * dy + dz * dz;
+}
+
+/// \brief O(N^2) reference: checks every particle of the cloud
+std::vector<size_t> BruteForceNeighbors(const sensor_msgs::PointCloud &_cloud,
+  const ignition::math::Vector3d &_pos, double _smoothingLength,
+  double _gamma)
+{
+  std::vector<size_t> indices;
+  for (size_t i = 0; i < _cloud.points.size(); i++)
+  {
+    double h = SmoothingParameter(_cloud, i, _smoothingLength, _gamma);
+    if (DistanceSq(_cloud, i, _pos) < 4.0 * h * h)
+      indices.push_back(i);
+  }
+  return indices;
+}
+
+/// \brief O(N^2) reference of the kernel sum
+double BruteForceConcentration(const sensor_msgs::PointCloud &_cloud,
+  const ignition::math::Vector3d &_pos, double _smoothingLength,
+  double _gamma)
+{
+  double total = 0.0;
+  for (size_t i : BruteForceNeighbors(_cloud, _pos, _smoothingLength, _gamma))
+  {
+    double h = SmoothingParameter(_cloud, i, _smoothingLength, _gamma);
+    double q = std::sqrt(DistanceSq(_cloud, i, _pos)) / h;
+    double w = q < 1.0 ? 4.0 - 6.0 * q * q + 3.0 * q * q * q :
+      std::pow(2.0 - q, 3);
+    total += w / (4.0 * M_PI * h * h * h);
+  }
+  return total;
+}
+
+/// \brief Compares the index with the brute-force search at _queries
+void ExpectMatchesBruteForce(const std::string &_topic,
+  const sensor_msgs::PointCloud::ConstPtr &_cloud,
+  const std::vector<ignition::math::Vector3d> &_queries,
+  double _smoothingLength, double _gamma)
+{
+  std::shared_ptr<gazebo::PlumeParticleIndex> index =
+    gazebo::PlumeParticleIndex::Get(_topic, _smoothingLength, _gamma);
+  std::vector<size_t> neighbors;
+  size_t total = 0;
+  for (const ignition::math::Vector3d &pos : _queries)
+  {
+    index->Neighbors(_cloud, pos, neighbors);
+    std::sort(neighbors.begin(), neighbors.end());
+    std::vector<size_t> expected = BruteForceNeighbors(*_cloud, pos,
+      _smoothingLength, _gamma);
+    ASSERT_EQ(expected, neighbors) << "query at " << pos;
+    total += expected.size();
+
+    double concentration = BruteForceConcentration(*_cloud, pos,
+      _smoothingLength, _gamma);
+    EXPECT_NEAR(concentration, index->Concentration(_cloud, pos),
+      1e-9 * std::max(concentration, 1.0)) << "query at " << pos;
+  }
+  EXPECT_EQ(_cloud->points.size(), index->Size());
+  // The queries must actually hit particles
+  EXPECT_GT(total, _queries.size());
+}
+
+/// \brief Random positions in the box [_lower, _upper]^3
+std::vector<ignition::math::Vector3d> RandomPositions(std::mt19937 &_rng,
+  size_t _n, double _lower, double _upper)
+{
+  std::uniform_real_distribution<double> uniform(_lower, _upper);
+  std::vector<ignition::math::Vector3d> positions;
+  for (size_t i = 0; i < _n; i++)
+    positions.push_back(ignition::math::Vector3d(uniform(_rng),
+      uniform(_rng), uniform(_rng)));
+  return positions;
+}
+
+TEST(PlumeParticleIndex, NeighborsOnCellBoundaries)
+{
+  // Without aging every kernel support is 2 * 0.5 = 1 m, and with more than
+  // one particle per cubic meter in [0, 10]^3 the cells are 1 m cubes with
+  // a corner at the origin. Particles and queries on the integer lattice
+  // lie on cell faces, edges and corners, and lattice neighbors are exactly
+  // one support apart.
+  std::mt19937 rng(11);
+  sensor_msgs::PointCloud::Ptr cloud(new sensor_msgs::PointCloud);
+  cloud->header.stamp = ros::Time(100.0);
+  for (const ignition::math::Vector3d &pos : RandomPositions(rng, 3000, 0.0,
+    10.0))
+  {
+    geometry_msgs::Point32 p;
+    p.x = pos.X();
+    p.y = pos.Y();
+    p.z = pos.Z();
+    cloud->points.push_back(p);
+  }
+  for (int x = 0; x <= 10; x++)
+    for (int y = 0; y <= 10; y++)
+      for (int z = 0; z <= 10; z++)
+      {
+        geometry_msgs::Point32 p;
+        p.x = x;
+        p.y = y;
+        p.z = z;
+        cloud->points.push_back(p);
+      }
+
+  std::vector<ignition::math::Vector3d> queries = RandomPositions(rng, 200,
+    -0.5, 10.5);
+  for (double x : {0.0, 0.5, 1.0, 4.0, 9.5, 10.0})
+    for (double y : {0.0, 1.0, 5.0, 5.5, 10.0})
+      for (double z : {0.0, 3.0, 3.5, 10.0})
+        queries.push_back(ignition::math::Vector3d(x, y, z));
+  // Outside of the grid, clamped to the border cells
+  queries.push_back(ignition::math::Vector3d(-0.7, 5.0, 5.0));
+  queries.push_back(ignition::math::Vector3d(10.9, 10.2, -0.3));
+  queries.push_back(ignition::math::Vector3d(30.0, 5.0, 5.0));
+
+  ExpectMatchesBruteForce("/plume/boundaries", cloud, queries, 0.5, 0.0);
+}
+
+TEST(PlumeParticleIndex, NeighborsWithAging)
+{
+  // Particles released over 60 s from a moving source, so the kernel
+  // supports differ and the cloud is elongated
+  std::mt19937 rng(3);
+  std::normal_distribution<double> spread(0.0, 1.5);
+  std::uniform_real_distribution<double> release(0.0, 60.0);
+  sensor_msgs::PointCloud::Ptr cloud(new sensor_msgs::PointCloud);
+  cloud->header.stamp = ros::Time(60.0);
+  cloud->channels.resize(1);
+  for (int i = 0; i < 4000; i++)
+  {
+    double t = release(rng);
+    geometry_msgs::Point32 p;
+    p.x = 0.5 * t + spread(rng);
+    p.y = spread(rng);
+    p.z = -10.0 + 0.5 * spread(rng);
+    cloud->points.push_back(p);
+    cloud->channels[0].values.push_back(t);
+  }
+
+  std::vector<ignition::math::Vector3d> queries;
+  for (int i = 0; i < 300; i++)
+  {
+    const geometry_msgs::Point32 &p = cloud->points[i * 13];
+    queries.push_back(ignition::math::Vector3d(p.x, p.y, p.z));
+  }
+  for (const ignition::math::Vector3d &pos : RandomPositions(rng, 100, -5.0,
+    35.0))
+    queries.push_back(ignition::math::Vector3d(pos.X(), 0.1 * pos.Y(),
+      -10.0 + 0.05 * pos.Z()));
+
+  ExpectMatchesBruteForce("/plume/aging", cloud, queries, 0.3, 0.05);
+}
+
+TEST(PlumeParticleIndex, NewCloudRebuildsIndex)
+{
+  std::mt19937 rng(7);
+  std::shared_ptr<gazebo::PlumeParticleIndex> index =
+    gazebo::PlumeParticleIndex::Get("/plume/rebuild", 1.0, 0.0);
+  ignition::math::Vector3d origin(0.0, 0.0, 0.0);
+  std::vector<size_t> neighbors;
+
+  for (int k = 0; k < 3; k++)
+  {
+    sensor_msgs::PointCloud::Ptr cloud(new sensor_msgs::PointCloud);
+    cloud->header.seq = k;
+    cloud->header.stamp = ros::Time(k);
+    for (const ignition::math::Vector3d &pos : RandomPositions(rng,
+      100 * (k + 1), -3.0, 3.0))
+    {
+      geometry_msgs::Point32 p;
+      p.x = pos.X();
+      p.y = pos.Y();
+      p.z = pos.Z();
+      cloud->points.push_back(p);
+    }
+
+    index->Neighbors(cloud, origin, neighbors);
+    std::sort(neighbors.begin(), neighbors.end());
+    EXPECT_EQ(BruteForceNeighbors(*cloud, origin, 1.0, 0.0), neighbors);
+    EXPECT_EQ(cloud->points.size(), index->Size());
+  }
+
+  // Sensors with the same topic and kernel share the index
+  EXPECT_EQ(index, gazebo::PlumeParticleIndex::Get("/plume/rebuild", 1.0,
+    0.0));
+  EXPECT_NE(index, gazebo::PlumeParticleIndex::Get("/plume/rebuild", 2.0,
+    0.0));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
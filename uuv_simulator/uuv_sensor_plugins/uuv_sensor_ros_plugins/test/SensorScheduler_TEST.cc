@@ -0,0 +1,220 @@
+// Copyright (c) 2016 The UUV Simulator Authors.
+// All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <gtest/gtest.h>
+#include <uuv_sensor_ros_plugins/SensorScheduler.hh>
+
+/// \brief Physics step size of the tests [s]
+static const double kStep = 0.001;
+
+/// \brief Runs the physics steps after _from up to and including _to
+void Step(gazebo::SensorScheduler &_scheduler, double _from, double _to,
+  double _step = kStep)
+{
+  int steps = static_cast<int>(std::round((_to - _from) / _step));
+  for (int i = 1; i <= steps; i++)
+  {
+    gazebo::common::UpdateInfo info;
+    info.simTime = gazebo::common::Time(_from + i * _step);
+    _scheduler.Update(info);
+  }
+}
+
+/// \brief Runs a single update at _time
+void Jump(gazebo::SensorScheduler &_scheduler, double _time)
+{
+  Step(_scheduler, _time - kStep, _time);
+}
+
+/// \brief Callback recording the simulation times it was called at
+gazebo::SensorScheduler::Callback Recorder(std::vector<double> &_times)
+{
+  return [&_times](const gazebo::common::UpdateInfo &_info)
+  {
+    _times.push_back(_info.simTime.Double());
+  };
+}
+
+/// \brief Checks that _times are the expected call times
+void ExpectTimes(const std::vector<double> &_expected,
+  const std::vector<double> &_times)
+{
+  ASSERT_EQ(_expected.size(), _times.size());
+  for (size_t i = 0; i < _expected.size(); i++)
+    EXPECT_NEAR(_expected[i], _times[i], 1e-9) << "call " << i;
+}
+
+TEST(SensorScheduler, CallsSensorsWhenDue)
+{
+  gazebo::SensorScheduler scheduler(kStep, 0.0);
+  std::vector<double> fast, slow, everyStep;
+  scheduler.Add(0.01, Recorder(fast));
+  scheduler.Add(0.025, Recorder(slow));
+  // Shorter than a step, so called on every step
+  scheduler.Add(0.0001, Recorder(everyStep));
+  EXPECT_EQ(3u, scheduler.Size());
+
+  Step(scheduler, 0.0, 0.1);
+  ExpectTimes({0.01, 0.02, 0.03, 0.04, 0.05, 0.06, 0.07, 0.08, 0.09, 0.1},
+    fast);
+  ExpectTimes({0.025, 0.05, 0.075, 0.1}, slow);
+  EXPECT_EQ(100u, everyStep.size());
+}
+
+TEST(SensorScheduler, PeriodCountsFromLastCall)
+{
+  // With 3 ms steps a 10 ms sensor is called at the first step at least
+  // one period after its last call, as EnableMeasurement() requires
+  gazebo::SensorScheduler scheduler(0.003, 0.0);
+  std::vector<double> times;
+  scheduler.Add(0.01, Recorder(times));
+  Step(scheduler, 0.0, 0.06, 0.003);
+  ExpectTimes({0.012, 0.024, 0.036, 0.048, 0.06}, times);
+}
+
+TEST(SensorScheduler, WorldResetRestartsPeriods)
+{
+  gazebo::SensorScheduler scheduler(kStep, 0.0);
+  std::vector<double> times;
+  scheduler.Add(0.05, Recorder(times));
+  Step(scheduler, 0.0, 0.52);
+  ASSERT_EQ(10u, times.size());
+
+  // After the reset the sensor is due one period after the new time, not
+  // at its due time in the old timeline
+  times.clear();
+  Step(scheduler, -kStep, 0.12);
+  ExpectTimes({0.05, 0.1}, times);
+}
+
+TEST(SensorScheduler, RemoveFromCallback)
+{
+  gazebo::SensorScheduler scheduler(kStep, 0.0);
+  std::vector<double> other, added;
+  int self = -1, otherId = -1;
+  int selfCalls = 0;
+  self = scheduler.Add(0.01, [&](const gazebo::common::UpdateInfo &)
+    {
+      selfCalls++;
+      // Both entries are due in this step, the other one must not be
+      // called after its removal
+      scheduler.Remove(self);
+      scheduler.Remove(otherId);
+      scheduler.Add(0.01, Recorder(added));
+    });
+  otherId = scheduler.Add(0.01, Recorder(other));
+
+  Step(scheduler, 0.0, 0.05);
+  EXPECT_EQ(1, selfCalls);
+  EXPECT_TRUE(other.empty());
+  ExpectTimes({0.02, 0.03, 0.04, 0.05}, added);
+  EXPECT_EQ(1u, scheduler.Size());
+}
+
+TEST(SensorScheduler, TimeJumpLongerThanWheel)
+{
+  gazebo::SensorScheduler scheduler(kStep, 0.0);
+  std::vector<double> fast, slow;
+  scheduler.Add(0.01, Recorder(fast));
+  // Several turns of the 1024 step wheel
+  scheduler.Add(5.0, Recorder(slow));
+  Step(scheduler, 0.0, 0.05);
+  ASSERT_EQ(5u, fast.size());
+
+  // Overdue sensors are called right after the jump
+  fast.clear();
+  Jump(scheduler, 3.0);
+  ExpectTimes({3.0}, fast);
+  EXPECT_TRUE(slow.empty());
+
+  // and then at their period again, sensors that are not due yet keep
+  // their due time even if it is more than a wheel turn away
+  fast.clear();
+  Step(scheduler, 3.0, 5.0);
+  EXPECT_EQ(200u, fast.size());
+  EXPECT_NEAR(5.0, fast.back(), 1e-9);
+  ExpectTimes({5.0}, slow);
+
+  // A jump over several due times calls a sensor once
+  slow.clear();
+  Jump(scheduler, 17.3);
+  ExpectTimes({17.3}, slow);
+  slow.clear();
+  fast.clear();
+  Step(scheduler, 17.3, 22.3);
+  ExpectTimes({22.3}, slow);
+  EXPECT_EQ(500u, fast.size());
+}
+
+TEST(SensorScheduler, Cost)
+{
+  // 800 sensors at 10 to 50 Hz on a 1 kHz step, against one world update
+  // callback per sensor comparing its own last measurement time
+  const int numSensors = 800;
+  const int steps = 10000;
+  std::vector<double> periods;
+  for (int i = 0; i < numSensors; i++)
+    periods.push_back(1.0 / (10 + i % 41));
+
+  int64_t calls = 0;
+  gazebo::SensorScheduler scheduler(kStep, 0.0);
+  for (double period : periods)
+    scheduler.Add(period, [&calls](const gazebo::common::UpdateInfo &)
+      { calls++; });
+
+  // The world update event calls every connected sensor
+  std::vector<double> lastTimes(numSensors, 0.0);
+  std::vector<gazebo::SensorScheduler::Callback> connected;
+  int64_t oldCalls = 0;
+  for (int k = 0; k < numSensors; k++)
+    connected.push_back([&, k](const gazebo::common::UpdateInfo &_info)
+      {
+        double now = _info.simTime.Double();
+        if (now - lastTimes[k] >= periods[k] - 1e-6)
+        {
+          lastTimes[k] = now;
+          oldCalls++;
+        }
+      });
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 1; i <= steps; i++)
+  {
+    gazebo::common::UpdateInfo info;
+    info.simTime = gazebo::common::Time(i * kStep);
+    for (auto &callback : connected)
+      callback(info);
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  Step(scheduler, 0.0, steps * kStep);
+  auto t2 = std::chrono::steady_clock::now();
+
+  std::cout << "800 sensors, 1 kHz: per-sensor check "
+            << std::chrono::duration<double, std::micro>(t1 - t0).count() / steps
+            << " us/step, scheduler "
+            << std::chrono::duration<double, std::micro>(t2 - t1).count() / steps
+            << " us/step" << std::endl;
+  EXPECT_EQ(oldCalls, calls);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}